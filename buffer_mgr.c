@@ -1,60 +1,250 @@
 #include <limits.h>
 #include "buffer_mgr.h"
 #include "hash_table.h"
+#include "page_cache.h"
+#include "miss_ratio.h"
 #include "storage_mgr.h"
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
+#include <pthread.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 
 /* Additional Definitions */
 
 #define PAGE_TABLE_SIZE 256
+#define CLASS_TABLE_SIZE 16
+#define CLASS_LIST_SIZE 8
+// alignment of the parts of a shared-memory segment (one cache line)
+#define SEGMENT_ALIGN 64
+// microseconds between checks while another process sets up a segment
+#define SEGMENT_WAIT 1000
+// microseconds a shared pool waits for another process's read before checking it is alive
+#define READ_WAIT 100000
+// marks an unused slot of a shared pool's page table
+#define NO_SLOT -1
 #define RC_OK 0
 
 
 typedef unsigned int TimeStamp;
-typedef struct BM_PageFrame {
-    // the frame's buffer
-    char* data;
-    TimeStamp timeStamp;
-    // the page currently occupying it
+
+// frame budget and retention priority of one page class (e.g. a table)
+typedef struct BM_PageClass {
+    int pageClass;
+    // frames the class keeps even when other classes need room
+    int reservedFrames;
+    // most frames the class may occupy (0 for no limit)
+    int maxFrames;
+    // frames of lower priority are evicted first
+    int priority;
+    // frames currently holding pages of the class
+    int numFrames;
+} BM_PageClass;
+
+// a reference to a page that names its frame directly while the page is resident (swizzled),
+// and falls back to the page number once the page is evicted (unswizzled)
+typedef struct BM_Swip {
     PageNumber pageNum;
-    // management data on the page frame
-    bool occupied;
-    int fixedCount;
     int framedIndex;
-    bool dirty; 
-} BM_PageFrame; 
+} BM_Swip;
+
 
+// the pool state every user of the frames must agree on; for a shared pool it lives in
+// the shared-memory segment next to the frames (see initSharedBufferPool)
+typedef struct BM_PoolState {
+    // poolLock guards the metadata, fileLock the page file; a page is read holding only fileLock
+    // while its frame is marked ioInProgress, other callers pinning it wait on ioDone
+    pthread_mutex_t poolLock;
+    pthread_mutex_t fileLock;
+    pthread_cond_t ioDone;
+    // increments everytime a page is accessed (used for frame's timeStamp)
+    TimeStamp timeStamp;
+    // used to treat the frames as a clock (queuedIndex does the same for FIFO)
+    int clockHand;
+    int queuedIndex;
+    // size of the dirty set
+    int numberDirty;
+    // page number where the next flushSome picks up its sweep
+    PageNumber flushCursor;
+    //statistics
+    int numberRead;
+    int numberWrite;
+} BM_PoolState;
 
+// head of a shared-memory segment, followed by the frames and the shared frame arrays
+typedef struct BM_SharedHeader {
+    // set by the process that created the segment once everything below is initialized
+    int ready;
+    int numPages;
+    int pageSize;
+    // processes attached to the pool, the last one to shut down removes the segment
+    int attached;
+    BM_PoolState state;
+} BM_SharedHeader;
 
 typedef struct BM_Metadata {
-     // an array of frames
-    BM_PageFrame *pageFrames;
-    // used to treat *pageFrames as a queue
-    // a page table that associates the a page ID with an index in pageFrames
+    // frame metadata is stored as parallel arrays indexed by frame, so a
+    // replacement scan only pulls the fields it compares through the cache
+    // the frames' buffers (one contiguous block of numPages pages)
+    char **frameData;
+    // the page currently occupying each frame
+    PageNumber *framePages;
+    // hot fields read by the victim search
+    int *fixCounts;
+    unsigned char *refBits;
+    TimeStamp *timeStamps;
+    // management data on the page frames
+    bool *occupied;
+    bool *dirty;
+    // position of each frame in the pool's dirty set (-1 when clean)
+    int *dirtyIndex;
+    // index into classes of the page held by each frame
+    int *frameClasses;
+    // scratch array for victim searches restricted by the class quotas (non-zero = not a candidate)
+    int *victimFilter;
+    // a page table that associates the a page ID with a frame index (a shared pool uses pageSlots instead)
     HT_TableHandle pageTable;
-    // increments everytime a page is accessed (used for frame's timeStamp)
-    TimeStamp timeStamp;
     // the file handle
     SM_FileHandle pageFile;
+    // indices of the frames holding dirty pages (unordered, see addDirtyFrame)
+    int *dirtyFrames;
+    // points at privateState, or into the segment for a shared pool
+    BM_PoolState *state;
+    BM_PoolState privateState;
+    // the mapped shared-memory segment (NULL for a private pool)
+    BM_SharedHeader *segment;
+    size_t segmentSize;
+    char *segmentName;
+    // pins taken through this process, a shared pool cannot see whose pins its fixCounts hold
+    int numberPinned;
+    // compressed copies of evicted pages, checked before readBlock (mgmt is NULL when disabled)
+    // a page is never both cached and in a frame: every load takes its copy out and every eviction replaces it
+    PC_CacheHandle victimCache;
+    // sampled reuse distances of pinPage, for the miss-ratio curve (mgmt is NULL when disabled)
+    MR_CurveHandle missRatio;
+    // binary log of pinPage / unpinPage / markDirty (NULL when tracing is off)
+    FILE *traceFile;
+    // page classes: pageClasses maps a page to its class id, classIndex maps a class id to its index in classes
+    HT_TableHandle pageClasses;
+    HT_TableHandle classIndex;
+    BM_PageClass *classes;
+    int numClasses;
+    int capacityClasses;
+    // set once a quota or priority is configured, until then victims are picked from every frame
+    bool classesInUse;
+    // frames whose page is being read (see BM_PoolState)
+    bool *ioInProgress;
+    // the process reading each frame of a shared pool, so that the read of a process that
+    // died is given up instead of waited for (see recoverReads)
+    pid_t *ioOwners;
+    // a shared pool's page table in the segment: linear probing over frame indices (NO_SLOT
+    // when unused), a slot holds a page if its frame does; pageSlotMask + 1 slots
+    int *pageSlots;
+    int pageSlotMask;
+    // each frame's outgoing link (e.g. to the next page of its chain) and the frame linking to
+    // each frame (-1 if none), so that pinNextPage can skip the page table (see setSwizzling)
+    BM_Swip *frameLinks;
+    int *linkParents;
+    bool swizzling;
    
     
     //statistics
-    int numberRead;
-    int numberWrite;
-    int queuedIndex;
+    int numberCacheHit;
+    int numberSwizzledPin;
 } BM_Metadata;
 
+// a dirty frame queued for write back, ordered by its page number
+typedef struct BM_FlushEntry {
+    PageNumber pageNum;
+    int framedIndex;
+} BM_FlushEntry;
+
+// a page of a pinPages batch that is not resident, ordered by its page number
+typedef struct BM_PinRequest {
+    PageNumber pageNum;
+    // the handle that asked for it and the frame it is read into
+    int handleIndex;
+    int framedIndex;
+} BM_PinRequest;
+
 /* Declaration */
-BM_PageFrame *replacementFIFO(BM_BufferPool *const bm);
-BM_PageFrame *replacementLRU(BM_BufferPool *const bm);
+// replacement policies return the index of the evicted frame or -1 if all frames are pinned
+// busy is non-zero for every frame that may not be evicted (the fix counts, or a class filter)
+int replacementFIFO(BM_BufferPool *const bm, const int *busy);
+int replacementLRU(BM_BufferPool *const bm, const int *busy);
+int replacementCLOCK(BM_BufferPool *const bm, const int *busy);
 
 
 
 // use the helper to increase the pool global timestamp & return it
 TimeStamp getTimeStamp(BM_Metadata *metadata);
-// it helps to evict frame at framedIndex & return new empty frame
-BM_PageFrame *getAfterEviction(BM_BufferPool *const bm, int framedIndex);
+// it helps to evict frame at framedIndex & return the index of the now empty frame
+int getAfterEviction(BM_BufferPool *const bm, int framedIndex);
+// free the frame metadata arrays (the page block itself is freed separately)
+void freeFrameArrays(BM_Metadata *metadata);
+// set up the pool with its frames in this process or in the segment segmentName
+RC initPool(BM_BufferPool *const bm, const char *const pageFileName, 
+		const int numPages, ReplacementStrategy strategy,
+		const char *const segmentName);
+// initialize the latches and counters of a new pool
+void initPoolState(BM_PoolState *state, int numPages, bool shared);
+// place the shared frame arrays in a segment, returns the segment size
+size_t layoutSegment(BM_Metadata *metadata, char *segment, int numPages, char **frameBlock);
+// map (creating it if needed) / unmap (removing it after the last process) a shared segment,
+// attachSegment returns the frame block or NULL on failure
+char *attachSegment(BM_Metadata *metadata, const char *const segmentName, int numPages, bool *created);
+void detachSegment(BM_Metadata *metadata, bool attached);
+// find the frame holding pageNum, returns 0 if it is resident and 1 otherwise
+int findFrame(BM_Metadata *metadata, PageNumber pageNum, int *framedIndex);
+// add / remove a frame from the dirty set, keeping the frame's dirty bool in step
+void addDirtyFrame(BM_Metadata *metadata, int framedIndex);
+void removeDirtyFrame(BM_Metadata *metadata, int framedIndex);
+// write back up to maxPages unpinned dirty pages in page order (maxPages <= 0 for all)
+RC flushDirtyFrames(BM_BufferPool *const bm, int maxPages);
+// get the index of a page class in classes, creating it if needed (-1 on failure)
+int getClassIndex(BM_Metadata *metadata, int pageClass);
+
+void traceAccess(BM_Metadata *metadata, BM_TraceOp op, PageNumber pageNum);
+// take a latch / wait on a condition, taking over a latch whose holder died (shared pool)
+// lockLatch returns 1 if the latch was taken over, 0 otherwise
+int lockLatch(pthread_mutex_t *latch);
+void waitLatch(pthread_cond_t *condition, pthread_mutex_t *latch);
+// take the pool lock, giving up the reads of a process that died holding it
+void lockPool(BM_Metadata *metadata);
+// wait on ioDone for a frame being read, a shared pool gives up reads whose process died
+void waitForReads(BM_Metadata *metadata);
+// mark a frame as being read by this process
+void startRead(BM_Metadata *metadata, int framedIndex);
+// release the frames a process that no longer exists was reading, returns how many
+int recoverReads(BM_Metadata *metadata);
+// add / remove the page held by a frame to / from the page table (before the frame changes pages)
+void mapPage(BM_Metadata *metadata, PageNumber pageNum, int framedIndex);
+void unmapPage(BM_Metadata *metadata, PageNumber pageNum);
+// write numPages frames to the consecutive pages from startPage under the file lock
+RC writeFrames(BM_Metadata *metadata, PageNumber startPage, int numPages, SM_PageHandle *pages);
+// get the busy array the replacement policy may pick a victim for a page of classIndex from
+const int *getVictimFilter(BM_BufferPool *const bm, int classIndex);
+// pinPage with the pool lock already held (it is let go while the page is read)
+RC pinPageLocked(BM_BufferPool *const bm, BM_PageHandle *const page, const PageNumber pageNum);
+// evict a victim and map pageNum to it, pinned once but with its data not yet filled in
+RC claimFrame(BM_BufferPool *const bm, const PageNumber pageNum, int *framedIndex);
+// give back a claimed frame whose data could not be filled in
+void releaseFrame(BM_Metadata *metadata, int framedIndex);
+static int comparePinRequests(const void *a, const void *b);
+// the frame a pinned handle points into (-1 if it does not point at a pinned frame of its page)
+int getFrameOf(BM_BufferPool *const bm, const BM_PageHandle *const page);
+// point the link of frame fromIndex at framedIndex / drop the links to and from a frame
+void swizzleLink(BM_Metadata *metadata, int fromIndex, PageNumber pageNum, int framedIndex);
+void unswizzleFrame(BM_Metadata *metadata, int framedIndex);
 
 /* Buffer Manager Interface Pool Handling */
 // RC initBufferPool(BM_BufferPool *const bm, const char *const pageFileName, 
@@ -101,6 +291,24 @@ BM_PageFrame *getAfterEviction(BM_BufferPool *const bm, int framedIndex);
 RC initBufferPool(BM_BufferPool *const bm, const char *const pageFileName, 
 		const int numPages, ReplacementStrategy strategy,
 		void *stratData) 
+{
+    // a private pool keeps its frames in this process
+    return initPool(bm, pageFileName, numPages, strategy, NULL);
+}
+
+RC initSharedBufferPool(BM_BufferPool *const bm, const char *const pageFileName, 
+		const int numPages, ReplacementStrategy strategy,
+		const char *const segmentName) 
+{
+    // the segment name (e.g. "/DATA.bin.pool") is what the processes sharing the pool agree on
+    if (segmentName == NULL)
+        return RC_IM_CONFIG_ERROR;
+    return initPool(bm, pageFileName, numPages, strategy, segmentName);
+}
+
+RC initPool(BM_BufferPool *const bm, const char *const pageFileName, 
+		const int numPages, ReplacementStrategy strategy,
+		const char *const segmentName) 
 {
     // Initialize metadata
     BM_Metadata *metadata = (BM_Metadata *)malloc(sizeof(BM_Metadata));
@@ -108,10 +316,16 @@ RC initBufferPool(BM_BufferPool *const bm, const char *const pageFileName,
         return RC_BUFFER_POOL_INIT_FAILED; // Failed to allocate memory for metadata
     }
     HT_TableHandle *pageTable = &(metadata->pageTable);
-    metadata->queuedIndex = numPages - 1; // Begin queue from last element
-    metadata->numberWrite = 0;
-    metadata->timeStamp = 0;
-    metadata->numberRead = 0;
+    metadata->state = &(metadata->privateState);
+    metadata->segment = NULL;
+    metadata->segmentName = NULL;
+    metadata->numberPinned = 0;
+    metadata->numberCacheHit = 0;
+    metadata->numberSwizzledPin = 0;
+    metadata->swizzling = false;
+    metadata->victimCache.mgmt = NULL;
+    metadata->missRatio.mgmt = NULL;
+    metadata->traceFile = NULL;
    
     // Open the page file
     RC result = openPageFile((char *)pageFileName, &(metadata->pageFile));
@@ -121,30 +335,96 @@ if (result != RC_OK) {
     return result; // Return the error from openPageFile
 }
 
-// Initialize page frames
-metadata->pageFrames = (BM_PageFrame *)malloc(sizeof(BM_PageFrame) * numPages);
-if (metadata->pageFrames == NULL) {
-    free(metadata);
+// Initialize the frame metadata arrays and the dirty set (it can hold at most every frame),
+// the frames and the arrays every process must see come from the segment for a shared pool
+bool created = true;
+char *frameBlock;
+metadata->frameData = (char **)malloc(sizeof(char *) * numPages);
+metadata->frameClasses = (int *)malloc(sizeof(int) * numPages);
+metadata->victimFilter = (int *)malloc(sizeof(int) * numPages);
+metadata->frameLinks = (BM_Swip *)malloc(sizeof(BM_Swip) * numPages);
+metadata->linkParents = (int *)malloc(sizeof(int) * numPages);
+metadata->classes = (BM_PageClass *)malloc(sizeof(BM_PageClass) * CLASS_LIST_SIZE);
+if (segmentName == NULL) {
+    metadata->framePages = (PageNumber *)malloc(sizeof(PageNumber) * numPages);
+    metadata->fixCounts = (int *)malloc(sizeof(int) * numPages);
+    metadata->refBits = (unsigned char *)malloc(numPages);
+    metadata->timeStamps = (TimeStamp *)malloc(sizeof(TimeStamp) * numPages);
+    metadata->occupied = (bool *)malloc(sizeof(bool) * numPages);
+    metadata->dirty = (bool *)malloc(sizeof(bool) * numPages);
+    metadata->dirtyIndex = (int *)malloc(sizeof(int) * numPages);
+    metadata->dirtyFrames = (int *)malloc(sizeof(int) * numPages);
+    metadata->ioInProgress = (bool *)malloc(sizeof(bool) * numPages);
+    metadata->ioOwners = NULL;
+    metadata->pageSlots = NULL;
+    frameBlock = (char *)malloc((size_t)PAGE_SIZE * numPages);
+} else {
+    // the other processes write pages behind this handle's back, so it must not buffer reads
+    setvbuf((FILE *)metadata->pageFile.mgmtInfo, NULL, _IONBF, 0);
+    frameBlock = attachSegment(metadata, segmentName, numPages, &created);
+}
+if (metadata->frameData == NULL || metadata->framePages == NULL || metadata->fixCounts == NULL ||
+    metadata->refBits == NULL || metadata->timeStamps == NULL || metadata->occupied == NULL ||
+    metadata->dirty == NULL || metadata->dirtyIndex == NULL || metadata->dirtyFrames == NULL ||
+    metadata->frameClasses == NULL || metadata->victimFilter == NULL || metadata->classes == NULL ||
+    metadata->ioInProgress == NULL || metadata->frameLinks == NULL || metadata->linkParents == NULL ||
+    frameBlock == NULL) {
+    if (metadata->segment != NULL) {
+        // a segment this process created never became ready, nobody else uses it yet
+        if (created)
+            shm_unlink(segmentName);
+        detachSegment(metadata, !created);
+    } else
+        free(frameBlock);
+    freeFrameArrays(metadata);
     closePageFile(&(metadata->pageFile));
+    free(metadata);
     bm->mgmtData = NULL;
-    return RC_BUFFER_POOL_INIT_FAILED; // Failed to allocate memory for page frames
+    return RC_BUFFER_POOL_INIT_FAILED; // Failed to allocate memory for page frames or attach the segment
 }
 
-// Initialize hash table
+// Initialize hash tables, the default class 0 holds every page without a class
 initHashTable(pageTable, PAGE_TABLE_SIZE);
+initHashTable(&(metadata->pageClasses), PAGE_TABLE_SIZE);
+initHashTable(&(metadata->classIndex), CLASS_TABLE_SIZE);
+metadata->numClasses = 0;
+metadata->capacityClasses = CLASS_LIST_SIZE;
+metadata->classesInUse = false;
+getClassIndex(metadata, 0);
+
+// The shared state is set up once, by whoever creates the pool
+if (created) {
+    initPoolState(metadata->state, numPages, metadata->segment != NULL);
+}
 
 // Initialize each page frame using a do-while loop
 int i = 0;
 do {
-    metadata->pageFrames[i].timeStamp = getTimeStamp(metadata);
-    metadata->pageFrames[i].framedIndex = i;
-    metadata->pageFrames[i].occupied = false;
-    metadata->pageFrames[i].data = (char *)malloc(PAGE_SIZE);
-    metadata->pageFrames[i].dirty = false;
-    metadata->pageFrames[i].fixedCount = 0;
+    metadata->frameData[i] = frameBlock + (size_t)i * PAGE_SIZE;
+    metadata->frameClasses[i] = 0;
+    metadata->frameLinks[i].pageNum = NO_PAGE;
+    metadata->frameLinks[i].framedIndex = -1;
+    metadata->linkParents[i] = -1;
+    if (created) {
+        metadata->timeStamps[i] = getTimeStamp(metadata);
+        metadata->occupied[i] = false;
+        metadata->framePages[i] = NO_PAGE;
+        metadata->dirty[i] = false;
+        metadata->dirtyIndex[i] = -1;
+        metadata->fixCounts[i] = 0;
+        metadata->refBits[i] = 0;
+        metadata->ioInProgress[i] = false;
+    }
     i++;
 } while (i < numPages);
 
+// Let the processes waiting in attachSegment in
+if (metadata->segment != NULL && created) {
+    for (i = 0; i <= metadata->pageSlotMask; i++)
+        metadata->pageSlots[i] = NO_SLOT;
+    __atomic_store_n(&(metadata->segment->ready), 1, __ATOMIC_RELEASE);
+}
+
 // Initialize buffer pool fields
 bm->pageFile = (char *)&(metadata->pageFile); // Store the page file name
 bm->numPages = numPages;
@@ -152,35 +432,50 @@ bm->strategy = strategy;
 bm->mgmtData = (void *)metadata;
 
 return RC_OK;
-
+}
 
 RC shutdownBufferPool(BM_BufferPool *const bm) {
     // Make sure the metadata was successfully initialized
     if (bm->mgmtData != NULL) {
         BM_Metadata *metadata = (BM_Metadata *)bm->mgmtData;
-        BM_PageFrame *pageFrames = metadata->pageFrames;
         HT_TableHandle *pageTable = &(metadata->pageTable);
         
         // It is an error to shutdown a buffer pool that has pinned pages
+        // (for a shared pool, pages pinned by this process)
+        lockPool(metadata);
         for (int i = 0; i < bm->numPages; i++) {
-            if (pageFrames[i].fixedCount > 0) {
+            if (metadata->segment == NULL ? metadata->fixCounts[i] > 0 : metadata->numberPinned > 0) {
+                pthread_mutex_unlock(&(metadata->state->poolLock));
                 return RC_WRITE_FAILED; // Return error if there are pinned pages
             }
         }
         
-        forceFlushPool(bm);
-        
-        // Free each page frame's data using a for loop
-        for (int i = 0; i < bm->numPages; i++) {
-            free(pageFrames[i].data);
+        flushDirtyFrames(bm, 0);
+        pthread_mutex_unlock(&(metadata->state->poolLock));
+
+        if (metadata->segment != NULL) {
+            // The last process to leave removes the segment
+            detachSegment(metadata, true);
+        } else {
+            pthread_mutex_destroy(&(metadata->state->poolLock));
+            pthread_mutex_destroy(&(metadata->state->fileLock));
+            pthread_cond_destroy(&(metadata->state->ioDone));
+
+            // The frames share one block, which starts at the first frame's data
+            free(metadata->frameData[0]);
         }
 
         closePageFile(&(metadata->pageFile));
 
-        // Free the hash table and metadata
+        // Free the hash table, victim cache and metadata
         freeHashTable(pageTable);
+        freeHashTable(&(metadata->pageClasses));
+        freeHashTable(&(metadata->classIndex));
+        freePageCache(&(metadata->victimCache));
+        freeMissRatio(&(metadata->missRatio));
+        stopTrace(bm);
+        freeFrameArrays(metadata);
         free(metadata);
-        free(pageFrames);
         
         bm->mgmtData = NULL; // Clear management data pointer
         return RC_OK;
@@ -196,54 +491,261 @@ RC forceFlushPool(BM_BufferPool *const bm)
     if (bm->mgmtData != NULL) 
     {
         BM_Metadata *metadata = (BM_Metadata *)bm->mgmtData;
-        BM_PageFrame *pageFrames = metadata->pageFrames;
-        // Initialize loop counter for while loop
-        int i = 0; 
-        while (i < bm->numPages)
+
+        // write every unpinned dirty page, sorted by page number
+        lockPool(metadata);
+        RC result = flushDirtyFrames(bm, 0);
+        pthread_mutex_unlock(&(metadata->state->poolLock));
+        return result;
+    }
+    else return RC_FILE_HANDLE_NOT_INIT;
+}
+
+RC flushSome(BM_BufferPool *const bm, int maxPages)
+{
+    // check if the the metadata was successfully initialized
+    if (bm->mgmtData != NULL) 
+    {
+        BM_Metadata *metadata = (BM_Metadata *)bm->mgmtData;
+
+        if (maxPages <= 0)
+            return RC_OK;
+
+        // write the next maxPages dirty pages of the checkpoint sweep
+        lockPool(metadata);
+        RC result = flushDirtyFrames(bm, maxPages);
+        pthread_mutex_unlock(&(metadata->state->poolLock));
+        return result;
+    }
+    else return RC_FILE_HANDLE_NOT_INIT;
+}
+
+RC setVictimCacheSize(BM_BufferPool *const bm, int capacity)
+{
+    // check if the the metadata was successfully initialized
+    if (bm->mgmtData != NULL) 
+    {
+        BM_Metadata *metadata = (BM_Metadata *)bm->mgmtData;
+
+        // drop the current cache, a capacity of 0 leaves it disabled
+        freePageCache(&(metadata->victimCache));
+        if (capacity <= 0)
+            return RC_OK;
+        // a cached copy of a shared page could be stale by the time another process evicts it
+        if (metadata->segment != NULL)
+            return RC_IM_CONFIG_ERROR;
+
+        if (initPageCache(&(metadata->victimCache), capacity) != 0)
         {
-            // write occupied, dirty and unpinned pages to disk
-            if (pageFrames[i].occupied && pageFrames[i].dirty && pageFrames[i].fixedCount == 0)
-            {
-                writeBlock(pageFrames[i].pageNum, &(metadata->pageFile), pageFrames[i].data);
-                metadata->numberWrite++;
-                pageFrames[i].timeStamp = getTimeStamp(metadata);
+            metadata->victimCache.mgmt = NULL;
+            return RC_ALLOCATION_FAILED;
+        }
+        return RC_OK;
+    }
+    else return RC_FILE_HANDLE_NOT_INIT;
+}
 
-                // clear dirty bool
-                pageFrames[i].dirty = false;
-            }
-            // Increment loop counter
-            i++; 
+RC enableMissRatioCurve(BM_BufferPool *const bm, int maxFrames, int samplingRate)
+{
+    // check if the the metadata was successfully initialized
+    if (bm->mgmtData != NULL) 
+    {
+        BM_Metadata *metadata = (BM_Metadata *)bm->mgmtData;
+
+        // restart the estimate, a maxFrames of 0 leaves it disabled
+        freeMissRatio(&(metadata->missRatio));
+        if (maxFrames <= 0)
+            return RC_OK;
+        if (samplingRate <= 0)
+            return RC_IM_CONFIG_ERROR;
+
+        if (initMissRatio(&(metadata->missRatio), maxFrames, samplingRate) != 0)
+        {
+            metadata->missRatio.mgmt = NULL;
+            return RC_ALLOCATION_FAILED;
+        }
+        return RC_OK;
+    }
+    else return RC_FILE_HANDLE_NOT_INIT;
+}
+
+RC setSwizzling(BM_BufferPool *const bm, bool enabled)
+{
+    // check if the the metadata was successfully initialized
+    if (bm->mgmtData != NULL) 
+    {
+        BM_Metadata *metadata = (BM_Metadata *)bm->mgmtData;
+
+        // the links are per process, other processes could move the pages they point at
+        if (enabled && metadata->segment != NULL)
+            return RC_IM_CONFIG_ERROR;
+
+        // links are only followed while swizzling is on, turning it off forgets them
+        lockPool(metadata);
+        metadata->swizzling = enabled;
+        for (int i = 0; !enabled && i < bm->numPages; i++)
+            unswizzleFrame(metadata, i);
+        pthread_mutex_unlock(&(metadata->state->poolLock));
+        return RC_OK;
+    }
+    else return RC_FILE_HANDLE_NOT_INIT;
+}
+
+RC startTrace(BM_BufferPool *const bm, const char *const traceFileName)
+{
+    // check if the the metadata was successfully initialized
+    if (bm->mgmtData != NULL) 
+    {
+        BM_Metadata *metadata = (BM_Metadata *)bm->mgmtData;
+
+        // a running trace is closed before the new one starts
+        stopTrace(bm);
+        metadata->traceFile = fopen(traceFileName, "wb");
+        if (metadata->traceFile == NULL)
+            return RC_FILE_NOT_FOUND;
+        return RC_OK;
+    }
+    else return RC_FILE_HANDLE_NOT_INIT;
+}
+
+RC stopTrace(BM_BufferPool *const bm)
+{
+    // check if the the metadata was successfully initialized
+    if (bm->mgmtData != NULL) 
+    {
+        BM_Metadata *metadata = (BM_Metadata *)bm->mgmtData;
+
+        if (metadata->traceFile != NULL)
+        {
+            int result = fclose(metadata->traceFile);
+            metadata->traceFile = NULL;
+            if (result != 0)
+                return RC_WRITE_FAILED;
+        }
+        return RC_OK;
+    }
+    else return RC_FILE_HANDLE_NOT_INIT;
+}
+
+/* Page classes */
+
+RC setPageClass(BM_BufferPool *const bm, const PageNumber pageNum, int pageClass)
+{
+    // class ids are used as hash keys and must not be negative
+    if (pageClass < 0)
+        return RC_IM_CONFIG_ERROR;
+
+    // check if the the metadata was successfully initialized
+    if (bm->mgmtData != NULL) 
+    {
+        BM_Metadata *metadata = (BM_Metadata *)bm->mgmtData;
+        int classIndex = getClassIndex(metadata, pageClass);
+        int framedIndex;
+
+        if (classIndex == -1)
+            return RC_ALLOCATION_FAILED;
+
+        // class 0 is the default, so it needs no entry
+        if (pageClass == 0)
+            removePair(&(metadata->pageClasses), pageNum);
+        else if (setValue(&(metadata->pageClasses), pageNum, pageClass) != 0)
+            return RC_ALLOCATION_FAILED;
+
+        // move a resident page's frame over to the new class
+        if (findFrame(metadata, pageNum, &framedIndex) == 0)
+        {
+            metadata->classes[metadata->frameClasses[framedIndex]].numFrames--;
+            metadata->frameClasses[framedIndex] = classIndex;
+            metadata->classes[classIndex].numFrames++;
         }
         return RC_OK;
     }
     else return RC_FILE_HANDLE_NOT_INIT;
 }
 
+RC setClassQuota(BM_BufferPool *const bm, int pageClass, int reservedFrames, int maxFrames)
+{
+    // class ids are used as hash keys and must not be negative
+    if (pageClass < 0)
+        return RC_IM_CONFIG_ERROR;
+
+    // check if the the metadata was successfully initialized
+    if (bm->mgmtData != NULL) 
+    {
+        BM_Metadata *metadata = (BM_Metadata *)bm->mgmtData;
+
+        // classes are bookkept per process, so a shared pool does not support quotas
+        if (metadata->segment != NULL)
+            return RC_IM_CONFIG_ERROR;
+        int classIndex = getClassIndex(metadata, pageClass);
+
+        if (classIndex == -1)
+            return RC_ALLOCATION_FAILED;
+        if (reservedFrames < 0 || maxFrames < 0 || (maxFrames > 0 && reservedFrames > maxFrames))
+            return RC_IM_CONFIG_ERROR;
+
+        metadata->classes[classIndex].reservedFrames = reservedFrames;
+        metadata->classes[classIndex].maxFrames = maxFrames;
+        metadata->classesInUse = true;
+        return RC_OK;
+    }
+    else return RC_FILE_HANDLE_NOT_INIT;
+}
+
+RC setClassPriority(BM_BufferPool *const bm, int pageClass, int priority)
+{
+    // class ids are used as hash keys and must not be negative
+    if (pageClass < 0)
+        return RC_IM_CONFIG_ERROR;
+
+    // check if the the metadata was successfully initialized
+    if (bm->mgmtData != NULL) 
+    {
+        BM_Metadata *metadata = (BM_Metadata *)bm->mgmtData;
+
+        // classes are bookkept per process, so a shared pool does not support priorities
+        if (metadata->segment != NULL)
+            return RC_IM_CONFIG_ERROR;
+        int classIndex = getClassIndex(metadata, pageClass);
+
+        if (classIndex == -1)
+            return RC_ALLOCATION_FAILED;
+
+        metadata->classes[classIndex].priority = priority;
+        metadata->classesInUse = true;
+        return RC_OK;
+    }
+    else return RC_FILE_HANDLE_NOT_INIT;
+}
+
 /* Buffer Manager Interface Access Pages */
 
 RC markDirty(BM_BufferPool *const bm, BM_PageHandle *const page) {
     // Check if metadata was successfully initialized
     if (bm->mgmtData != NULL) {
         int framedIndex;
+        RC result;
         BM_Metadata *metadata = (BM_Metadata *)bm->mgmtData;
-        BM_PageFrame *pageFrames = metadata->pageFrames;
-        HT_TableHandle *pageTable = &(metadata->pageTable);
-        
+
         // Get mapped framedIndex from pageNum
-        int getValueResult = getValue(pageTable, page->pageNum, &framedIndex);
-        
+        lockPool(metadata);
+        int getValueResult = findFrame(metadata, page->pageNum, &framedIndex);
+
         // Use a for loop to handle the possible outcomes of getValue
         for (int i = 0; i < 1; i++) { // Loop will run exactly once
             if (getValueResult == 0) {
-                pageFrames[framedIndex].timeStamp = getTimeStamp(metadata);
+                metadata->timeStamps[framedIndex] = getTimeStamp(metadata);
+                traceAccess(metadata, TRACE_DIRTY, page->pageNum);
 
-                // Set dirty bool
-                pageFrames[framedIndex].dirty = true;
-                return RC_OK;
+                // Set dirty bool and queue the frame for write back
+                addDirtyFrame(metadata, framedIndex);
+                result = RC_OK;
             } else {
-                return RC_IM_KEY_NOT_FOUND;
+                result = RC_IM_KEY_NOT_FOUND;
             }
         }
+        pthread_mutex_unlock(&(metadata->state->poolLock));
+        return result;
     } else {
         return RC_FILE_HANDLE_NOT_INIT;
     }
@@ -252,31 +754,99 @@ RC markDirty(BM_BufferPool *const bm, BM_PageHandle *const page) {
 RC forcePage (BM_BufferPool *const bm, BM_PageHandle *const page)
 {
     // see if metadata was successfully initialized
-    if (bm->mgmtData != NULL) 
+    if (bm->mgmtData != NULL)
     {
         int framedIndex;
+        RC result;
         BM_Metadata *metadata = (BM_Metadata *)bm->mgmtData;
-        BM_PageFrame *pageFrames = metadata->pageFrames;
-        HT_TableHandle *pageTable = &(metadata->pageTable);
 
         // get mapped framedIndex from pageNum
-        if (getValue(pageTable, page->pageNum, &framedIndex) == 0)
+        lockPool(metadata);
+        if (findFrame(metadata, page->pageNum, &framedIndex) == 0)
         {
-            pageFrames[framedIndex].timeStamp = getTimeStamp(metadata);
+            metadata->timeStamps[framedIndex] = getTimeStamp(metadata);
 
             //force the page if it is not pinned
-            if (pageFrames[framedIndex].fixedCount == 0)
+            if (metadata->fixCounts[framedIndex] == 0)
+            {
+                result = writeFrames(metadata, page->pageNum, 1, &(metadata->frameData[framedIndex]));
+
+                // clear dirty bool, the page stays dirty if it could not be written
+                if (result == RC_OK)
+                {
+                    metadata->state->numberWrite++;
+                    removeDirtyFrame(metadata, framedIndex);
+                }
+            }
+            else result = RC_WRITE_FAILED;
+        }
+        else result = RC_IM_KEY_NOT_FOUND;
+        pthread_mutex_unlock(&(metadata->state->poolLock));
+        return result;
+    }
+    else return RC_FILE_HANDLE_NOT_INIT;
+}
+
+RC forcePinnedPage (BM_BufferPool *const bm, BM_PageHandle *const page)
+{
+    // see if metadata was successfully initialized
+    if (bm->mgmtData != NULL)
+    {
+        int framedIndex;
+        RC result = RC_OK;
+        BM_Metadata *metadata = (BM_Metadata *)bm->mgmtData;
+
+        // get mapped framedIndex from pageNum
+        lockPool(metadata);
+        if (findFrame(metadata, page->pageNum, &framedIndex) == 0)
+        {
+            // write the page only if it has changes, whoever holds it
+            if (metadata->dirty[framedIndex])
             {
-                writeBlock(page->pageNum, &(metadata->pageFile), pageFrames[framedIndex].data);
-                metadata->numberWrite++;
+                result = writeFrames(metadata, page->pageNum, 1, &(metadata->frameData[framedIndex]));
+
+                // the page stays dirty if it could not be written
+                if (result == RC_OK)
+                {
+                    metadata->state->numberWrite++;
+                    removeDirtyFrame(metadata, framedIndex);
+                }
+            }
+        }
+        else result = RC_IM_KEY_NOT_FOUND;
+        pthread_mutex_unlock(&(metadata->state->poolLock));
+        return result;
+    }
+    else return RC_FILE_HANDLE_NOT_INIT;
+}
+
+RC unpinPage(BM_BufferPool *const bm, BM_PageHandle *const page)
+{
+    // see if metadata was successfully initialized
+    if (bm->mgmtData != NULL)
+    {
+        int framedIndex;
+        RC result;
+        BM_Metadata *metadata = (BM_Metadata *)bm->mgmtData;
 
-                // clear dirty bool
-                pageFrames[framedIndex].dirty = false;
-                return RC_OK;
+        // get mapped framedIndex from pageNum
+        lockPool(metadata);
+        if (findFrame(metadata, page->pageNum, &framedIndex) == 0)
+        {
+            // unpinning a page nobody holds is an error
+            if (metadata->fixCounts[framedIndex] <= 0)
+                result = RC_WRITE_FAILED;
+            else
+            {
+                metadata->fixCounts[framedIndex]--;
+                metadata->numberPinned--;
+                traceAccess(metadata, TRACE_UNPIN, page->pageNum);
+                result = RC_OK;
             }
-            else return RC_WRITE_FAILED;
         }
-        else return RC_IM_KEY_NOT_FOUND;
+        else result = RC_IM_KEY_NOT_FOUND;
+        pthread_mutex_unlock(&(metadata->state->poolLock));
+        return result;
     }
     else return RC_FILE_HANDLE_NOT_INIT;
 }
@@ -288,81 +858,251 @@ RC pinPage(BM_BufferPool *const bm, BM_PageHandle *const page, const PageNumber
     }
 
     BM_Metadata *metadata = (BM_Metadata *)bm->mgmtData;
-    BM_PageFrame *pageFrames = metadata->pageFrames;
-    HT_TableHandle *pageTable = &(metadata->pageTable);
-    int framedIndex;
 
     // Check if the pageNum is valid
     if (pageNum < 0) {
         return RC_IM_KEY_NOT_FOUND;  // pageNum is negative
     }
 
-    // Use a for loop to handle the retrieval and pinning of the page
-    for (int i = 0; i < 1; i++) {  // Loop will run exactly once
-        int getValueResult = getValue(pageTable, pageNum, &framedIndex);
-        
-        if (getValueResult == 0) {  // Page is already in a frame
-            pageFrames[framedIndex].timeStamp = getTimeStamp(metadata);
-            pageFrames[framedIndex].fixedCount++;
-            page->pageNum = pageNum;
-            page->data = pageFrames[framedIndex].data;
-            return RC_OK;
-        } else {  // Page is not in a frame, use replacement strategy
-            BM_PageFrame *pageFrame;
-            switch (bm->strategy) {
-                case RS_LRU:
-                    pageFrame = replacementLRU(bm);
-                    break;
-                case RS_FIFO:
-                    pageFrame = replacementFIFO(bm);
-                    break;
-                default:
-                    return RC_IM_CONFIG_ERROR;  // Configuration error if no strategy fits
-            }
+    lockPool(metadata);
+    RC result = pinPageLocked(bm, page, pageNum);
+    pthread_mutex_unlock(&(metadata->state->poolLock));
+    return result;
+}
 
-            // Check if replacement strategy succeeded
-            if (pageFrame == NULL) {
-                return RC_WRITE_FAILED;  // Replacement failed
-            }
+RC pinNextPage(BM_BufferPool *const bm, BM_PageHandle *const page, const BM_PageHandle *const from, const PageNumber pageNum) {
+    // Check if management data is initialized
+    if (bm->mgmtData == NULL) {
+        return RC_FILE_HANDLE_NOT_INIT;  // Management data not initialized
+    }
 
-            // Successful replacement, setup new frame
-            setValue(pageTable, pageNum, pageFrame->framedIndex);
-            ensureCapacity(pageNum + 1, &(metadata->pageFile));
-            readBlock(pageNum, &(metadata->pageFile), pageFrame->data);
-            metadata->numberRead++;
-            pageFrame->fixedCount = 1;
-            pageFrame->occupied = true;
-            pageFrame->dirty = false;
-            pageFrame->pageNum = pageNum;
-            page->pageNum = pageNum;
-            page->data = pageFrame->data;
-            return RC_OK;
+    BM_Metadata *metadata = (BM_Metadata *)bm->mgmtData;
+    RC result;
+
+    // Check if the pageNum is valid
+    if (pageNum < 0) {
+        return RC_IM_KEY_NOT_FOUND;  // pageNum is negative
+    }
+
+    lockPool(metadata);
+
+    // The link only counts while the referencing page is pinned in its frame
+    int fromIndex = getFrameOf(bm, from);
+    BM_Swip *link = (fromIndex == -1) ? NULL : &(metadata->frameLinks[fromIndex]);
+
+    // A swizzled link names the frame directly, no page table lookup needed
+    if (metadata->swizzling && link != NULL && link->pageNum == pageNum && link->framedIndex != -1) {
+        int framedIndex = link->framedIndex;
+        if (metadata->missRatio.mgmt != NULL) {
+            recordAccess(&(metadata->missRatio), pageNum);
         }
+        traceAccess(metadata, TRACE_PIN, pageNum);
+        metadata->timeStamps[framedIndex] = getTimeStamp(metadata);
+        metadata->refBits[framedIndex] = 1;
+        metadata->fixCounts[framedIndex]++;
+        metadata->numberSwizzledPin++;
+        metadata->numberPinned++;
+        page->pageNum = pageNum;
+        page->data = metadata->frameData[framedIndex];
+        pthread_mutex_unlock(&(metadata->state->poolLock));
+        return RC_OK;
     }
 
-    return RC_OK;  // This line is effectively unreachable
+    // Otherwise pin it the usual way and swizzle the link (the referencing page
+    // may have been evicted meanwhile if the caller did not keep it pinned),
+    // a page without a class of its own joins the class of the page linking to it
+    int pageClass;
+    if (fromIndex != -1 && getValue(&(metadata->pageClasses), pageNum, &pageClass) != 0) {
+        pageClass = metadata->classes[metadata->frameClasses[fromIndex]].pageClass;
+        if (pageClass != 0) {
+            setValue(&(metadata->pageClasses), pageNum, pageClass);
+        }
+    }
+    result = pinPageLocked(bm, page, pageNum);
+    if (result == RC_OK && metadata->swizzling && getFrameOf(bm, from) == fromIndex && fromIndex != -1) {
+        swizzleLink(metadata, fromIndex, pageNum, getFrameOf(bm, page));
+    }
+    pthread_mutex_unlock(&(metadata->state->poolLock));
+    return result;
 }
 
-/* Statistics Interface */
+RC pinPages(BM_BufferPool *const bm, BM_PageHandle *const handles, const PageNumber *pageNums, int numPages) {
+    // Check if management data is initialized
+    if (bm->mgmtData == NULL) {
+        return RC_FILE_HANDLE_NOT_INIT;  // Management data not initialized
+    }
 
-PageNumber *getFrameContents (BM_BufferPool *const bm)
-{
-    // Use the switch case to check the metadata is initialized or not
-    switch (bm->mgmtData != NULL) 
-    {
-        case true:
-        {
-            BM_Metadata *metadata = (BM_Metadata *)bm->mgmtData;
-            BM_PageFrame *pageFrames = metadata->pageFrames;
+    BM_Metadata *metadata = (BM_Metadata *)bm->mgmtData;
+    RC result = RC_OK;
+    int framedIndex;
 
-            // Allocate memory for the array; user is responsible for freeing it
+    // Check if every pageNum is valid
+    for (int i = 0; i < numPages; i++) {
+        if (pageNums[i] < 0) {
+            return RC_IM_KEY_NOT_FOUND;  // pageNum is negative
+        }
+    }
+    if (numPages <= 0) {
+        return RC_OK;
+    }
+
+    // frames[i] is the frame of handle i (-1 until a missing page has one), misses the
+    // pages that are not resident and reads the misses that have to come from disk
+    int *frames = (int *)malloc(sizeof(int) * numPages);
+    BM_PinRequest *misses = (BM_PinRequest *)malloc(sizeof(BM_PinRequest) * numPages);
+    int *reads = (int *)malloc(sizeof(int) * numPages);
+    SM_PageHandle *runData = (SM_PageHandle *)malloc(sizeof(SM_PageHandle) * numPages);
+    if (frames == NULL || misses == NULL || reads == NULL || runData == NULL) {
+        free(frames);
+        free(misses);
+        free(reads);
+        free(runData);
+        return RC_ALLOCATION_FAILED;
+    }
+
+    lockPool(metadata);
+
+    // Feed the references to the miss-ratio curve and the trace, hit or miss
+    for (int i = 0; i < numPages; i++) {
+        if (metadata->missRatio.mgmt != NULL) {
+            recordAccess(&(metadata->missRatio), pageNums[i]);
+        }
+        traceAccess(metadata, TRACE_PIN, pageNums[i]);
+    }
+
+    // Wait until no other caller is still reading one of the pages
+    bool waiting;
+    do {
+        waiting = false;
+        for (int i = 0; i < numPages && !waiting; i++) {
+            waiting = findFrame(metadata, pageNums[i], &framedIndex) == 0 && metadata->ioInProgress[framedIndex];
+        }
+        if (waiting) {
+            waitForReads(metadata);
+        }
+    } while (waiting);
+
+    // Pin the resident pages right away and collect the misses
+    int numMisses = 0;
+    for (int i = 0; i < numPages; i++) {
+        if (findFrame(metadata, pageNums[i], &framedIndex) == 0) {
+            metadata->timeStamps[framedIndex] = getTimeStamp(metadata);
+            metadata->refBits[framedIndex] = 1;
+            metadata->fixCounts[framedIndex]++;
+            frames[i] = framedIndex;
+        } else {
+            misses[numMisses].pageNum = pageNums[i];
+            misses[numMisses].handleIndex = i;
+            misses[numMisses].framedIndex = -1;
+            frames[i] = -1;
+            numMisses++;
+        }
+    }
+    qsort(misses, numMisses, sizeof(BM_PinRequest), comparePinRequests);
+
+    // Pick the victims for all misses, a page asked for twice shares its frame
+    int claimed = 0;
+    int numReads = 0;
+    for (; claimed < numMisses; claimed++) {
+        if (claimed > 0 && misses[claimed].pageNum == misses[claimed - 1].pageNum) {
+            misses[claimed].framedIndex = misses[claimed - 1].framedIndex;
+            metadata->fixCounts[misses[claimed].framedIndex]++;
+            continue;
+        }
+        result = claimFrame(bm, misses[claimed].pageNum, &framedIndex);
+        if (result != RC_OK) {
+            break;
+        }
+        misses[claimed].framedIndex = framedIndex;
+
+        // Fill what the victim cache holds, the rest is read below in page order
+        if (metadata->victimCache.mgmt != NULL &&
+            takePage(&(metadata->victimCache), misses[claimed].pageNum, metadata->frameData[framedIndex]) == 0) {
+            metadata->numberCacheHit++;
+        } else {
+            startRead(metadata, framedIndex);
+            reads[numReads++] = claimed;
+        }
+    }
+
+    // Read the missing pages in one pass without holding the pool lock,
+    // each run of adjacent page numbers costs one seek
+    if (result == RC_OK && numReads > 0) {
+        pthread_mutex_unlock(&(metadata->state->poolLock));
+        lockLatch(&(metadata->state->fileLock));
+        result = ensureCapacity(misses[reads[numReads - 1]].pageNum + 1, &(metadata->pageFile));
+        int done = 0;
+        while (result == RC_OK && done < numReads) {
+            PageNumber runStart = misses[reads[done]].pageNum;
+            int runLength = 0;
+            do {
+                runData[runLength] = metadata->frameData[misses[reads[done + runLength]].framedIndex];
+                runLength++;
+            } while (done + runLength < numReads && misses[reads[done + runLength]].pageNum == runStart + runLength);
+            result = readBlocks(runStart, runLength, &(metadata->pageFile), runData);
+            done += runLength;
+        }
+        pthread_mutex_unlock(&(metadata->state->fileLock));
+        lockPool(metadata);
+    }
+
+    // The frames that were being read can be looked at again
+    for (int k = 0; k < numReads; k++) {
+        metadata->ioInProgress[misses[reads[k]].framedIndex] = false;
+    }
+    pthread_cond_broadcast(&(metadata->state->ioDone));
+
+    if (result == RC_OK) {
+        metadata->state->numberRead += numReads;
+        metadata->numberPinned += numPages;
+        for (int k = 0; k < numMisses; k++) {
+            frames[misses[k].handleIndex] = misses[k].framedIndex;
+        }
+        for (int i = 0; i < numPages; i++) {
+            handles[i].pageNum = pageNums[i];
+            handles[i].data = metadata->frameData[frames[i]];
+        }
+    } else {
+        // A failed batch pins nothing: unpin the resident pages and give back the claimed frames
+        for (int i = 0; i < numPages; i++) {
+            if (frames[i] != -1) {
+                metadata->fixCounts[frames[i]]--;
+            }
+        }
+        for (int k = 0; k < claimed; k++) {
+            if (k == 0 || misses[k].pageNum != misses[k - 1].pageNum) {
+                releaseFrame(metadata, misses[k].framedIndex);
+            }
+        }
+    }
+
+    pthread_mutex_unlock(&(metadata->state->poolLock));
+    free(frames);
+    free(misses);
+    free(reads);
+    free(runData);
+    return result;
+}
+
+/* Statistics Interface */
+
+PageNumber *getFrameContents (BM_BufferPool *const bm)
+{
+    // Use the switch case to check the metadata is initialized or not
+    switch (bm->mgmtData != NULL) 
+    {
+        case true:
+        {
+            BM_Metadata *metadata = (BM_Metadata *)bm->mgmtData;
+
+            // Allocate memory for the array; user is responsible for freeing it
             PageNumber *array = (PageNumber *)malloc(sizeof(PageNumber) * bm->numPages);
             // Initialize loop counter for while loop
             int i = 0;  
             while (i < bm->numPages)
             {
                 // Assign page number if frame is occupied, otherwise set to NO_PAGE
-                array[i] = pageFrames[i].occupied ? pageFrames[i].pageNum : NO_PAGE;
+                array[i] = metadata->occupied[i] ? metadata->framePages[i] : NO_PAGE;
                 i++;  // Increment loop counter
             }
             return array;
@@ -381,7 +1121,6 @@ bool *getDirtyFlags (BM_BufferPool *const bm)
         case true:
         {
             BM_Metadata *metadata = (BM_Metadata *)bm->mgmtData;
-            BM_PageFrame *pageFrames = metadata->pageFrames;
 
             // Allocate memory for the array; user is responsible for freeing it
             bool *array = (bool *)malloc(sizeof(bool) * bm->numPages);
@@ -390,7 +1129,7 @@ bool *getDirtyFlags (BM_BufferPool *const bm)
             while (i < bm->numPages)
             {
                 // Set true if the frame is occupied and dirty, otherwise false
-                array[i] = pageFrames[i].occupied ? pageFrames[i].dirty : false;
+                array[i] = metadata->occupied[i] ? metadata->dirty[i] : false;
                 // Increment loop counter
                 i++;  
             }
@@ -410,7 +1149,6 @@ int *getFixCounts (BM_BufferPool *const bm)
         case true:
         {
             BM_Metadata *metadata = (BM_Metadata *)bm->mgmtData;
-            BM_PageFrame *pageFrames = metadata->pageFrames;
 
             // Allocate memory for array user is responsible for freeing it
             int *array = (int *)malloc(sizeof(int) * bm->numPages);
@@ -419,7 +1157,7 @@ int *getFixCounts (BM_BufferPool *const bm)
             while (i < bm->numPages)
             {
                 // Set fix count if frame is occupied, otherwise set to 0
-                array[i] = pageFrames[i].occupied ? pageFrames[i].fixedCount : 0;
+                array[i] = metadata->occupied[i] ? metadata->fixCounts[i] : 0;
                 // Increment loop counter
                 i++;  
             }
@@ -439,7 +1177,92 @@ int getNumReadIO (BM_BufferPool *const bm)
         case true:
         {
             BM_Metadata *metadata = (BM_Metadata *)bm->mgmtData;
-            return metadata->numberRead;
+            return metadata->state->numberRead;
+        }
+        // Return 0 if management data is not initialized
+        default:
+            return 0;  
+    }
+}
+
+int getNumDirtyPages (BM_BufferPool *const bm)
+{
+    // Use switch case to check if metadata is initialized
+    switch (bm->mgmtData != NULL) 
+    {
+        case true:
+        {
+            BM_Metadata *metadata = (BM_Metadata *)bm->mgmtData;
+            return metadata->state->numberDirty;
+        }
+        // Return 0 if management data is not initialized
+        default:
+            return 0;  
+    }
+}
+
+int getNumVictimCacheHits (BM_BufferPool *const bm)
+{
+    // Use switch case to check if metadata is initialized
+    switch (bm->mgmtData != NULL) 
+    {
+        case true:
+        {
+            BM_Metadata *metadata = (BM_Metadata *)bm->mgmtData;
+            return metadata->numberCacheHit;
+        }
+        // Return 0 if management data is not initialized
+        default:
+            return 0;  
+    }
+}
+
+int getMissRatioCurveSize (BM_BufferPool *const bm)
+{
+    // Use switch case to check if metadata is initialized and the curve enabled
+    switch (bm->mgmtData != NULL && ((BM_Metadata *)bm->mgmtData)->missRatio.mgmt != NULL) 
+    {
+        case true:
+        {
+            BM_Metadata *metadata = (BM_Metadata *)bm->mgmtData;
+            return metadata->missRatio.maxSize;
+        }
+        // Return 0 if there is no curve
+        default:
+            return 0;  
+    }
+}
+
+double *getMissRatioCurve (BM_BufferPool *const bm)
+{
+    // Use switch case to check if there is a curve to report
+    switch (getMissRatioCurveSize(bm) > 0) 
+    {
+        case true:
+        {
+            BM_Metadata *metadata = (BM_Metadata *)bm->mgmtData;
+
+            // one entry per pool size 0..maxFrames; user is responsible for freeing it
+            double *array = (double *)malloc(sizeof(double) * (metadata->missRatio.maxSize + 1));
+            if (array != NULL)
+                getMissRatios(&(metadata->missRatio), array);
+            return array;
+        }
+        // Return NULL if there is no curve
+        default:
+            return NULL;  
+    }
+}
+
+int getNumSwizzledPins (BM_BufferPool *const bm)
+{
+    // Use switch case to check if metadata is initialized
+    switch (bm->mgmtData != NULL) 
+    {
+        case true:
+        {
+            BM_Metadata *metadata = (BM_Metadata *)bm->mgmtData;
+            return metadata->numberSwizzledPin;
         }
         // Return 0 if management data is not initialized
         default:
@@ -455,7 +1278,7 @@ int getNumWriteIO (BM_BufferPool *const bm)
         case true:
         {
             BM_Metadata *metadata = (BM_Metadata *)bm->mgmtData;
-            return metadata->numberWrite;
+            return metadata->state->numberWrite;
         }
           // Return 0 if management data is not initialized
         default:
@@ -465,69 +1288,188 @@ int getNumWriteIO (BM_BufferPool *const bm)
 
 /* Replacement Policies */
 
-BM_PageFrame *replacementFIFO(BM_BufferPool *const bm)
-{
-    BM_Metadata *metadata = (BM_Metadata *)bm->mgmtData;
-    BM_PageFrame *pageFrames = metadata->pageFrames;
-
-    int firstIndex = metadata->queuedIndex;
-    int currentIndex = firstIndex;
+// the victim searches below only read the fixCounts / refBits / timeStamps arrays;
+// with SSE2 they test four frames (fix counts, timestamps) or sixteen (ref bits) per compare
 
-    // Keep cycling in FIFO order till a frame is found that is not pinned
-    while (true)
+// helper to find the first unpinned frame in [start, end), -1 if there is none
+static int findUnpinnedFrame(const int *fixCounts, int start, int end)
+{
+    int i = start;
+#ifdef __SSE2__
+    const __m128i zero = _mm_setzero_si128();
+    for (; i + 4 <= end; i += 4)
     {
-        currentIndex = (currentIndex + 1) % bm->numPages;
-        if (currentIndex == firstIndex)
-            break;
-        if (pageFrames[currentIndex].fixedCount == 0)
-            break;
+        __m128i counts = _mm_loadu_si128((const __m128i *)(fixCounts + i));
+        int mask = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(counts, zero)));
+        if (mask != 0)
+            return i + __builtin_ctz(mask);
     }
+#endif
+    for (; i < end; i++)
+    {
+        if (fixCounts[i] == 0)
+            return i;
+    }
+    return -1;
+}
 
-    // Update index back into metadata
-    metadata->queuedIndex = currentIndex;
-
-    // Check if  all frames are pinned
-    switch (pageFrames[currentIndex].fixedCount) 
+// helper to find the first frame in [start, end) that is unpinned with its ref bit clear
+// the ref bits of the frames passed over are cleared (second chance), -1 if there is none
+static int findClockFrame(const int *fixCounts, unsigned char *refBits, int start, int end)
+{
+    int i = start;
+#ifdef __SSE2__
+    const __m128i zero = _mm_setzero_si128();
+    for (; i + 16 <= end; i += 16)
     {
-        case 0:
-            return getAfterEviction(bm, currentIndex);
-        default:
-            return NULL;
+        // pack 16 fix counts down to bytes (non-zero counts stay non-zero) and merge in the ref bits
+        __m128i counts01 = _mm_packs_epi32(_mm_loadu_si128((const __m128i *)(fixCounts + i)),
+                                           _mm_loadu_si128((const __m128i *)(fixCounts + i + 4)));
+        __m128i counts23 = _mm_packs_epi32(_mm_loadu_si128((const __m128i *)(fixCounts + i + 8)),
+                                           _mm_loadu_si128((const __m128i *)(fixCounts + i + 12)));
+        __m128i busy = _mm_or_si128(_mm_packs_epi16(counts01, counts23),
+                                    _mm_loadu_si128((const __m128i *)(refBits + i)));
+        int mask = _mm_movemask_epi8(_mm_cmpeq_epi8(busy, zero));
+        if (mask != 0)
+        {
+            int found = i + __builtin_ctz(mask);
+            memset(refBits + i, 0, found - i);
+            return found;
+        }
+        memset(refBits + i, 0, 16);
+    }
+#endif
+    for (; i < end; i++)
+    {
+        if (fixCounts[i] == 0 && refBits[i] == 0)
+            return i;
+        refBits[i] = 0;
     }
+    return -1;
 }
 
-BM_PageFrame *replacementLRU(BM_BufferPool *const bm)
+// helper to find the unpinned frame with the smallest timestamp, -1 if all frames are pinned
+static int findOldestUnpinnedFrame(const int *fixCounts, const TimeStamp *timeStamps, int numPages)
 {
-    BM_Metadata *metadata = (BM_Metadata *)bm->mgmtData;
-    BM_PageFrame *pageFrames = metadata->pageFrames;
     int minIndex = -1;
     TimeStamp min = UINT_MAX;
-    // Initialize loop counter for while loop
-    int i = 0;  
+    int i = 0;
+#ifdef __SSE2__
+    if (numPages >= 4)
+    {
+        // SSE2 only compares signed ints, so timestamps are biased by 2^31
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i bias = _mm_set1_epi32((int)0x80000000u);
+        const __m128i four = _mm_set1_epi32(4);
+        __m128i minStamps = _mm_set1_epi32(INT_MAX);
+        __m128i minIndices = _mm_set1_epi32(-1);
+        __m128i indices = _mm_setr_epi32(0, 1, 2, 3);
+        for (; i + 4 <= numPages; i += 4)
+        {
+            __m128i unpinned = _mm_cmpeq_epi32(_mm_loadu_si128((const __m128i *)(fixCounts + i)), zero);
+            __m128i stamps = _mm_xor_si128(_mm_loadu_si128((const __m128i *)(timeStamps + i)), bias);
+            __m128i older = _mm_and_si128(unpinned, _mm_or_si128(_mm_cmplt_epi32(stamps, minStamps),
+                                                                 _mm_cmpeq_epi32(minIndices, _mm_set1_epi32(-1))));
+            minStamps = _mm_or_si128(_mm_and_si128(older, stamps), _mm_andnot_si128(older, minStamps));
+            minIndices = _mm_or_si128(_mm_and_si128(older, indices), _mm_andnot_si128(older, minIndices));
+            indices = _mm_add_epi32(indices, four);
+        }
 
-    // Find unpinned frame with smallest timestamp
-    while (i < bm->numPages)
+        // reduce the four lanes
+        int laneStamps[4], laneIndices[4];
+        _mm_storeu_si128((__m128i *)laneStamps, minStamps);
+        _mm_storeu_si128((__m128i *)laneIndices, minIndices);
+        for (int lane = 0; lane < 4; lane++)
+        {
+            if (laneIndices[lane] == -1)
+                continue;
+            TimeStamp stamp = (TimeStamp)laneStamps[lane] ^ 0x80000000u;
+            if (minIndex == -1 || stamp < min)
+            {
+                min = stamp;
+                minIndex = laneIndices[lane];
+            }
+        }
+    }
+#endif
+    // Find unpinned frame with smallest timestamp among the remaining frames
+    for (; i < numPages; i++)
     {
-        if (pageFrames[i].fixedCount == 0 && pageFrames[i].timeStamp < min)
+        if (fixCounts[i] == 0 && (minIndex == -1 || timeStamps[i] < min))
         {
-            min = pageFrames[i].timeStamp;
+            min = timeStamps[i];
             minIndex = i;
         }
-        // Increment loop counter
-        i++;  
     }
+    return minIndex;
+}
+
+int replacementFIFO(BM_BufferPool *const bm, const int *busy)
+{
+    BM_Metadata *metadata = (BM_Metadata *)bm->mgmtData;
+
+    // Keep cycling in FIFO order till a frame is found that is not pinned
+    int startIndex = (metadata->state->queuedIndex + 1) % bm->numPages;
+    int currentIndex = findUnpinnedFrame(busy, startIndex, bm->numPages);
+    if (currentIndex == -1)
+        currentIndex = findUnpinnedFrame(busy, 0, startIndex);
+
+    // Check if  all frames are pinned
+    switch (currentIndex) 
+    {
+        case -1:
+            return -1;
+        default:
+            // Update index back into metadata
+            metadata->state->queuedIndex = currentIndex;
+            return getAfterEviction(bm, currentIndex);
+    }
+}
+
+int replacementLRU(BM_BufferPool *const bm, const int *busy)
+{
+    BM_Metadata *metadata = (BM_Metadata *)bm->mgmtData;
+
+    // Find unpinned frame with smallest timestamp
+    int minIndex = findOldestUnpinnedFrame(busy, metadata->timeStamps, bm->numPages);
     
     // Use switch case to handle case where all frames might be pinned
     switch (minIndex)
     {
         // case where all frames were pinned
         case -1:
-            return NULL;  
+            return -1;  
         default:
             return getAfterEviction(bm, minIndex);
     }
 }
 
+int replacementCLOCK(BM_BufferPool *const bm, const int *busy)
+{
+    BM_Metadata *metadata = (BM_Metadata *)bm->mgmtData;
+    int hand = metadata->state->clockHand;
+    int victim = -1;
+
+    // Sweep from the hand and wrap around; the first sweep clears every ref bit it passes,
+    // so the second one finds a victim unless every frame is pinned
+    for (int sweep = 0; sweep < 2 && victim == -1; sweep++)
+    {
+        victim = findClockFrame(busy, metadata->refBits, hand, bm->numPages);
+        if (victim == -1)
+            victim = findClockFrame(busy, metadata->refBits, 0, hand);
+    }
+
+    switch (victim)
+    {
+        // case where all frames were pinned
+        case -1:
+            return -1;
+        default:
+            metadata->state->clockHand = (victim + 1) % bm->numPages;
+            return getAfterEviction(bm, victim);
+    }
+}
+
 /* Helpers */
 
 TimeStamp getTimeStamp(BM_Metadata *metadata)
@@ -536,7 +1478,7 @@ TimeStamp getTimeStamp(BM_Metadata *metadata)
     switch (metadata != NULL)
     {
         case true:
-            return metadata->timeStamp++;
+            return metadata->state->timeStamp++;
         default:
             // This case should logically never happen if the function is used correctly
             // Returning a default timestamp in case of an error (unexpected)
@@ -544,35 +1486,763 @@ TimeStamp getTimeStamp(BM_Metadata *metadata)
     }
 }
 
-BM_PageFrame *getAfterEviction(BM_BufferPool *const bm, int framedIndex)
+int getAfterEviction(BM_BufferPool *const bm, int framedIndex)
 {
     BM_Metadata *metadata = (BM_Metadata *)bm->mgmtData;
-    BM_PageFrame *pageFrames = metadata->pageFrames;
-    HT_TableHandle *pageTable = &(metadata->pageTable);
 
     // Update timestamp
-    pageFrames[framedIndex].timeStamp = getTimeStamp(metadata);
+    metadata->timeStamps[framedIndex] = getTimeStamp(metadata);
 
     // Use switch-case to handle the occupied status of the page frame
-    switch (pageFrames[framedIndex].occupied)
+    switch (metadata->occupied[framedIndex])
     {
         case true:
-            // Remove old mapping
-            removePair(pageTable, pageFrames[framedIndex].pageNum);
-            // Write old frame back to disk if it's dirty
-            switch (pageFrames[framedIndex].dirty)
+            // Write old frame back to disk if it's dirty, a page that cannot be written
+            // keeps its frame (and stays dirty) and there is no victim
+            switch (metadata->dirty[framedIndex])
             {
                 case true:
-                    writeBlock(pageFrames[framedIndex].pageNum, &(metadata->pageFile), pageFrames[framedIndex].data);
-                    metadata->numberWrite++;
+                    if (writeFrames(metadata, metadata->framePages[framedIndex], 1, &(metadata->frameData[framedIndex])) != RC_OK)
+                        return -1;
+                    metadata->state->numberWrite++;
+                    removeDirtyFrame(metadata, framedIndex);
                     break;
                 default:
                     break;
             }
+            // Remove old mapping, links to the frame fall back to the page number
+            unmapPage(metadata, metadata->framePages[framedIndex]);
+            unswizzleFrame(metadata, framedIndex);
+            metadata->classes[metadata->frameClasses[framedIndex]].numFrames--;
+            // The frame now matches the disk, keep a compressed copy of it
+            if (metadata->victimCache.mgmt != NULL)
+                cachePage(&(metadata->victimCache), metadata->framePages[framedIndex], metadata->frameData[framedIndex]);
             break;
         default:
             break;
     }
     // Return the evicted frame (caller must deal with setting the page's metadata)
-    return &(pageFrames[framedIndex]);
+    return framedIndex;
+}
+
+int lockLatch(pthread_mutex_t *latch)
+{
+    // the next holder takes over a latch whose holder died, what it guards is left as the
+    // dead process left it (lockPool then gives up the pages it was reading)
+    if (pthread_mutex_lock(latch) == EOWNERDEAD)
+    {
+        pthread_mutex_consistent(latch);
+        return 1;
+    }
+    return 0;
+}
+
+void waitLatch(pthread_cond_t *condition, pthread_mutex_t *latch)
+{
+    if (pthread_cond_wait(condition, latch) == EOWNERDEAD)
+        pthread_mutex_consistent(latch);
+}
+
+void lockPool(BM_Metadata *metadata)
+{
+    if (lockLatch(&(metadata->state->poolLock)) && metadata->segment != NULL)
+        recoverReads(metadata);
+}
+
+void waitForReads(BM_Metadata *metadata)
+{
+    struct timespec deadline;
+    int result;
+
+    if (metadata->segment == NULL)
+    {
+        waitLatch(&(metadata->state->ioDone), &(metadata->state->poolLock));
+        return;
+    }
+
+    // a process killed while reading never broadcasts ioDone, so the wait is bounded
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    deadline.tv_nsec += (long)READ_WAIT * 1000;
+    deadline.tv_sec += deadline.tv_nsec / 1000000000;
+    deadline.tv_nsec %= 1000000000;
+    result = pthread_cond_timedwait(&(metadata->state->ioDone), &(metadata->state->poolLock), &deadline);
+    if (result == EOWNERDEAD)
+        pthread_mutex_consistent(&(metadata->state->poolLock));
+    if (result != 0)
+        recoverReads(metadata);
+}
+
+void startRead(BM_Metadata *metadata, int framedIndex)
+{
+    metadata->ioInProgress[framedIndex] = true;
+    if (metadata->segment != NULL)
+        metadata->ioOwners[framedIndex] = getpid();
+}
+
+int recoverReads(BM_Metadata *metadata)
+{
+    int released = 0;
+
+    // the frame was claimed but never filled in, it goes back as if the read had failed
+    for (int i = 0; i < metadata->segment->numPages; i++)
+    {
+        if (metadata->ioInProgress[i] && kill(metadata->ioOwners[i], 0) == -1 && errno == ESRCH)
+        {
+            metadata->ioInProgress[i] = false;
+            releaseFrame(metadata, i);
+            released++;
+        }
+    }
+    if (released > 0)
+        pthread_cond_broadcast(&(metadata->state->ioDone));
+    return released;
+}
+
+RC writeFrames(BM_Metadata *metadata, PageNumber startPage, int numPages, SM_PageHandle *pages)
+{
+    // another process sharing the pool may have grown the file since this handle last
+    // looked, so its size is refreshed before the bound check of the write
+    lockLatch(&(metadata->state->fileLock));
+    RC result = ensureCapacity(startPage + numPages, &(metadata->pageFile));
+    if (result == RC_OK)
+        result = writeBlocks(startPage, numPages, &(metadata->pageFile), pages);
+    pthread_mutex_unlock(&(metadata->state->fileLock));
+    return result;
+}
+
+void freeFrameArrays(BM_Metadata *metadata)
+{
+    free(metadata->frameData);
+    free(metadata->frameClasses);
+    free(metadata->victimFilter);
+    free(metadata->frameLinks);
+    free(metadata->linkParents);
+    free(metadata->classes);
+
+    // the arrays of a shared pool belong to its segment
+    if (metadata->segment == NULL)
+    {
+        free(metadata->framePages);
+        free(metadata->fixCounts);
+        free(metadata->refBits);
+        free(metadata->timeStamps);
+        free(metadata->occupied);
+        free(metadata->dirty);
+        free(metadata->dirtyIndex);
+        free(metadata->dirtyFrames);
+        free(metadata->ioInProgress);
+    }
+}
+
+void initPoolState(BM_PoolState *state, int numPages, bool shared)
+{
+    pthread_mutexattr_t mutexAttr;
+    pthread_condattr_t condAttr;
+
+    // the latches of a shared pool are taken by every process attached to it, and are
+    // robust so that a process dying while it holds one does not block all the others
+    pthread_mutexattr_init(&mutexAttr);
+    pthread_condattr_init(&condAttr);
+    if (shared)
+    {
+        pthread_mutexattr_setpshared(&mutexAttr, PTHREAD_PROCESS_SHARED);
+        pthread_mutexattr_setrobust(&mutexAttr, PTHREAD_MUTEX_ROBUST);
+        pthread_condattr_setpshared(&condAttr, PTHREAD_PROCESS_SHARED);
+    }
+    pthread_mutex_init(&(state->poolLock), &mutexAttr);
+    pthread_mutex_init(&(state->fileLock), &mutexAttr);
+    pthread_cond_init(&(state->ioDone), &condAttr);
+    pthread_mutexattr_destroy(&mutexAttr);
+    pthread_condattr_destroy(&condAttr);
+
+    state->queuedIndex = numPages - 1; // Begin queue from last element
+    state->timeStamp = 0;
+    state->clockHand = 0;
+    state->numberDirty = 0;
+    state->flushCursor = 0;
+    state->numberRead = 0;
+    state->numberWrite = 0;
+}
+
+// hand out the next aligned part of a segment (only the size is counted when segment is NULL)
+static void *carveSegment(char *segment, size_t *offset, size_t size)
+{
+    void *part = (segment == NULL) ? NULL : segment + *offset;
+    *offset += (size + SEGMENT_ALIGN - 1) / SEGMENT_ALIGN * SEGMENT_ALIGN;
+    return part;
+}
+
+size_t layoutSegment(BM_Metadata *metadata, char *segment, int numPages, char **frameBlock)
+{
+    size_t offset = 0;
+
+    carveSegment(segment, &offset, sizeof(BM_SharedHeader));
+    *frameBlock = (char *)carveSegment(segment, &offset, (size_t)PAGE_SIZE * numPages);
+    metadata->framePages = (PageNumber *)carveSegment(segment, &offset, sizeof(PageNumber) * numPages);
+    metadata->fixCounts = (int *)carveSegment(segment, &offset, sizeof(int) * numPages);
+    metadata->refBits = (unsigned char *)carveSegment(segment, &offset, numPages);
+    metadata->timeStamps = (TimeStamp *)carveSegment(segment, &offset, sizeof(TimeStamp) * numPages);
+    metadata->occupied = (bool *)carveSegment(segment, &offset, sizeof(bool) * numPages);
+    metadata->dirty = (bool *)carveSegment(segment, &offset, sizeof(bool) * numPages);
+    metadata->dirtyIndex = (int *)carveSegment(segment, &offset, sizeof(int) * numPages);
+    metadata->dirtyFrames = (int *)carveSegment(segment, &offset, sizeof(int) * numPages);
+    metadata->ioInProgress = (bool *)carveSegment(segment, &offset, sizeof(bool) * numPages);
+    metadata->ioOwners = (pid_t *)carveSegment(segment, &offset, sizeof(pid_t) * numPages);
+
+    // the page table is kept at most half full
+    int numSlots = 1;
+    while (numSlots < 2 * numPages)
+        numSlots *= 2;
+    metadata->pageSlotMask = numSlots - 1;
+    metadata->pageSlots = (int *)carveSegment(segment, &offset, sizeof(int) * numSlots);
+    return offset;
+}
+
+char *attachSegment(BM_Metadata *metadata, const char *const segmentName, int numPages, bool *created)
+{
+    char *frameBlock;
+    struct stat info;
+    size_t size = layoutSegment(metadata, NULL, numPages, &frameBlock);
+
+    // the first process creates the segment, the others open it
+    int fd = shm_open(segmentName, O_RDWR | O_CREAT | O_EXCL, 0600);
+    *created = (fd != -1);
+    if (fd == -1 && errno == EEXIST)
+        fd = shm_open(segmentName, O_RDWR, 0600);
+    if (fd == -1)
+        return NULL;
+    if (*created && ftruncate(fd, size) != 0)
+    {
+        close(fd);
+        shm_unlink(segmentName);
+        return NULL;
+    }
+
+    // wait for the creator to size the segment, a segment of another size belongs to another pool
+    do
+    {
+        if (fstat(fd, &info) != 0)
+        {
+            close(fd);
+            return NULL;
+        }
+        if (info.st_size == 0)
+            usleep(SEGMENT_WAIT);
+    } while (info.st_size == 0);
+    if ((size_t)info.st_size != size)
+    {
+        close(fd);
+        return NULL;
+    }
+
+    char *segment = (char *)mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (segment == MAP_FAILED)
+    {
+        if (*created)
+            shm_unlink(segmentName);
+        return NULL;
+    }
+
+    layoutSegment(metadata, segment, numPages, &frameBlock);
+    metadata->segment = (BM_SharedHeader *)segment;
+    metadata->segmentSize = size;
+    metadata->segmentName = strdup(segmentName);
+    metadata->state = &(metadata->segment->state);
+
+    if (*created)
+    {
+        // initPool fills in the rest and sets ready
+        metadata->segment->numPages = numPages;
+        metadata->segment->pageSize = PAGE_SIZE;
+        metadata->segment->attached = 1;
+        return frameBlock;
+    }
+
+    while (!__atomic_load_n(&(metadata->segment->ready), __ATOMIC_ACQUIRE))
+        usleep(SEGMENT_WAIT);
+    lockPool(metadata);
+    metadata->segment->attached++;
+    pthread_mutex_unlock(&(metadata->state->poolLock));
+    return frameBlock;
+}
+
+void detachSegment(BM_Metadata *metadata, bool attached)
+{
+    bool last = false;
+
+    if (attached)
+    {
+        lockPool(metadata);
+        last = (--metadata->segment->attached == 0);
+        pthread_mutex_unlock(&(metadata->state->poolLock));
+    }
+    if (last)
+    {
+        pthread_mutex_destroy(&(metadata->state->poolLock));
+        pthread_mutex_destroy(&(metadata->state->fileLock));
+        pthread_cond_destroy(&(metadata->state->ioDone));
+        shm_unlink(metadata->segmentName);
+    }
+
+    munmap(metadata->segment, metadata->segmentSize);
+    free(metadata->segmentName);
+    metadata->state = &(metadata->privateState);
+}
+
+// the first slot probed for a page in a shared pool's page table
+static int homeSlot(BM_Metadata *metadata, PageNumber pageNum)
+{
+    unsigned int x = (unsigned int)pageNum;
+    x ^= x >> 16;
+    x *= 0x45d9f3bu;
+    x ^= x >> 16;
+    return (int)(x & (unsigned int)metadata->pageSlotMask);
+}
+
+int findFrame(BM_Metadata *metadata, PageNumber pageNum, int *framedIndex)
+{
+    // a private pool has its page table, a shared pool's lives in the segment
+    if (metadata->segment == NULL)
+        return getValue(&(metadata->pageTable), pageNum, framedIndex);
+
+    for (int i = homeSlot(metadata, pageNum); metadata->pageSlots[i] != NO_SLOT; i = (i + 1) & metadata->pageSlotMask)
+    {
+        if (metadata->framePages[metadata->pageSlots[i]] == pageNum)
+        {
+            *framedIndex = metadata->pageSlots[i];
+            return 0;
+        }
+    }
+    return 1;
+}
+
+void mapPage(BM_Metadata *metadata, PageNumber pageNum, int framedIndex)
+{
+    if (metadata->segment == NULL)
+    {
+        setValue(&(metadata->pageTable), pageNum, framedIndex);
+        return;
+    }
+
+    // never full, there are twice as many slots as frames
+    int i = homeSlot(metadata, pageNum);
+    while (metadata->pageSlots[i] != NO_SLOT)
+        i = (i + 1) & metadata->pageSlotMask;
+    metadata->pageSlots[i] = framedIndex;
+}
+
+void unmapPage(BM_Metadata *metadata, PageNumber pageNum)
+{
+    if (metadata->segment == NULL)
+    {
+        removePair(&(metadata->pageTable), pageNum);
+        return;
+    }
+
+    int mask = metadata->pageSlotMask;
+    int hole = homeSlot(metadata, pageNum);
+    while (metadata->pageSlots[hole] != NO_SLOT && metadata->framePages[metadata->pageSlots[hole]] != pageNum)
+        hole = (hole + 1) & mask;
+    if (metadata->pageSlots[hole] == NO_SLOT)
+        return;
+
+    // move later entries of the run back into the hole unless that would put one before its
+    // home slot, so that lookups can stop at the first unused slot (no tombstones)
+    for (int i = (hole + 1) & mask; metadata->pageSlots[i] != NO_SLOT; i = (i + 1) & mask)
+    {
+        int home = homeSlot(metadata, metadata->framePages[metadata->pageSlots[i]]);
+        if (((i - home) & mask) >= ((i - hole) & mask))
+        {
+            metadata->pageSlots[hole] = metadata->pageSlots[i];
+            hole = i;
+        }
+    }
+    metadata->pageSlots[hole] = NO_SLOT;
+}
+
+void addDirtyFrame(BM_Metadata *metadata, int framedIndex)
+{
+    // already queued
+    if (metadata->dirtyIndex[framedIndex] != -1)
+        return;
+
+    metadata->dirty[framedIndex] = true;
+    metadata->dirtyIndex[framedIndex] = metadata->state->numberDirty;
+    metadata->dirtyFrames[metadata->state->numberDirty++] = framedIndex;
+}
+
+void removeDirtyFrame(BM_Metadata *metadata, int framedIndex)
+{
+    int dirtyIndex = metadata->dirtyIndex[framedIndex];
+
+    metadata->dirty[framedIndex] = false;
+    if (dirtyIndex == -1)
+        return;
+
+    // move the last entry into the hole so removal stays O(1)
+    int lastFrame = metadata->dirtyFrames[--metadata->state->numberDirty];
+    metadata->dirtyFrames[dirtyIndex] = lastFrame;
+    metadata->dirtyIndex[lastFrame] = dirtyIndex;
+    metadata->dirtyIndex[framedIndex] = -1;
+}
+
+static int compareFlushEntries(const void *a, const void *b)
+{
+    PageNumber left = ((const BM_FlushEntry *)a)->pageNum;
+    PageNumber right = ((const BM_FlushEntry *)b)->pageNum;
+    return (left > right) - (left < right);
+}
+
+static int comparePinRequests(const void *a, const void *b)
+{
+    PageNumber left = ((const BM_PinRequest *)a)->pageNum;
+    PageNumber right = ((const BM_PinRequest *)b)->pageNum;
+    return (left > right) - (left < right);
+}
+
+RC flushDirtyFrames(BM_BufferPool *const bm, int maxPages)
+{
+    BM_Metadata *metadata = (BM_Metadata *)bm->mgmtData;
+    RC result = RC_OK;
+
+    if (metadata->state->numberDirty == 0)
+        return RC_OK;
+
+    // collect the unpinned dirty frames, pinned ones are left for a later flush
+    BM_FlushEntry *entries = (BM_FlushEntry *)malloc(sizeof(BM_FlushEntry) * metadata->state->numberDirty);
+    SM_PageHandle *runData = (SM_PageHandle *)malloc(sizeof(SM_PageHandle) * metadata->state->numberDirty);
+    if (entries == NULL || runData == NULL)
+    {
+        free(entries);
+        free(runData);
+        return RC_ALLOCATION_FAILED;
+    }
+    int numEntries = 0;
+    for (int i = 0; i < metadata->state->numberDirty; i++)
+    {
+        int framedIndex = metadata->dirtyFrames[i];
+        if (metadata->fixCounts[framedIndex] == 0)
+        {
+            entries[numEntries].pageNum = metadata->framePages[framedIndex];
+            entries[numEntries].framedIndex = framedIndex;
+            numEntries++;
+        }
+    }
+    qsort(entries, numEntries, sizeof(BM_FlushEntry), compareFlushEntries);
+
+    // a partial flush continues the sweep from the cursor and wraps around
+    int first = 0;
+    int count = numEntries;
+    if (maxPages > 0)
+    {
+        while (first < numEntries && entries[first].pageNum < metadata->state->flushCursor)
+            first++;
+        if (first == numEntries)
+            first = 0;
+        if (count > maxPages)
+            count = maxPages;
+    }
+
+    // write the selected pages, merging runs of adjacent page numbers into one write
+    int written = 0;
+    while (written < count && result == RC_OK)
+    {
+        int runStart = (first + written) % numEntries;
+        int runLength = 1;
+        runData[0] = metadata->frameData[entries[runStart].framedIndex];
+        while (written + runLength < count)
+        {
+            int next = (first + written + runLength) % numEntries;
+            if (next == 0 || entries[next].pageNum != entries[runStart].pageNum + runLength)
+                break;
+            runData[runLength] = metadata->frameData[entries[next].framedIndex];
+            runLength++;
+        }
+
+        result = writeFrames(metadata, entries[runStart].pageNum, runLength, runData);
+        if (result == RC_OK)
+        {
+            for (int i = 0; i < runLength; i++)
+            {
+                int framedIndex = entries[runStart + i].framedIndex;
+                metadata->timeStamps[framedIndex] = getTimeStamp(metadata);
+                removeDirtyFrame(metadata, framedIndex);
+            }
+            metadata->state->numberWrite += runLength;
+            metadata->state->flushCursor = entries[runStart].pageNum + runLength;
+        }
+        written += runLength;
+    }
+
+    free(entries);
+    free(runData);
+    return result;
+}
+
+// append one record to the trace, stamped with the pool's logical clock
+void traceAccess(BM_Metadata *metadata, BM_TraceOp op, PageNumber pageNum)
+{
+    if (metadata->traceFile == NULL)
+        return;
+
+    BM_TraceRecord record;
+    record.timeStamp = metadata->state->timeStamp;
+    record.op = op;
+    record.pageNum = pageNum;
+    fwrite(&record, sizeof(BM_TraceRecord), 1, metadata->traceFile);
+}
+
+int getClassIndex(BM_Metadata *metadata, int pageClass)
+{
+    int classIndex;
+    if (pageClass < 0)
+        return -1;
+    if (getValue(&(metadata->classIndex), pageClass, &classIndex) == 0)
+        return classIndex;
+
+    // grow the class list if needed
+    if (metadata->numClasses == metadata->capacityClasses)
+    {
+        int capacity = metadata->capacityClasses + CLASS_LIST_SIZE;
+        BM_PageClass *classes = realloc(metadata->classes, sizeof(BM_PageClass) * capacity);
+        if (classes == NULL)
+            return -1;
+        metadata->classes = classes;
+        metadata->capacityClasses = capacity;
+    }
+
+    classIndex = metadata->numClasses;
+    if (setValue(&(metadata->classIndex), pageClass, classIndex) != 0)
+        return -1;
+    metadata->classes[classIndex].pageClass = pageClass;
+    metadata->classes[classIndex].reservedFrames = 0;
+    metadata->classes[classIndex].maxFrames = 0;
+    metadata->classes[classIndex].priority = 0;
+    metadata->classes[classIndex].numFrames = 0;
+    metadata->numClasses++;
+    return classIndex;
+}
+
+RC pinPageLocked(BM_BufferPool *const bm, BM_PageHandle *const page, const PageNumber pageNum)
+{
+    BM_Metadata *metadata = (BM_Metadata *)bm->mgmtData;
+    int framedIndex;
+    RC result = RC_OK;
+
+    // Feed the reference to the miss-ratio curve and the trace, hit or miss
+    if (metadata->missRatio.mgmt != NULL) {
+        recordAccess(&(metadata->missRatio), pageNum);
+    }
+    traceAccess(metadata, TRACE_PIN, pageNum);
+
+    // A page another caller is still reading is waited for instead of being read twice
+    // (the lookup is repeated since the read may have failed and released the frame)
+    while (findFrame(metadata, pageNum, &framedIndex) == 0 && metadata->ioInProgress[framedIndex]) {
+        waitForReads(metadata);
+    }
+
+    // Use a for loop to handle the retrieval and pinning of the page
+    for (int i = 0; i < 1; i++) {  // Loop will run exactly once
+        int getValueResult = findFrame(metadata, pageNum, &framedIndex);
+
+        if (getValueResult == 0) {  // Page is already in a frame
+            metadata->timeStamps[framedIndex] = getTimeStamp(metadata);
+            metadata->refBits[framedIndex] = 1;
+            metadata->fixCounts[framedIndex]++;
+            page->pageNum = pageNum;
+            page->data = metadata->frameData[framedIndex];
+        } else {  // Page is not in a frame, use replacement strategy
+            // Claim a victim frame before its data is filled in
+            result = claimFrame(bm, pageNum, &framedIndex);
+            if (result != RC_OK) {
+                break;
+            }
+
+            // Fill the frame from the victim cache, or from disk without holding the pool lock
+            if (metadata->victimCache.mgmt != NULL &&
+                takePage(&(metadata->victimCache), pageNum, metadata->frameData[framedIndex]) == 0) {
+                metadata->numberCacheHit++;
+            } else {
+                startRead(metadata, framedIndex);
+                pthread_mutex_unlock(&(metadata->state->poolLock));
+
+                lockLatch(&(metadata->state->fileLock));
+                result = ensureCapacity(pageNum + 1, &(metadata->pageFile));
+                if (result == RC_OK) {
+                    result = readBlock(pageNum, &(metadata->pageFile), metadata->frameData[framedIndex]);
+                }
+                pthread_mutex_unlock(&(metadata->state->fileLock));
+
+                lockPool(metadata);
+                metadata->ioInProgress[framedIndex] = false;
+                pthread_cond_broadcast(&(metadata->state->ioDone));
+
+                // A failed read gives the frame back, waiters then retry the read themselves
+                if (result != RC_OK) {
+                    releaseFrame(metadata, framedIndex);
+                    break;
+                }
+                metadata->state->numberRead++;
+            }
+            page->pageNum = pageNum;
+            page->data = metadata->frameData[framedIndex];
+        }
+        metadata->numberPinned++;
+    }
+
+    return result;
+}
+
+RC claimFrame(BM_BufferPool *const bm, const PageNumber pageNum, int *framedIndex)
+{
+    BM_Metadata *metadata = (BM_Metadata *)bm->mgmtData;
+
+    // the class quotas decide which frames the strategy may choose from
+    int pageClass = 0;
+    getValue(&(metadata->pageClasses), pageNum, &pageClass);
+    int classIndex = getClassIndex(metadata, pageClass);
+    if (classIndex == -1)
+        return RC_ALLOCATION_FAILED;
+    const int *busy = getVictimFilter(bm, classIndex);
+
+    switch (bm->strategy)
+    {
+        case RS_LRU:
+            *framedIndex = replacementLRU(bm, busy);
+            break;
+        case RS_FIFO:
+            *framedIndex = replacementFIFO(bm, busy);
+            break;
+        case RS_CLOCK:
+            *framedIndex = replacementCLOCK(bm, busy);
+            break;
+        default:
+            return RC_IM_CONFIG_ERROR;  // Configuration error if no strategy fits
+    }
+    // frames a dead process was reading stay pinned until they are given up
+    if (*framedIndex == -1 && metadata->segment != NULL && recoverReads(metadata) > 0)
+        return claimFrame(bm, pageNum, framedIndex);
+    if (*framedIndex == -1)
+        return RC_WRITE_FAILED;  // every frame is pinned
+
+    mapPage(metadata, pageNum, *framedIndex);
+    metadata->fixCounts[*framedIndex] = 1;
+    metadata->refBits[*framedIndex] = 1;
+    metadata->occupied[*framedIndex] = true;
+    metadata->dirty[*framedIndex] = false;
+    metadata->framePages[*framedIndex] = pageNum;
+    metadata->frameClasses[*framedIndex] = classIndex;
+    metadata->classes[classIndex].numFrames++;
+    return RC_OK;
+}
+
+void releaseFrame(BM_Metadata *metadata, int framedIndex)
+{
+    unswizzleFrame(metadata, framedIndex);
+    unmapPage(metadata, metadata->framePages[framedIndex]);
+    metadata->classes[metadata->frameClasses[framedIndex]].numFrames--;
+    metadata->fixCounts[framedIndex] = 0;
+    metadata->occupied[framedIndex] = false;
+    metadata->framePages[framedIndex] = NO_PAGE;
+}
+
+int getFrameOf(BM_BufferPool *const bm, const BM_PageHandle *const page)
+{
+    BM_Metadata *metadata = (BM_Metadata *)bm->mgmtData;
+
+    // the frames share one block, so the frame follows from the data pointer
+    if (page->data < metadata->frameData[0] || page->data >= metadata->frameData[0] + (size_t)PAGE_SIZE * bm->numPages)
+        return -1;
+    int framedIndex = (int)((page->data - metadata->frameData[0]) / PAGE_SIZE);
+    if (!metadata->occupied[framedIndex] || metadata->fixCounts[framedIndex] <= 0 ||
+        metadata->framePages[framedIndex] != page->pageNum)
+        return -1;
+    return framedIndex;
+}
+
+void swizzleLink(BM_Metadata *metadata, int fromIndex, PageNumber pageNum, int framedIndex)
+{
+    BM_Swip *link = &(metadata->frameLinks[fromIndex]);
+
+    // a frame is the target of at most one link, like a page has one parent in a chain
+    if (link->framedIndex != -1)
+        metadata->linkParents[link->framedIndex] = -1;
+    if (metadata->linkParents[framedIndex] != -1)
+        metadata->frameLinks[metadata->linkParents[framedIndex]].framedIndex = -1;
+
+    link->pageNum = pageNum;
+    link->framedIndex = framedIndex;
+    metadata->linkParents[framedIndex] = fromIndex;
+}
+
+void unswizzleFrame(BM_Metadata *metadata, int framedIndex)
+{
+    // the link pointing here keeps only the page number
+    if (metadata->linkParents[framedIndex] != -1)
+    {
+        metadata->frameLinks[metadata->linkParents[framedIndex]].framedIndex = -1;
+        metadata->linkParents[framedIndex] = -1;
+    }
+
+    // the frame's own link belonged to the page that leaves it
+    BM_Swip *link = &(metadata->frameLinks[framedIndex]);
+    if (link->framedIndex != -1)
+        metadata->linkParents[link->framedIndex] = -1;
+    link->pageNum = NO_PAGE;
+    link->framedIndex = -1;
+}
+
+const int *getVictimFilter(BM_BufferPool *const bm, int classIndex)
+{
+    BM_Metadata *metadata = (BM_Metadata *)bm->mgmtData;
+    BM_PageClass *classes = metadata->classes;
+    int *filter = metadata->victimFilter;
+    bool found = false;
+
+    // without quotas or priorities every unpinned frame is a candidate
+    if (!metadata->classesInUse)
+        return metadata->fixCounts;
+
+    // a class at its limit has to replace one of its own pages
+    if (classes[classIndex].maxFrames > 0 && classes[classIndex].numFrames >= classes[classIndex].maxFrames)
+    {
+        for (int i = 0; i < bm->numPages; i++)
+        {
+            filter[i] = metadata->fixCounts[i] != 0 || !metadata->occupied[i] || metadata->frameClasses[i] != classIndex;
+            found = found || filter[i] == 0;
+        }
+        if (found)
+            return filter;
+    }
+
+    // otherwise free frames go first (only they are candidates, whatever order the policy
+    // visits frames in), then frames of the lowest priority class that is above its reservation
+    int minPriority = INT_MAX;
+    for (int i = 0; i < bm->numPages; i++)
+    {
+        filter[i] = metadata->fixCounts[i] != 0 || metadata->occupied[i];
+        found = found || filter[i] == 0;
+        if (metadata->fixCounts[i] != 0 || !metadata->occupied[i])
+            continue;
+
+        BM_PageClass *frameClass = &classes[metadata->frameClasses[i]];
+        if (frameClass->numFrames > frameClass->reservedFrames && frameClass->priority < minPriority)
+            minPriority = frameClass->priority;
+    }
+    if (found)
+        return filter;
+
+    // every unpinned frame is reserved, fall back to the plain policy
+    if (minPriority == INT_MAX)
+        return metadata->fixCounts;
+
+    for (int i = 0; i < bm->numPages; i++)
+    {
+        BM_PageClass *frameClass = &classes[metadata->frameClasses[i]];
+        filter[i] = metadata->fixCounts[i] != 0 ||
+                    frameClass->numFrames <= frameClass->reservedFrames ||
+                    frameClass->priority != minPriority;
+    }
+    return filter;
 }
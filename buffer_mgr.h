@@ -33,6 +33,19 @@ typedef struct BM_PageHandle {
 	char *data;
 } BM_PageHandle;
 
+// Access trace records, written by startTrace and replayed by simulate_trace
+typedef enum BM_TraceOp {
+	TRACE_PIN = 0,
+	TRACE_UNPIN = 1,
+	TRACE_DIRTY = 2
+} BM_TraceOp;
+
+typedef struct BM_TraceRecord {
+	unsigned int timeStamp;
+	BM_TraceOp op;
+	PageNumber pageNum;
+} BM_TraceRecord;
+
 // convenience macros
 #define MAKE_POOL()					\
 		((BM_BufferPool *) malloc (sizeof(BM_BufferPool)))
@@ -44,15 +57,44 @@ typedef struct BM_PageHandle {
 RC initBufferPool(BM_BufferPool *const bm, const char *const pageFileName, 
 		const int numPages, ReplacementStrategy strategy,
 		void *stratData);
+// like initBufferPool, but the frames live in the POSIX shared-memory segment segmentName so that
+// every process initializing a pool with the same name, file and size shares them; the last
+// process to shut down removes the segment (victim cache, swizzling and page classes are
+// not available for a shared pool)
+RC initSharedBufferPool(BM_BufferPool *const bm, const char *const pageFileName, 
+		const int numPages, ReplacementStrategy strategy,
+		const char *const segmentName);
 RC shutdownBufferPool(BM_BufferPool *const bm);
 RC forceFlushPool(BM_BufferPool *const bm);
+RC flushSome(BM_BufferPool *const bm, int maxPages);
+RC setVictimCacheSize(BM_BufferPool *const bm, int capacity);
+RC enableMissRatioCurve(BM_BufferPool *const bm, int maxFrames, int samplingRate);
+RC setSwizzling(BM_BufferPool *const bm, bool enabled);
+RC startTrace(BM_BufferPool *const bm, const char *const traceFileName);
+RC stopTrace(BM_BufferPool *const bm);
+
+// Buffer Manager Interface Page Classes
+// pages are grouped into classes (class 0 by default) that can reserve frames,
+// be capped at a number of frames and be given a retention priority
+RC setPageClass (BM_BufferPool *const bm, const PageNumber pageNum, int pageClass);
+RC setClassQuota (BM_BufferPool *const bm, int pageClass, int reservedFrames, int maxFrames);
+RC setClassPriority (BM_BufferPool *const bm, int pageClass, int priority);
 
 // Buffer Manager Interface Access Pages
 RC markDirty (BM_BufferPool *const bm, BM_PageHandle *const page);
 RC unpinPage (BM_BufferPool *const bm, BM_PageHandle *const page);
 RC forcePage (BM_BufferPool *const bm, BM_PageHandle *const page);
+// writes a dirty page even while it is pinned (the caller holds a pin and must not be changing it)
+RC forcePinnedPage (BM_BufferPool *const bm, BM_PageHandle *const page);
 RC pinPage (BM_BufferPool *const bm, BM_PageHandle *const page, 
 		const PageNumber pageNum);
+// pins a page referenced from the pinned page from (e.g. its next page); with swizzling on
+// the reference is remembered with the frame so the next pin skips the page table
+RC pinNextPage (BM_BufferPool *const bm, BM_PageHandle *const page,
+		const BM_PageHandle *const from, const PageNumber pageNum);
+// pins numPages pages at once (all or none), reading the missing ones in page order
+RC pinPages (BM_BufferPool *const bm, BM_PageHandle *const handles,
+		const PageNumber *pageNums, int numPages);
 
 // Statistics Interface
 PageNumber *getFrameContents (BM_BufferPool *const bm);
@@ -60,5 +102,10 @@ bool *getDirtyFlags (BM_BufferPool *const bm);
 int *getFixCounts (BM_BufferPool *const bm);
 int getNumReadIO (BM_BufferPool *const bm);
 int getNumWriteIO (BM_BufferPool *const bm);
+int getNumDirtyPages (BM_BufferPool *const bm);
+int getNumVictimCacheHits (BM_BufferPool *const bm);
+int getNumSwizzledPins (BM_BufferPool *const bm);
+int getMissRatioCurveSize (BM_BufferPool *const bm);
+double *getMissRatioCurve (BM_BufferPool *const bm);
 
 #endif
@@ -78,6 +78,53 @@ sprintPageContent (BM_PageHandle *const page)
 	return message;
 }
 
+void
+printMissRatioCurve (BM_BufferPool *const bm)
+{
+	double *missRatio;
+	int maxSize;
+	int i;
+
+	missRatio = getMissRatioCurve(bm);
+	maxSize = getMissRatioCurveSize(bm);
+
+	printf("{");
+	printStrat(bm);
+	printf(" %i}: ", bm->numPages);
+
+	if (missRatio == NULL)
+	{
+		printf("no miss-ratio curve\n");
+		return;
+	}
+
+	for (i = 1; i <= maxSize; i++)
+		printf("%s[%i:%.3f]", ((i == 1) ? "" : ","), i, missRatio[i]);
+	printf("\n");
+	free(missRatio);
+}
+
+char *
+sprintMissRatioCurve (BM_BufferPool *const bm)
+{
+	double *missRatio;
+	int maxSize;
+	int i;
+	char *message;
+	int pos = 0;
+
+	missRatio = getMissRatioCurve(bm);
+	maxSize = getMissRatioCurveSize(bm);
+	message = (char *) malloc(256 + (24 * maxSize));
+	message[0] = '\0';
+
+	for (i = 1; missRatio != NULL && i <= maxSize; i++)
+		pos += sprintf(message + pos, "%s[%i:%.3f]", ((i == 1) ? "" : ","), i, missRatio[i]);
+
+	free(missRatio);
+	return message;
+}
+
 void
 printStrat (BM_BufferPool *const bm)
 {
@@ -8,6 +8,35 @@
 
 // implementations
 
+RC valueEquals(Value *left, Value *right, Value *result) {
+    // Check if the data types are the same
+    if (left->dt != right->dt) {
+        return RC_RM_COMPARE_VALUE_OF_DIFFERENT_DATATYPE; // Return error code for different data types
+    }
+
+    // Set the result data type to boolean
+    result->dt = DT_BOOL;
+
+    switch (left->dt) {
+        case DT_INT:
+            result->v.boolV = (left->v.intV == right->v.intV);
+            break;
+        case DT_FLOAT:
+            result->v.boolV = (left->v.floatV == right->v.floatV);
+            break;
+        case DT_BOOL:
+            result->v.boolV = (left->v.boolV == right->v.boolV);
+            break;
+        case DT_STRING:
+            result->v.boolV = (strcmp(left->v.stringV, right->v.stringV) == 0);
+            break;
+        default:
+            return RC_RM_UNKOWN_DATATYPE; // Handle unsupported data types
+    }
+
+    return RC_OK; // Return success
+}
+
 RC valueSmaller(Value *left, Value *right, Value *result) {
     // Check if the data types are the same
     if (left->dt != right->dt) {
@@ -33,7 +62,7 @@ RC valueSmaller(Value *left, Value *right, Value *result) {
                 result->v.boolV = (strcmp(left->v.stringV, right->v.stringV) < 0);
                 break;
             default:
-                return RC_UNSUPPORTED_DATATYPE; // Handle unsupported data types
+                return RC_RM_UNKOWN_DATATYPE; // Handle unsupported data types
         }
     }
 
@@ -57,6 +86,16 @@ RC boolNot(Value *input, Value *result) {
     return RC_OK; // Return success
 }
 
+RC
+boolAnd (Value *left, Value *right, Value *result)
+{
+	if (left->dt != DT_BOOL || right->dt != DT_BOOL)
+		THROW(RC_RM_BOOLEAN_EXPR_ARG_IS_NOT_BOOLEAN, "boolean AND requires boolean inputs");
+	result->v.boolV = (left->v.boolV && right->v.boolV);
+
+	return RC_OK;
+}
+
 RC
 boolOr (Value *left, Value *right, Value *result)
 {
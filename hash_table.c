@@ -1,123 +1,264 @@
 #include "hash_table.h"
 #include <stdlib.h>
+#include <string.h>
 
-#define ARRAY_LIST_SIZE 16
+// open addressing in the style of a Swiss table: a control byte per slot holds
+// EMPTY, DELETED or the low 7 bits of the key's hash, and a lookup compares a
+// whole group of control bytes at once before touching any slot
+
+#define MIN_CAPACITY 16
+// old slots moved to the new table by each operation while a resize is in progress
+#define MIGRATE_STEP 16
 
 typedef struct HT_KeyValuePair {
     int key;
     int value;
 } HT_KeyValuePair;
 
-typedef struct HT_ArrayList {
+typedef struct HT_Slots {
+    // capacity + HT_GROUP_SIZE control bytes, the last group mirrors the first
+    // so that a group starting near the end can be loaded in one go
+    signed char *ctrl;
+    HT_KeyValuePair *pairs;
     int capacity;
-    int size;
-    HT_KeyValuePair *list;
-} HT_ArrayList;
+    int used;
+    int deleted;
+} HT_Slots;
+
+typedef struct HT_Table {
+    HT_Slots current;
+    // the table being drained into current after a resize (capacity 0 when none)
+    HT_Slots old;
+    int migrated;
+} HT_Table;
 
-HT_ArrayList *AL_get(HT_TableHandle *const ht, int i)
+// murmur3 finalizer, spreads consecutive page numbers (and negative keys) over the table
+unsigned int HT_hash(int key)
 {
-    HT_ArrayList *ls = (HT_ArrayList *)ht->mgmt;
-    return &ls[i];
+    unsigned int h = (unsigned int)key;
+    h ^= h >> 16;
+    h *= 0x85ebca6bU;
+    h ^= h >> 13;
+    h *= 0xc2b2ae35U;
+    h ^= h >> 16;
+    return h;
 }
 
-int AL_push(HT_ArrayList *al, int key, int value)
+int HT_allocSlots(HT_Slots *slots, int capacity)
 {
-    if (al->size == al->capacity)
+    slots->ctrl = (signed char *)malloc(capacity + HT_GROUP_SIZE);
+    slots->pairs = (HT_KeyValuePair *)malloc(sizeof(HT_KeyValuePair) * capacity);
+    if (slots->ctrl == NULL || slots->pairs == NULL)
     {
-        al->capacity += ARRAY_LIST_SIZE;
-        al->list = realloc(al->list, sizeof(HT_KeyValuePair) * al->capacity);
-        if (al->list == NULL)
-            return 1;
+        free(slots->ctrl);
+        free(slots->pairs);
+        return 1;
     }
-    al->list[al->size].key = key;
-    al->list[al->size].value = value;
-    al->size++;
+    memset(slots->ctrl, HT_CTRL_EMPTY, capacity + HT_GROUP_SIZE);
+    slots->capacity = capacity;
+    slots->used = 0;
+    slots->deleted = 0;
     return 0;
 }
 
-void AL_remoteAt(HT_ArrayList *al, int i)
+void HT_freeSlots(HT_Slots *slots)
 {
-    if (i >= 0 && i < al->size) {
-        for (int j = i; j < al->size - 1; j++)
-            al->list[j] = al->list[j + 1];
-        al->size--;
+    free(slots->ctrl);
+    free(slots->pairs);
+    slots->ctrl = NULL;
+    slots->pairs = NULL;
+    slots->capacity = 0;
+    slots->used = 0;
+    slots->deleted = 0;
+}
+
+// probe until the key is found or a group with an EMPTY byte ends the chain
+// returns the slot index or -1
+int HT_find(const HT_Slots *slots, int key, unsigned int hash)
+{
+    HT_Probe probe;
+    if (slots->capacity == 0)
+        return -1;
+    for (HT_probeStart(&probe, hash, slots->capacity); probe.step <= slots->capacity; HT_probeNext(&probe))
+    {
+        const signed char *group = slots->ctrl + probe.pos;
+        for (unsigned int m = HT_match(group, HT_H2(hash)); m != 0; m &= m - 1)
+        {
+            int i = (probe.pos + __builtin_ctz(m)) & probe.mask;
+            if (slots->pairs[i].key == key)
+                return i;
+        }
+        if (HT_match(group, HT_CTRL_EMPTY) != 0)
+            return -1;
     }
+    return -1;
+}
+
+// store a key known to be absent in the first free slot of its probe sequence
+void HT_insert(HT_Slots *slots, int key, int value, unsigned int hash)
+{
+    int i = HT_findFree(slots->ctrl, slots->capacity, hash);
+    if (slots->ctrl[i] == HT_CTRL_DELETED)
+        slots->deleted--;
+    HT_setCtrl(slots->ctrl, slots->capacity, i, HT_H2(hash));
+    slots->pairs[i].key = key;
+    slots->pairs[i].value = value;
+    slots->used++;
+}
+
+void HT_erase(HT_Slots *slots, int i)
+{
+    slots->deleted += HT_eraseSlot(slots->ctrl, slots->capacity, i);
+    slots->used--;
 }
 
-// initialize hash table
-int initHashTable(HT_TableHandle *const ht, int size) 
+// move up to count old slots into the current table, freeing the old one when it is drained
+void HT_migrate(HT_Table *table, int count)
 {
-    ht->size = size;
-    ht->mgmt = malloc(sizeof(HT_ArrayList) * size);
-    for (int i = 0; i < size; i++)
+    HT_Slots *old = &table->old;
+    while (old->capacity > 0 && count-- > 0)
     {
-        HT_ArrayList *al = AL_get(ht, i);
-        al->list = malloc(sizeof(HT_KeyValuePair) * ARRAY_LIST_SIZE);
-        if (al->list == NULL)
-            return 1;
-        al->capacity = ARRAY_LIST_SIZE;
-        al->size = 0;
+        int i = table->migrated++;
+        // the moved slot turns DELETED so that lookups in the old table skip it but keep probing
+        if (old->ctrl[i] >= 0)
+        {
+            HT_insert(&table->current, old->pairs[i].key, old->pairs[i].value, HT_hash(old->pairs[i].key));
+            HT_setCtrl(old->ctrl, old->capacity, i, HT_CTRL_DELETED);
+        }
+        if (table->migrated == old->capacity)
+            HT_freeSlots(old);
     }
+}
+
+// make room for one more pair, keeping the load (including DELETED bytes) under 7/8
+// returns 0 on success and 1 if the larger table cannot be allocated
+int HT_reserve(HT_Table *table)
+{
+    HT_Slots *current = &table->current;
+    if ((current->used + current->deleted + 1) * 8 <= current->capacity * 7)
+        return 0;
+
+    // a resize still in progress is finished first, so that there is at most one old table
+    HT_migrate(table, table->old.capacity);
+
+    // double when more than half the slots hold pairs, else the DELETED bytes are just dropped
+    int capacity = current->capacity;
+    if (current->used * 2 > capacity)
+        capacity *= 2;
+    HT_Slots grown;
+    if (HT_allocSlots(&grown, capacity) != 0)
+        return 1;
+    table->old = *current;
+    table->current = grown;
+    table->migrated = 0;
+    HT_migrate(table, MIGRATE_STEP);
+    return 0;
+}
+
+// initialize hash table for about size keys, it grows as needed
+int initHashTable(HT_TableHandle *const ht, int size)
+{
+    HT_Table *table = (HT_Table *)malloc(sizeof(HT_Table));
+    if (table == NULL)
+        return 1;
+
+    int capacity = MIN_CAPACITY;
+    while (capacity * 7 < size * 8)
+        capacity *= 2;
+    if (HT_allocSlots(&table->current, capacity) != 0)
+    {
+        free(table);
+        return 1;
+    }
+    table->old.ctrl = NULL;
+    table->old.pairs = NULL;
+    table->old.capacity = 0;
+    table->migrated = 0;
+    ht->size = 0;
+    ht->mgmt = table;
     return 0;
 }
 
 // if the key is found then assign to value and return 0
 // else return 1
-int getValue(HT_TableHandle *const ht, int key, int *value) 
+int getValue(HT_TableHandle *const ht, int key, int *value)
 {
-    int i = key % ht->size;
-    HT_ArrayList *al  = AL_get(ht, i);
-    for (int j = 0; j < al->size; j++)
+    HT_Table *table = (HT_Table *)ht->mgmt;
+    unsigned int hash = HT_hash(key);
+
+    int i = HT_find(&table->current, key, hash);
+    if (i != -1)
     {
-        if (al->list[j].key == key)
-        {
-            *value = al->list[j].value;
-            return 0;
-        }
+        *value = table->current.pairs[i].value;
+        return 0;
+    }
+    i = HT_find(&table->old, key, hash);
+    if (i != -1)
+    {
+        *value = table->old.pairs[i].value;
+        return 0;
     }
     return 1;
 }
 
 // if the key exists, then assign value to it
 // else, add in a new HT_KeyValuePair
-int setValue(HT_TableHandle *const ht, int key, int value) 
+int setValue(HT_TableHandle *const ht, int key, int value)
 {
-    int i = key % ht->size;
-    HT_ArrayList *al  = AL_get(ht, i);
-    for (int j = 0; j < al->size; j++)
+    HT_Table *table = (HT_Table *)ht->mgmt;
+    unsigned int hash = HT_hash(key);
+
+    HT_migrate(table, MIGRATE_STEP);
+    int i = HT_find(&table->current, key, hash);
+    if (i != -1)
     {
-        if (al->list[j].key == key)
-        {
-            al->list[j].value = value;
-            return 0;
-        }
+        table->current.pairs[i].value = value;
+        return 0;
     }
-    return AL_push(al, key, value);
+    i = HT_find(&table->old, key, hash);
+    if (i != -1)
+    {
+        table->old.pairs[i].value = value;
+        return 0;
+    }
+
+    if (HT_reserve(table) != 0)
+        return 1;
+    HT_insert(&table->current, key, value, hash);
+    ht->size++;
+    return 0;
 }
 
-// remove a HT_KeyValuePair 
-int removePair(HT_TableHandle *const ht, int key) 
+// remove a HT_KeyValuePair
+int removePair(HT_TableHandle *const ht, int key)
 {
-    int i = key % ht->size;
-    HT_ArrayList *al  = AL_get(ht, i);
-    for (int j = 0; j < al->size; j++)
+    HT_Table *table = (HT_Table *)ht->mgmt;
+    unsigned int hash = HT_hash(key);
+
+    HT_migrate(table, MIGRATE_STEP);
+    int i = HT_find(&table->current, key, hash);
+    if (i != -1)
+        HT_erase(&table->current, i);
+    else
     {
-        if (al->list[j].key == key)
-        {
-            AL_remoteAt(al, j);
-            return 0;
-        }
+        i = HT_find(&table->old, key, hash);
+        if (i == -1)
+            return 1;
+        HT_erase(&table->old, i);
     }
-    return 1;
+    ht->size--;
+    return 0;
 }
 
 // free malloc's
 void freeHashTable(HT_TableHandle *const ht)
 {
-    for (int i = 0; i < ht->size; i++)
-    {
-        HT_ArrayList *al = AL_get(ht, i);
-        free(al->list);
-    }
-    free(ht->mgmt);
-}
\ No newline at end of file
+    HT_Table *table = (HT_Table *)ht->mgmt;
+    if (table == NULL)
+        return;
+    HT_freeSlots(&table->current);
+    HT_freeSlots(&table->old);
+    free(table);
+    ht->mgmt = NULL;
+    ht->size = 0;
+}
@@ -1,5 +1,13 @@
+#ifndef HASH_TABLE_H
+#define HASH_TABLE_H
+
+#include <stdint.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
 typedef struct HT_TableHandle {
-    int size;
+    int size; // number of pairs stored
     void *mgmt;
 } HT_TableHandle;
 
@@ -7,4 +15,100 @@ int initHashTable(HT_TableHandle *const ht, int size);
 int getValue(HT_TableHandle *const ht, int key, int *value);
 int setValue(HT_TableHandle *const ht, int key, int value);
 int removePair(HT_TableHandle *const ht, int key);
-void freeHashTable(HT_TableHandle *const ht);
\ No newline at end of file
+void freeHashTable(HT_TableHandle *const ht);
+
+// control bytes of the open-addressing tables (hash_table.c, kv_table.c): a slot is
+// EMPTY, DELETED or holds the low 7 bits of its key's hash, and is probed in groups
+#define HT_GROUP_SIZE 16
+#define HT_CTRL_EMPTY ((signed char)-128)
+#define HT_CTRL_DELETED ((signed char)-2)
+
+// bit i is set if control byte i of the group equals b
+static inline unsigned int HT_match(const signed char *group, signed char b)
+{
+#ifdef __SSE2__
+    __m128i ctrl = _mm_loadu_si128((const __m128i *)group);
+    return (unsigned int)_mm_movemask_epi8(_mm_cmpeq_epi8(ctrl, _mm_set1_epi8(b)));
+#else
+    unsigned int mask = 0;
+    for (int i = 0; i < HT_GROUP_SIZE; i++)
+        if (group[i] == b)
+            mask |= 1U << i;
+    return mask;
+#endif
+}
+
+// bit i is set if control byte i of the group is EMPTY or DELETED (both are negative)
+static inline unsigned int HT_matchFree(const signed char *group)
+{
+#ifdef __SSE2__
+    __m128i ctrl = _mm_loadu_si128((const __m128i *)group);
+    return (unsigned int)_mm_movemask_epi8(ctrl);
+#else
+    unsigned int mask = 0;
+    for (int i = 0; i < HT_GROUP_SIZE; i++)
+        if (group[i] < 0)
+            mask |= 1U << i;
+    return mask;
+#endif
+}
+
+
+// the low 7 bits of a hash, stored in the control byte of its slot
+#define HT_H2(hash) ((signed char)((hash) & 0x7F))
+
+// a probe sequence visits the groups in triangular order from the one picked by the high
+// hash bits, which visits every group of a power of two table once
+typedef struct HT_Probe {
+    int pos;
+    int step;
+    int mask;
+} HT_Probe;
+
+static inline void HT_probeStart(HT_Probe *probe, uint64_t hash, int capacity)
+{
+    probe->mask = capacity - 1;
+    probe->pos = (int)(hash >> 7) & probe->mask;
+    probe->step = HT_GROUP_SIZE;
+}
+
+static inline void HT_probeNext(HT_Probe *probe)
+{
+    probe->pos = (probe->pos + probe->step) & probe->mask;
+    probe->step += HT_GROUP_SIZE;
+}
+
+// set control byte i, and its mirror in the extra group past the end
+static inline void HT_setCtrl(signed char *ctrl, int capacity, int i, signed char c)
+{
+    ctrl[i] = c;
+    if (i < HT_GROUP_SIZE)
+        ctrl[capacity + i] = c;
+}
+
+// the first EMPTY or DELETED slot of a hash's probe sequence (the table is never full)
+static inline int HT_findFree(const signed char *ctrl, int capacity, uint64_t hash)
+{
+    HT_Probe probe;
+    unsigned int m;
+    HT_probeStart(&probe, hash, capacity);
+    while ((m = HT_matchFree(ctrl + probe.pos)) == 0)
+        HT_probeNext(&probe);
+    return (probe.pos + __builtin_ctz(m)) & probe.mask;
+}
+
+// empty slot i: if every group holding it also holds an EMPTY byte, no probe ever went on
+// past it and it can be EMPTY again, otherwise it stays in the chain as DELETED
+// returns 1 if the slot became DELETED and 0 if it became EMPTY
+static inline int HT_eraseSlot(signed char *ctrl, int capacity, int i)
+{
+    int mask = capacity - 1;
+    unsigned int emptyAfter = HT_match(ctrl + i, HT_CTRL_EMPTY);
+    unsigned int emptyBefore = HT_match(ctrl + ((i - HT_GROUP_SIZE) & mask), HT_CTRL_EMPTY);
+    int reusable = emptyAfter != 0 && emptyBefore != 0 &&
+                   __builtin_ctz(emptyAfter) + __builtin_clz(emptyBefore << 16) < HT_GROUP_SIZE;
+    HT_setCtrl(ctrl, capacity, i, reusable ? HT_CTRL_EMPTY : HT_CTRL_DELETED);
+    return !reusable;
+}
+
+#endif
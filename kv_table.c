@@ -0,0 +1,393 @@
+#include "kv_table.h"
+#include "hash_table.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+// same control-byte layout as hash_table.c, the slots point at entries in an arena:
+// each entry holds its hash (so a resize never touches the keys), the key and the value
+
+#define MIN_CAPACITY 16
+// the arena grows in blocks of this size (an entry that does not fit gets a block of its own)
+#define ARENA_BLOCK_SIZE (64 * 1024)
+#define ENTRY_ALIGN 8
+// freed entries up to FREE_CLASSES * ENTRY_ALIGN bytes are kept in one list per size,
+// larger ones share a single list
+#define FREE_CLASSES 64
+// lookups of a batch that are in flight at once (prefetched but not yet compared)
+#define BATCH_SIZE 16
+
+typedef struct KV_Entry {
+    uint64_t hash;
+    int keyLength;
+    int valueLength;
+    // room reserved for the value, an update that fits is done in place
+    int valueCapacity;
+    // keeps data on an ENTRY_ALIGN boundary
+    int padding;
+    // key bytes, then the value bytes from the next ENTRY_ALIGN boundary
+    char data[];
+} KV_Entry;
+
+typedef struct KV_Block {
+    struct KV_Block *next;
+    size_t used;
+    size_t capacity;
+    char data[];
+} KV_Block;
+
+// a freed entry, linked into a free list until an entry of its size is needed again
+typedef struct KV_FreeChunk {
+    struct KV_FreeChunk *next;
+    size_t size;
+} KV_FreeChunk;
+
+typedef struct KV_Table {
+    // capacity + HT_GROUP_SIZE control bytes, the last group mirrors the first
+    signed char *ctrl;
+    KV_Entry **entries;
+    int capacity;
+    int deleted;
+    // newest arena block first, the blocks are only freed with the table
+    KV_Block *arena;
+    // entries of removed or outgrown pairs, reused before the arena grows
+    KV_FreeChunk *freeChunks[FREE_CLASSES];
+    KV_FreeChunk *freeLarge;
+} KV_Table;
+
+// multiply-xorshift over 8-byte words, finished with the murmur3 64-bit mixer
+uint64_t KV_hash(const void *key, int keyLength)
+{
+    const unsigned char *bytes = (const unsigned char *)key;
+    uint64_t h = 0x9E3779B97F4A7C15ULL ^ (uint64_t)keyLength;
+    uint64_t word;
+    int i = 0;
+    for (; i + 8 <= keyLength; i += 8)
+    {
+        memcpy(&word, bytes + i, 8);
+        h = (h ^ word) * 0xFF51AFD7ED558CCDULL;
+        h ^= h >> 32;
+    }
+    if (i < keyLength)
+    {
+        word = 0;
+        memcpy(&word, bytes + i, keyLength - i);
+        h = (h ^ word) * 0xFF51AFD7ED558CCDULL;
+    }
+    h ^= h >> 33;
+    h *= 0xFF51AFD7ED558CCDULL;
+    h ^= h >> 33;
+    h *= 0xC4CEB9FE1A85EC53ULL;
+    h ^= h >> 33;
+    return h;
+}
+
+// where the value of an entry with a key of keyLength bytes starts
+#define VALUE_OFFSET(keyLength) (((keyLength) + ENTRY_ALIGN - 1) / ENTRY_ALIGN * ENTRY_ALIGN)
+
+#define ALIGN_SIZE(size) (((size) + ENTRY_ALIGN - 1) / ENTRY_ALIGN * ENTRY_ALIGN)
+
+// bytes of arena an entry occupies
+size_t KV_entrySize(KV_Entry *entry)
+{
+    return sizeof(KV_Entry) + VALUE_OFFSET(entry->keyLength) + entry->valueCapacity;
+}
+
+// give an entry's bytes back for reuse
+void KV_free(KV_Table *table, KV_Entry *entry)
+{
+    KV_FreeChunk *chunk = (KV_FreeChunk *)entry;
+    chunk->size = KV_entrySize(entry);
+    int sizeClass = (int)(chunk->size / ENTRY_ALIGN);
+    KV_FreeChunk **list = (sizeClass < FREE_CLASSES) ? &(table->freeChunks[sizeClass]) : &(table->freeLarge);
+    chunk->next = *list;
+    *list = chunk;
+}
+
+// take a freed chunk of at least *size bytes (a large one at most twice that) and
+// store its size in *size, returns NULL if there is none
+void *KV_reuse(KV_Table *table, size_t *size)
+{
+    int sizeClass = (int)(*size / ENTRY_ALIGN);
+    if (sizeClass < FREE_CLASSES)
+    {
+        KV_FreeChunk *chunk = table->freeChunks[sizeClass];
+        if (chunk != NULL)
+            table->freeChunks[sizeClass] = chunk->next;
+        return chunk;
+    }
+    for (KV_FreeChunk **link = &(table->freeLarge); *link != NULL; link = &((*link)->next))
+    {
+        KV_FreeChunk *chunk = *link;
+        if (chunk->size >= *size && chunk->size <= *size * 2)
+        {
+            *link = chunk->next;
+            *size = chunk->size;
+            return chunk;
+        }
+    }
+    return NULL;
+}
+
+// take at least *size bytes from the free lists or else carve them out of the arena,
+// the size obtained is stored in *size; returns NULL on failure
+void *KV_alloc(KV_Table *table, size_t *sizePtr)
+{
+    *sizePtr = ALIGN_SIZE(*sizePtr);
+    void *reused = KV_reuse(table, sizePtr);
+    if (reused != NULL)
+        return reused;
+
+    size_t size = *sizePtr;
+    KV_Block *block = table->arena;
+    if (block == NULL || block->used + size > block->capacity)
+    {
+        size_t capacity = (size > ARENA_BLOCK_SIZE) ? size : ARENA_BLOCK_SIZE;
+        block = (KV_Block *)malloc(sizeof(KV_Block) + capacity);
+        if (block == NULL)
+            return NULL;
+        block->used = 0;
+        block->capacity = capacity;
+        block->next = table->arena;
+        table->arena = block;
+    }
+    void *p = block->data + block->used;
+    block->used += size;
+    return p;
+}
+
+// probe for the key like HT_find, returns its slot or -1
+int KV_find(KV_Table *table, const void *key, int keyLength, uint64_t hash)
+{
+    HT_Probe probe;
+    for (HT_probeStart(&probe, hash, table->capacity); probe.step <= table->capacity; HT_probeNext(&probe))
+    {
+        const signed char *group = table->ctrl + probe.pos;
+        for (unsigned int m = HT_match(group, HT_H2(hash)); m != 0; m &= m - 1)
+        {
+            int i = (probe.pos + __builtin_ctz(m)) & probe.mask;
+            KV_Entry *entry = table->entries[i];
+            if (entry->hash == hash && entry->keyLength == keyLength && memcmp(entry->data, key, keyLength) == 0)
+                return i;
+        }
+        if (HT_match(group, HT_CTRL_EMPTY) != 0)
+            return -1;
+    }
+    return -1;
+}
+
+// put an entry whose key is known to be absent in the first free slot of its probe sequence
+void KV_place(KV_Table *table, KV_Entry *entry)
+{
+    int i = HT_findFree(table->ctrl, table->capacity, entry->hash);
+    if (table->ctrl[i] == HT_CTRL_DELETED)
+        table->deleted--;
+    HT_setCtrl(table->ctrl, table->capacity, i, HT_H2(entry->hash));
+    table->entries[i] = entry;
+}
+
+// rehash into a table with room for count pairs under 7/8 load, dropping DELETED slots
+// returns 0 on success and 1 on failure
+int KV_rehash(KV_Table *table, int count)
+{
+    int capacity = MIN_CAPACITY;
+    while (capacity * 7 < count * 8)
+        capacity *= 2;
+
+    signed char *ctrl = (signed char *)malloc(capacity + HT_GROUP_SIZE);
+    KV_Entry **entries = (KV_Entry **)malloc(sizeof(KV_Entry *) * capacity);
+    if (ctrl == NULL || entries == NULL)
+    {
+        free(ctrl);
+        free(entries);
+        return 1;
+    }
+    memset(ctrl, HT_CTRL_EMPTY, capacity + HT_GROUP_SIZE);
+
+    signed char *oldCtrl = table->ctrl;
+    KV_Entry **oldEntries = table->entries;
+    int oldCapacity = table->capacity;
+    table->ctrl = ctrl;
+    table->entries = entries;
+    table->capacity = capacity;
+    table->deleted = 0;
+    for (int i = 0; i < oldCapacity; i++)
+        if (oldCtrl[i] >= 0)
+            KV_place(table, oldEntries[i]);
+    free(oldCtrl);
+    free(oldEntries);
+    return 0;
+}
+
+// make sure count more pairs fit, returns 0 on success and 1 on failure
+int KV_reserve(KV_TableHandle *const kv, int count)
+{
+    KV_Table *table = (KV_Table *)kv->mgmt;
+    if ((kv->size + table->deleted + count) * 8 <= table->capacity * 7)
+        return 0;
+    // double when the live pairs need it, otherwise dropping the DELETED slots is enough
+    int target = kv->size + count;
+    if (target * 2 > table->capacity)
+        target *= 2;
+    return KV_rehash(table, target);
+}
+
+int initKeyTable(KV_TableHandle *const kv, int size)
+{
+    KV_Table *table = (KV_Table *)malloc(sizeof(KV_Table));
+    if (table == NULL)
+        return 1;
+    table->ctrl = NULL;
+    table->entries = NULL;
+    table->capacity = 0;
+    table->deleted = 0;
+    table->arena = NULL;
+    memset(table->freeChunks, 0, sizeof(table->freeChunks));
+    table->freeLarge = NULL;
+    if (KV_rehash(table, size) != 0)
+    {
+        free(table);
+        return 1;
+    }
+    kv->size = 0;
+    kv->mgmt = table;
+    return 0;
+}
+
+// store value under key, replacing the value of an existing key
+// returns 0 on success and 1 on failure
+int setKey(KV_TableHandle *const kv, const void *key, int keyLength, const void *value, int valueLength)
+{
+    KV_Table *table = (KV_Table *)kv->mgmt;
+    uint64_t hash = KV_hash(key, keyLength);
+
+    int i = KV_find(table, key, keyLength, hash);
+    if (i != -1 && table->entries[i]->valueCapacity >= valueLength)
+    {
+        KV_Entry *entry = table->entries[i];
+        memcpy(entry->data + VALUE_OFFSET(keyLength), value, valueLength);
+        entry->valueLength = valueLength;
+        return 0;
+    }
+
+    // a new key, or a value that outgrew its entry (the old entry is freed)
+    size_t size = sizeof(KV_Entry) + VALUE_OFFSET(keyLength) + valueLength;
+    KV_Entry *entry = (KV_Entry *)KV_alloc(table, &size);
+    if (entry == NULL)
+        return 1;
+    entry->hash = hash;
+    entry->keyLength = keyLength;
+    entry->valueLength = valueLength;
+    entry->valueCapacity = (int)(size - sizeof(KV_Entry) - VALUE_OFFSET(keyLength));
+    memcpy(entry->data, key, keyLength);
+    memcpy(entry->data + VALUE_OFFSET(keyLength), value, valueLength);
+
+    if (i != -1)
+    {
+        KV_free(table, table->entries[i]);
+        table->entries[i] = entry;
+        return 0;
+    }
+    if (KV_reserve(kv, 1) != 0)
+    {
+        KV_free(table, entry);
+        return 1;
+    }
+    KV_place((KV_Table *)kv->mgmt, entry);
+    kv->size++;
+    return 0;
+}
+
+// store count pairs, the table is grown once for all of them
+// returns the number of pairs stored
+int setKeys(KV_TableHandle *const kv, const void *const *keys, const int *keyLengths,
+            const void *const *values, const int *valueLengths, int count)
+{
+    int stored = 0;
+    if (KV_reserve(kv, count) != 0)
+        return 0;
+    for (int i = 0; i < count; i++)
+        if (setKey(kv, keys[i], keyLengths[i], values[i], valueLengths[i]) == 0)
+            stored++;
+    return stored;
+}
+
+// returns the table's copy of the value (valid until the key is set again or removed or the
+// table is freed) and its length in valueLength, or NULL if the key is absent
+void *getKey(KV_TableHandle *const kv, const void *key, int keyLength, int *valueLength)
+{
+    KV_Table *table = (KV_Table *)kv->mgmt;
+    int i = KV_find(table, key, keyLength, KV_hash(key, keyLength));
+    if (i == -1)
+        return NULL;
+    if (valueLength != NULL)
+        *valueLength = table->entries[i]->valueLength;
+    return table->entries[i]->data + VALUE_OFFSET(keyLength);
+}
+
+// look up count keys like getKey; the keys of a batch are hashed and their first
+// groups prefetched before any is probed, so the cache misses overlap
+// returns the number of keys found
+int getKeys(KV_TableHandle *const kv, const void *const *keys, const int *keyLengths, int count,
+            void **values, int *valueLengths)
+{
+    KV_Table *table = (KV_Table *)kv->mgmt;
+    uint64_t hashes[BATCH_SIZE];
+    int mask = table->capacity - 1;
+    int found = 0;
+
+    for (int start = 0; start < count; start += BATCH_SIZE)
+    {
+        int end = (start + BATCH_SIZE < count) ? start + BATCH_SIZE : count;
+        for (int k = start; k < end; k++)
+        {
+            hashes[k - start] = KV_hash(keys[k], keyLengths[k]);
+            int pos = (int)(hashes[k - start] >> 7) & mask;
+            __builtin_prefetch(table->ctrl + pos);
+            __builtin_prefetch(table->entries + pos);
+        }
+        for (int k = start; k < end; k++)
+        {
+            int i = KV_find(table, keys[k], keyLengths[k], hashes[k - start]);
+            values[k] = (i == -1) ? NULL : table->entries[i]->data + VALUE_OFFSET(keyLengths[k]);
+            if (valueLengths != NULL)
+                valueLengths[k] = (i == -1) ? 0 : table->entries[i]->valueLength;
+            if (i != -1)
+                found++;
+        }
+    }
+    return found;
+}
+
+// returns 0 if the key was removed and 1 if it is absent
+int removeKey(KV_TableHandle *const kv, const void *key, int keyLength)
+{
+    KV_Table *table = (KV_Table *)kv->mgmt;
+    int i = KV_find(table, key, keyLength, KV_hash(key, keyLength));
+    if (i == -1)
+        return 1;
+
+    table->deleted += HT_eraseSlot(table->ctrl, table->capacity, i);
+    KV_free(table, table->entries[i]);
+    kv->size--;
+    return 0;
+}
+
+// free malloc's
+void freeKeyTable(KV_TableHandle *const kv)
+{
+    KV_Table *table = (KV_Table *)kv->mgmt;
+    if (table == NULL)
+        return;
+    while (table->arena != NULL)
+    {
+        KV_Block *next = table->arena->next;
+        free(table->arena);
+        table->arena = next;
+    }
+    free(table->ctrl);
+    free(table->entries);
+    free(table);
+    kv->mgmt = NULL;
+    kv->size = 0;
+}
@@ -0,0 +1,20 @@
+#ifndef KV_TABLE_H
+#define KV_TABLE_H
+
+// a hash table with byte-string keys and values (a composite key is passed as its packed bytes)
+typedef struct KV_TableHandle {
+    int size; // number of pairs stored
+    void *mgmt;
+} KV_TableHandle;
+
+int initKeyTable(KV_TableHandle *const kv, int size);
+int setKey(KV_TableHandle *const kv, const void *key, int keyLength, const void *value, int valueLength);
+int setKeys(KV_TableHandle *const kv, const void *const *keys, const int *keyLengths,
+            const void *const *values, const int *valueLengths, int count);
+void *getKey(KV_TableHandle *const kv, const void *key, int keyLength, int *valueLength);
+int getKeys(KV_TableHandle *const kv, const void *const *keys, const int *keyLengths, int count,
+            void **values, int *valueLengths);
+int removeKey(KV_TableHandle *const kv, const void *key, int keyLength);
+void freeKeyTable(KV_TableHandle *const kv);
+
+#endif
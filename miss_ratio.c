@@ -0,0 +1,212 @@
+#include "miss_ratio.h"
+#include "hash_table.h"
+#include <stdlib.h>
+
+#define KEY_TABLE_SIZE 256
+#define TIME_LIST_SIZE 4096
+#define NO_KEY -1
+
+typedef struct MR_Curve {
+    // maps a sampled key to the time of its latest access; only the maxLive most recently
+    // used keys are kept, an older one is at a distance of maxSize or more and misses anyway
+    HT_TableHandle lastAccess;
+    // Fenwick tree over access times, with a 1 at every time that is some key's latest access
+    int *tree;
+    // the key whose latest access is at each time (NO_KEY if it was accessed again since)
+    int *timeKeys;
+    int capacity;
+    int now;
+    int live;
+    int maxLive;
+    // no live access is older than this time
+    int oldest;
+    // histogram[d] counts sampled reuses at (scaled) distance d, histogram[maxSize] counts
+    // longer distances and first accesses, which miss at every size
+    long *histogram;
+    long samples;
+} MR_Curve;
+
+// multiplicative hash so that whether a key is sampled does not depend on its low bits
+static unsigned int MR_hash(int key)
+{
+    unsigned int x = (unsigned int)key;
+    x ^= x >> 16;
+    x *= 0x45d9f3bu;
+    x ^= x >> 16;
+    return x;
+}
+
+static void MR_treeAdd(MR_Curve *curve, int time, int delta)
+{
+    for (int i = time + 1; i <= curve->capacity; i += i & -i)
+        curve->tree[i] += delta;
+}
+
+// number of live accesses at times [0, time)
+static int MR_treeCount(MR_Curve *curve, int time)
+{
+    int count = 0;
+    for (int i = time; i > 0; i -= i & -i)
+        count += curve->tree[i];
+    return count;
+}
+
+// renumber the live accesses to 0..live-1 so the time line can keep growing
+// returns 0 for success and 1 for failure
+static int MR_compact(MR_Curve *curve)
+{
+    int capacity = curve->live * 2 > TIME_LIST_SIZE ? curve->live * 2 : TIME_LIST_SIZE;
+    int *tree = (int *)calloc(capacity + 1, sizeof(int));
+    int *timeKeys = (int *)malloc(sizeof(int) * capacity);
+    if (tree == NULL || timeKeys == NULL)
+    {
+        free(tree);
+        free(timeKeys);
+        return 1;
+    }
+
+    int next = 0;
+    for (int t = 0; t < curve->now; t++)
+    {
+        if (curve->timeKeys[t] == NO_KEY)
+            continue;
+        timeKeys[next] = curve->timeKeys[t];
+        setValue(&curve->lastAccess, timeKeys[next], next);
+        next++;
+    }
+    for (int t = next; t < capacity; t++)
+        timeKeys[t] = NO_KEY;
+
+    free(curve->tree);
+    free(curve->timeKeys);
+    curve->tree = tree;
+    curve->timeKeys = timeKeys;
+    curve->capacity = capacity;
+    curve->now = next;
+    curve->oldest = 0;
+    for (int t = 0; t < next; t++)
+        MR_treeAdd(curve, t, 1);
+    return 0;
+}
+
+// initialize a curve for cache sizes 0..maxSize, tracking one in samplingRate keys
+int initMissRatio(MR_CurveHandle *const mr, int maxSize, int samplingRate)
+{
+    if (maxSize <= 0 || samplingRate <= 0)
+        return 1;
+
+    MR_Curve *curve = (MR_Curve *)malloc(sizeof(MR_Curve));
+    if (curve == NULL)
+        return 1;
+    curve->capacity = TIME_LIST_SIZE;
+    curve->now = 0;
+    curve->live = 0;
+    curve->maxLive = maxSize / samplingRate + 1;
+    curve->oldest = 0;
+    curve->samples = 0;
+    curve->tree = (int *)calloc(TIME_LIST_SIZE + 1, sizeof(int));
+    curve->timeKeys = (int *)malloc(sizeof(int) * TIME_LIST_SIZE);
+    curve->histogram = (long *)calloc(maxSize + 1, sizeof(long));
+    if (curve->tree == NULL || curve->timeKeys == NULL || curve->histogram == NULL ||
+        initHashTable(&curve->lastAccess, KEY_TABLE_SIZE) != 0)
+    {
+        free(curve->tree);
+        free(curve->timeKeys);
+        free(curve->histogram);
+        free(curve);
+        return 1;
+    }
+    for (int t = 0; t < TIME_LIST_SIZE; t++)
+        curve->timeKeys[t] = NO_KEY;
+
+    mr->maxSize = maxSize;
+    mr->samplingRate = samplingRate;
+    mr->mgmt = curve;
+    return 0;
+}
+
+// account one access to key (keys must not be negative)
+// returns 0 for success and 1 for failure
+int recordAccess(MR_CurveHandle *const mr, int key)
+{
+    MR_Curve *curve = (MR_Curve *)mr->mgmt;
+    int last;
+
+    if (MR_hash(key) % (unsigned int)mr->samplingRate != 0)
+        return 0;
+    curve->samples++;
+
+    if (getValue(&curve->lastAccess, key, &last) == 0)
+    {
+        // distinct sampled keys touched since the last access, scaled back up by the sampling rate
+        long distance = (long)(MR_treeCount(curve, curve->now) - MR_treeCount(curve, last + 1)) * mr->samplingRate;
+        curve->histogram[distance < mr->maxSize ? distance : mr->maxSize]++;
+        MR_treeAdd(curve, last, -1);
+        curve->timeKeys[last] = NO_KEY;
+        curve->live--;
+    }
+    else
+    {
+        curve->histogram[mr->maxSize]++;
+    }
+
+    // forget the least recently used key, its next access will count as a miss at every size
+    if (curve->live == curve->maxLive)
+    {
+        while (curve->timeKeys[curve->oldest] == NO_KEY)
+            curve->oldest++;
+        removePair(&curve->lastAccess, curve->timeKeys[curve->oldest]);
+        MR_treeAdd(curve, curve->oldest, -1);
+        curve->timeKeys[curve->oldest] = NO_KEY;
+        curve->live--;
+    }
+
+    if (curve->now == curve->capacity && MR_compact(curve) != 0)
+        return 1;
+
+    MR_treeAdd(curve, curve->now, 1);
+    curve->timeKeys[curve->now] = key;
+    curve->live++;
+    if (setValue(&curve->lastAccess, key, curve->now) != 0)
+        return 1;
+    curve->now++;
+    return 0;
+}
+
+// fill ratios[0..maxSize] with the estimated miss ratio of an LRU cache of each size
+// returns 0 for success and 1 if nothing was sampled yet
+int getMissRatios(MR_CurveHandle *const mr, double *ratios)
+{
+    MR_Curve *curve = (MR_Curve *)mr->mgmt;
+    long hits = 0;
+
+    if (curve->samples == 0)
+    {
+        for (int size = 0; size <= mr->maxSize; size++)
+            ratios[size] = 1.0;
+        return 1;
+    }
+
+    // an access at distance d hits in every cache larger than d
+    for (int size = 0; size <= mr->maxSize; size++)
+    {
+        if (size > 0)
+            hits += curve->histogram[size - 1];
+        ratios[size] = 1.0 - (double)hits / (double)curve->samples;
+    }
+    return 0;
+}
+
+// free malloc's
+void freeMissRatio(MR_CurveHandle *const mr)
+{
+    MR_Curve *curve = (MR_Curve *)mr->mgmt;
+    if (curve == NULL)
+        return;
+    freeHashTable(&curve->lastAccess);
+    free(curve->tree);
+    free(curve->timeKeys);
+    free(curve->histogram);
+    free(curve);
+    mr->mgmt = NULL;
+}
@@ -0,0 +1,19 @@
+#ifndef MISS_RATIO_H
+#define MISS_RATIO_H
+
+// online miss-ratio curve estimation (SHARDS: spatially hashed sampling of LRU reuse distances)
+// at most maxSize / samplingRate + 1 sampled keys are remembered at a time
+typedef struct MR_CurveHandle {
+    // largest cache size the curve is kept for
+    int maxSize;
+    // one in samplingRate keys is tracked
+    int samplingRate;
+    void *mgmt;
+} MR_CurveHandle;
+
+int initMissRatio(MR_CurveHandle *const mr, int maxSize, int samplingRate);
+int recordAccess(MR_CurveHandle *const mr, int key);
+int getMissRatios(MR_CurveHandle *const mr, double *ratios);
+void freeMissRatio(MR_CurveHandle *const mr);
+
+#endif
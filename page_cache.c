@@ -0,0 +1,246 @@
+#include "page_cache.h"
+#include "hash_table.h"
+#include "dberror.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define INDEX_TABLE_SIZE 64
+#define ENTRY_LIST_SIZE 16
+#define NO_ENTRY -1
+
+// longest literal run a single control byte can describe
+#define MAX_RUN 128
+
+typedef struct PC_Entry {
+    int pageNum;
+    int size;
+    char *data;
+    // neighbours in insertion order, oldest first
+    int prev;
+    int next;
+} PC_Entry;
+
+typedef struct PC_Cache {
+    PC_Entry *entries;
+    int capacity;
+    // unused entries are chained through next
+    int freeEntry;
+    int oldest;
+    int newest;
+    // maps a page number to its index in entries
+    HT_TableHandle index;
+} PC_Cache;
+
+// PackBits-style encoding, each control byte c is followed by
+//   c < 128:  c + 1 literal bytes
+//   c >= 128: one byte that is repeated c - 126 times
+// returns the compressed size, or -1 if the result would not be smaller than the page
+int PC_compress(const char *page, char *out)
+{
+    int in = 0, pos = 0;
+    while (in < PAGE_SIZE)
+    {
+        int run = 1;
+        while (in + run < PAGE_SIZE && run < MAX_RUN + 1 && page[in + run] == page[in])
+            run++;
+
+        if (run >= 2)
+        {
+            if (pos + 2 >= PAGE_SIZE)
+                return -1;
+            out[pos++] = (char)(run + 126);
+            out[pos++] = page[in];
+            in += run;
+            continue;
+        }
+
+        // collect literals until the next run of at least 3 equal bytes
+        int start = in, length = 0;
+        while (in < PAGE_SIZE && length < MAX_RUN)
+        {
+            if (in + 2 < PAGE_SIZE && page[in] == page[in + 1] && page[in] == page[in + 2])
+                break;
+            in++;
+            length++;
+        }
+        if (pos + 1 + length >= PAGE_SIZE)
+            return -1;
+        out[pos++] = (char)(length - 1);
+        memcpy(out + pos, page + start, length);
+        pos += length;
+    }
+    return pos;
+}
+
+void PC_decompress(const char *in, int size, char *page)
+{
+    int pos = 0, out = 0;
+    while (pos < size && out < PAGE_SIZE)
+    {
+        unsigned char control = (unsigned char)in[pos++];
+        if (control < MAX_RUN)
+        {
+            memcpy(page + out, in + pos, control + 1);
+            pos += control + 1;
+            out += control + 1;
+        }
+        else
+        {
+            memset(page + out, in[pos++], control - 126);
+            out += control - 126;
+        }
+    }
+}
+
+// unlink an entry from the insertion order, free its data and put it on the free chain
+void PC_release(PC_CacheHandle *const pc, int i)
+{
+    PC_Cache *cache = (PC_Cache *)pc->mgmt;
+    PC_Entry *entry = &cache->entries[i];
+
+    if (entry->prev != NO_ENTRY)
+        cache->entries[entry->prev].next = entry->next;
+    else
+        cache->oldest = entry->next;
+    if (entry->next != NO_ENTRY)
+        cache->entries[entry->next].prev = entry->prev;
+    else
+        cache->newest = entry->prev;
+
+    removePair(&cache->index, entry->pageNum);
+    pc->usedBytes -= entry->size;
+    free(entry->data);
+    entry->data = NULL;
+    entry->next = cache->freeEntry;
+    cache->freeEntry = i;
+}
+
+// get an unused entry, growing the entry list if needed
+// returns the entry index or NO_ENTRY on failure
+int PC_allocate(PC_Cache *cache)
+{
+    if (cache->freeEntry == NO_ENTRY)
+    {
+        int capacity = cache->capacity + ENTRY_LIST_SIZE;
+        PC_Entry *entries = realloc(cache->entries, sizeof(PC_Entry) * capacity);
+        if (entries == NULL)
+            return NO_ENTRY;
+        for (int i = cache->capacity; i < capacity; i++)
+        {
+            entries[i].data = NULL;
+            entries[i].next = (i + 1 < capacity) ? i + 1 : NO_ENTRY;
+        }
+        cache->freeEntry = cache->capacity;
+        cache->entries = entries;
+        cache->capacity = capacity;
+    }
+    int i = cache->freeEntry;
+    cache->freeEntry = cache->entries[i].next;
+    return i;
+}
+
+// initialize a cache that holds at most capacity bytes of compressed pages
+int initPageCache(PC_CacheHandle *const pc, int capacity)
+{
+    PC_Cache *cache = (PC_Cache *)malloc(sizeof(PC_Cache));
+    if (cache == NULL)
+        return 1;
+    cache->entries = NULL;
+    cache->capacity = 0;
+    cache->freeEntry = NO_ENTRY;
+    cache->oldest = cache->newest = NO_ENTRY;
+    if (initHashTable(&cache->index, INDEX_TABLE_SIZE) != 0)
+    {
+        free(cache);
+        return 1;
+    }
+    pc->capacity = capacity;
+    pc->usedBytes = 0;
+    pc->mgmt = cache;
+    return 0;
+}
+
+// forget a cached page, returns 0 if it was cached and 1 otherwise
+int PC_drop(PC_CacheHandle *const pc, int pageNum)
+{
+    PC_Cache *cache = (PC_Cache *)pc->mgmt;
+    int i;
+    if (getValue(&cache->index, pageNum, &i) != 0)
+        return 1;
+    PC_release(pc, i);
+    return 0;
+}
+
+// compress a page image into the cache, dropping the oldest pages to make room
+// returns 0 if the page was stored, 1 if it does not compress or does not fit
+int cachePage(PC_CacheHandle *const pc, int pageNum, const char *data)
+{
+    PC_Cache *cache = (PC_Cache *)pc->mgmt;
+    char buffer[PAGE_SIZE];
+    int i;
+
+    // a stale copy of the page is replaced
+    PC_drop(pc, pageNum);
+
+    int size = PC_compress(data, buffer);
+    if (size < 0 || size > pc->capacity)
+        return 1;
+
+    while (pc->usedBytes + size > pc->capacity)
+        PC_release(pc, cache->oldest);
+
+    i = PC_allocate(cache);
+    if (i == NO_ENTRY)
+        return 1;
+    PC_Entry *entry = &cache->entries[i];
+    entry->data = (char *)malloc(size);
+    if (entry->data == NULL)
+    {
+        entry->next = cache->freeEntry;
+        cache->freeEntry = i;
+        return 1;
+    }
+    memcpy(entry->data, buffer, size);
+    entry->pageNum = pageNum;
+    entry->size = size;
+
+    // append as the newest entry
+    entry->prev = cache->newest;
+    entry->next = NO_ENTRY;
+    if (cache->newest != NO_ENTRY)
+        cache->entries[cache->newest].next = i;
+    else
+        cache->oldest = i;
+    cache->newest = i;
+    pc->usedBytes += size;
+    setValue(&cache->index, pageNum, i);
+    return 0;
+}
+
+// if the page is cached, decompress it into data and remove it from the cache
+// returns 0 on a hit and 1 on a miss
+int takePage(PC_CacheHandle *const pc, int pageNum, char *data)
+{
+    PC_Cache *cache = (PC_Cache *)pc->mgmt;
+    int i;
+    if (getValue(&cache->index, pageNum, &i) != 0)
+        return 1;
+    PC_decompress(cache->entries[i].data, cache->entries[i].size, data);
+    PC_release(pc, i);
+    return 0;
+}
+
+// free malloc's
+void freePageCache(PC_CacheHandle *const pc)
+{
+    PC_Cache *cache = (PC_Cache *)pc->mgmt;
+    if (cache == NULL)
+        return;
+    for (int i = 0; i < cache->capacity; i++)
+        free(cache->entries[i].data);
+    free(cache->entries);
+    freeHashTable(&cache->index);
+    free(cache);
+    pc->mgmt = NULL;
+    pc->usedBytes = 0;
+}
@@ -0,0 +1,16 @@
+#ifndef PAGE_CACHE_H
+#define PAGE_CACHE_H
+
+// a bounded in-memory cache of compressed page images, keyed by page number
+typedef struct PC_CacheHandle {
+    int capacity;
+    int usedBytes;
+    void *mgmt;
+} PC_CacheHandle;
+
+int initPageCache(PC_CacheHandle *const pc, int capacity);
+int cachePage(PC_CacheHandle *const pc, int pageNum, const char *data);
+int takePage(PC_CacheHandle *const pc, int pageNum, char *data);
+void freePageCache(PC_CacheHandle *const pc);
+
+#endif
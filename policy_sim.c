@@ -0,0 +1,195 @@
+#include "policy_sim.h"
+#include "hash_table.h"
+#include <stdlib.h>
+
+typedef struct PS_Frame {
+    PageNumber pageNum;
+    int fixCount;
+    int dirty;
+    int refBit;
+    // logical time of the last pin or dirty mark (the buffer manager's LRU timestamp)
+    unsigned long stamp;
+    // pins since the page was loaded, for LFU
+    long pinCount;
+    // times of the last PS_LRU_K pins, newest first (0 if the page was pinned less often)
+    unsigned long history[PS_LRU_K];
+} PS_Frame;
+
+typedef struct PS_Pool {
+    PS_Frame *frames;
+    int numFrames;
+    // page number to frame index
+    HT_TableHandle pageTable;
+    unsigned long clock;
+    int queuedIndex;
+    int clockHand;
+} PS_Pool;
+
+// record a pin of a frame for LRU, CLOCK, LFU and LRU-K
+static void PS_touch(PS_Pool *pool, int i)
+{
+    PS_Frame *frame = &pool->frames[i];
+    frame->stamp = ++pool->clock;
+    frame->refBit = 1;
+    frame->pinCount++;
+    for (int k = PS_LRU_K - 1; k > 0; k--)
+        frame->history[k] = frame->history[k - 1];
+    frame->history[0] = frame->stamp;
+}
+
+// pick the frame to load a page into, the same way replacementFIFO / LRU / CLOCK do
+// returns -1 if every frame is pinned
+static int PS_victim(PS_Pool *pool, ReplacementStrategy strategy)
+{
+    PS_Frame *frames = pool->frames;
+    int n = pool->numFrames;
+    int victim = -1;
+
+    switch (strategy)
+    {
+        case RS_FIFO:
+            for (int j = 1; j <= n && victim == -1; j++)
+            {
+                int i = (pool->queuedIndex + j) % n;
+                if (frames[i].fixCount == 0)
+                    victim = i;
+            }
+            if (victim != -1)
+                pool->queuedIndex = victim;
+            break;
+        case RS_CLOCK:
+            // the first sweep clears every ref bit it passes, pinned frames included
+            for (int j = 0; j < 2 * n && victim == -1; j++)
+            {
+                int i = (pool->clockHand + j) % n;
+                if (frames[i].fixCount == 0 && frames[i].refBit == 0)
+                    victim = i;
+                else frames[i].refBit = 0;
+            }
+            if (victim != -1)
+                pool->clockHand = (victim + 1) % n;
+            break;
+        case RS_LRU:
+        case RS_LFU:
+        case RS_LRU_K:
+            for (int i = 0; i < n; i++)
+            {
+                if (frames[i].fixCount != 0)
+                    continue;
+                if (victim == -1)
+                {
+                    victim = i;
+                    continue;
+                }
+                // older pages win ties, and empty frames (never pinned) go first
+                PS_Frame *a = &frames[i];
+                PS_Frame *b = &frames[victim];
+                int better;
+                if (strategy == RS_LFU && a->pinCount != b->pinCount)
+                    better = a->pinCount < b->pinCount;
+                else if (strategy == RS_LRU_K && a->history[PS_LRU_K - 1] != b->history[PS_LRU_K - 1])
+                    better = a->history[PS_LRU_K - 1] < b->history[PS_LRU_K - 1];
+                else better = a->stamp < b->stamp;
+                if (better)
+                    victim = i;
+            }
+            break;
+        default:
+            break;
+    }
+    return victim;
+}
+
+// replay the trace on numFrames simulated frames
+// returns 0, or 1 for an unknown strategy or if memory runs out
+int simulatePolicy(const BM_TraceRecord *records, long count, ReplacementStrategy strategy,
+                   int numFrames, PS_Result *result)
+{
+    PS_Pool pool;
+    int i;
+
+    if (strategy < RS_FIFO || strategy > RS_LRU_K || numFrames <= 0)
+        return 1;
+    pool.frames = (PS_Frame *)calloc(numFrames, sizeof(PS_Frame));
+    if (pool.frames == NULL)
+        return 1;
+    if (initHashTable(&pool.pageTable, numFrames) != 0)
+    {
+        free(pool.frames);
+        return 1;
+    }
+    pool.numFrames = numFrames;
+    pool.clock = 0;
+    // initBufferPool starts FIFO after the last frame and the clock at the first
+    pool.queuedIndex = numFrames - 1;
+    pool.clockHand = 0;
+    for (i = 0; i < numFrames; i++)
+    {
+        pool.frames[i].pageNum = NO_PAGE;
+        pool.frames[i].stamp = ++pool.clock;
+    }
+
+    result->pins = result->hits = result->misses = result->writeBacks = result->failed = 0;
+    for (long r = 0; r < count; r++)
+    {
+        PageNumber pageNum = records[r].pageNum;
+        int found = getValue(&pool.pageTable, pageNum, &i) == 0;
+        switch (records[r].op)
+        {
+            case TRACE_PIN:
+                result->pins++;
+                if (found)
+                {
+                    pool.frames[i].fixCount++;
+                    PS_touch(&pool, i);
+                    result->hits++;
+                    break;
+                }
+                i = PS_victim(&pool, strategy);
+                if (i == -1)
+                {
+                    result->failed++;
+                    break;
+                }
+                PS_Frame *frame = &pool.frames[i];
+                if (frame->pageNum != NO_PAGE)
+                {
+                    if (frame->dirty)
+                        result->writeBacks++;
+                    removePair(&pool.pageTable, frame->pageNum);
+                }
+                frame->pageNum = pageNum;
+                frame->fixCount = 1;
+                frame->dirty = 0;
+                frame->pinCount = 0;
+                for (int k = 0; k < PS_LRU_K; k++)
+                    frame->history[k] = 0;
+                PS_touch(&pool, i);
+                if (setValue(&pool.pageTable, pageNum, i) != 0)
+                {
+                    freeHashTable(&pool.pageTable);
+                    free(pool.frames);
+                    return 1;
+                }
+                result->misses++;
+                break;
+            case TRACE_UNPIN:
+                if (found && pool.frames[i].fixCount > 0)
+                    pool.frames[i].fixCount--;
+                break;
+            case TRACE_DIRTY:
+                if (found)
+                {
+                    pool.frames[i].stamp = ++pool.clock;
+                    pool.frames[i].dirty = 1;
+                }
+                break;
+            default:
+                break;
+        }
+    }
+
+    freeHashTable(&pool.pageTable);
+    free(pool.frames);
+    return 0;
+}
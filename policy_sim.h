@@ -0,0 +1,24 @@
+#ifndef POLICY_SIM_H
+#define POLICY_SIM_H
+
+#include "buffer_mgr.h"
+
+// in-memory replay of an access trace against a replacement strategy, without a page file
+// FIFO, LRU and CLOCK pick the same victims as the buffer manager, LFU evicts the page
+// pinned least often since it was loaded and LRU-K the page with the oldest K-th last pin
+#define PS_LRU_K 2
+
+typedef struct PS_Result {
+    long pins;
+    long hits;
+    long misses;
+    // dirty pages evicted during the replay, pages still dirty at the end are not counted
+    long writeBacks;
+    // pins that failed because every frame was pinned
+    long failed;
+} PS_Result;
+
+int simulatePolicy(const BM_TraceRecord *records, long count, ReplacementStrategy strategy,
+                   int numFrames, PS_Result *result);
+
+#endif
@@ -2,24 +2,44 @@
 #include "buffer_mgr.h"
 #include "storage_mgr.h"
 #include "record_mgr.h"
+#include "kv_table.h"
 #include <stdlib.h>
 #include <unistd.h>
 #include <string.h>
+#include <stdint.h>
 
 /* Macros */
 
 #define PAGE_FILE_NAME "DATA.bin"
 #define TABLE_NAME_SIZE 16
 #define ATTR_NAME_SIZE 16
-#define MAX_NUM_ATTR 8
+#define MAX_NUM_ATTR 16
 #define MAX_NUM_KEYS 4
-#define MAX_NUM_TABLES PAGE_SIZE / (sizeof(ResourceManagerSchema) + sizeof(int) * 2)
-
+// "RM" and the version of the catalog layout, a page file of another version is not opened
+// (version 2 allows MAX_NUM_ATTR attributes and chains catalog pages)
+#define CATALOG_FORMAT 0x524D0002
+// the table entries of page 0 follow the catalog, more entries go on catalog pages chained after it
+#define CATALOG_PAGE_OFFSET(pageIndex) ((pageIndex) == 0 ? (sizeof(RM_SystemCatalog) + sizeof(uint64_t) - 1) / sizeof(uint64_t) * sizeof(uint64_t) : 0)
+#define CATALOG_PAGE_TABLES(pageIndex) ((PAGE_SIZE - CATALOG_PAGE_OFFSET(pageIndex) - sizeof(RM_CatalogPage)) / sizeof(ResourceManagerSchema))
+// the slot map (one bit per slot, set = in use) starts at the first word boundary after the page header
+#define SLOT_WORD_BITS 64
+#define SLOT_MAP_OFFSET ((sizeof(RM_PageHeader) + sizeof(uint64_t) - 1) / sizeof(uint64_t) * sizeof(uint64_t))
+// flags kept in the top bits of a slot directory length
+#define SLOT_FORWARD 0x8000     // the slot holds the RID its record moved to
+#define SLOT_MOVED 0x4000       // the tuple belongs to a slot of another page and starts with its RID
+#define SLOT_LENGTH_MASK 0x3FFF
+#define BUFFER_POOL_SIZE 16
+// bytes of compressed evicted pages kept in memory behind the buffer pool
+#define VICTIM_CACHE_SIZE (64 * PAGE_SIZE)
+// follow page chains through swizzled frame links instead of the page table
+#define SWIZZLE_PAGE_CHAINS TRUE
+
+// (header is set for every page but not every user reads it)
 #define USE_PAGE_HANDLE_HEADER(errorValue) \
 int const error = errorValue; \
 RC result; \
 BM_PageHandle handle; \
-RM_PageHeader *header; 
+RM_PageHeader *header __attribute__((unused)); 
 
 #define BEGIN_USE_PAGE_HANDLE_HEADER(pageNum) \
 result = pinPage(&bufferPool, &handle, pageNum); \
@@ -40,48 +60,215 @@ typedef struct ResourceManagerSchema {
     int typeLength[MAX_NUM_ATTR];
     int keySize;
     int keyAttrs[MAX_NUM_KEYS];
+    // RM_LAYOUT_ROW, RM_LAYOUT_PAX or RM_LAYOUT_COLUMN
+    int layout;
+    // the count as of the last checkpoint, inserts and deletes since then are counted by the open table
     int numTuples;
     int pageNum;
-    BM_PageHandle *handle;
+    // first page of the table's free-space list (NO_PAGE when every page is full)
+    int freeSpacePage;
 } ResourceManagerSchema;
 
 typedef struct RM_SystemCatalog {
+    // CATALOG_FORMAT of the code that created the page file
+    int format;
     int totalNumPages;
     int freePage;
     int numTables;
-    ResourceManagerSchema tables[MAX_NUM_TABLES];
+    int numCatalogPages;
+    // catalog pages before this one have no free entry
+    int firstOpenCatalogPage;
 } RM_SystemCatalog;
 
+// the table entries of a catalog page, an entry keeps its slot (and index) for the life of
+// its table and is free while its name is empty
+typedef struct RM_CatalogPage {
+    int nextCatalogPage;
+    int numTables;
+    ResourceManagerSchema tables[];
+} RM_CatalogPage;
+
+// what the record manager keeps about an open table besides its catalog entry, none of it is written to the page file
+typedef struct RM_TableState {
+    ResourceManagerSchema *entry;
+    int tableIndex;
+    // inserts and deletes since the last checkpoint (changed atomically) so that they do not dirty the catalog page
+    int pendingTuples;
+    // open scans, an overflow page emptied while one is open stays in the chain until the last one closes
+    int numScans;
+    // records lent in place by borrowRecord, their pages are kept the same way as a scan's
+    int numBorrows;
+    int numEmptyPages;
+    // the table's main page, kept pinned while the table is open
+    BM_PageHandle *handle;
+    // the catalog page of the entry, kept pinned while the table is open
+    BM_PageHandle *entryHandle;
+} RM_TableState;
+
 typedef struct RM_PageHeader {
     int nextPage;
     int prevPage;
     int numSlots;
+    int numFree;
+    // pages with a free slot and room for the largest tuple are on their table's free-space list,
+    // prevFreeSpace is only kept up to date for the pages after the first one
+    int nextFreeSpace;
+    int prevFreeSpace;
+    int onFreeSpaceList;
+    // bytes not taken by tuples, including the holes that compaction closes
+    int freeBytes;
+    // start of the tuples, which fill the page from its end towards the slot directory
+    int heapStart;
+    // a PAX page has no slot directory, a column array per attribute follows its slot map instead,
+    // and on a row group page of a column table the columns give their first segment instead
+    int layout;
+    int numColumns;
+    uint16_t columnOffsets[MAX_NUM_ATTR];
+    uint16_t columnSizes[MAX_NUM_ATTR];
 } RM_PageHeader;
 
+typedef union RM_ColumnBound {
+    int intV;
+    float floatV;
+} RM_ColumnBound;
+
+// a page of one column's values for a run of rows of a row group, with the smallest and
+// largest value ever written to it (only numbers and booleans keep a range)
+typedef struct RM_ColumnSegment {
+    int pageNum;
+    int hasRange;
+    RM_ColumnBound min;
+    RM_ColumnBound max;
+} RM_ColumnSegment;
+
+// where the tuple of a slot lies in its page
+typedef struct RM_SlotEntry {
+    uint16_t offset;
+    uint16_t length;
+} RM_SlotEntry;
+
 typedef struct RM_ScanData {
     RID id;
     Expr *cond;
+    // the page being scanned, pinned by the scan unless it is the table's main page
+    BM_PageHandle handle;
+    // the record unpacked from the page when it cannot be read in place, NULL otherwise
+    char *tuple;
+    // the attributes the condition reads (a bit per attribute), the only columns a PAX page
+    // gives the condition before it matches
+    int condAttrs;
+    // the attributes the caller wants, the others are left zeroed on PAX and column pages
+    int projAttrs;
+    // the segment pages a column table scan holds, one per column (NO_PAGE when none)
+    BM_PageHandle segments[MAX_NUM_ATTR];
+    // the rows of a row group up to segmentEnd lie in the same segments of the condition's
+    // columns, and their ranges tell segmentMatches if any of them can match
+    int segmentEnd;
+    bool segmentMatches;
 } RM_ScanData;
 
+typedef struct RM_BulkLoadData {
+    // the page being filled, kept pinned (pageNum is NO_PAGE before the first record)
+    BM_PageHandle handle;
+    // the new pages form a chain of their own until finishBulkLoad links it into the table
+    int firstPage;
+    int maxStored;
+    int numLoaded;
+} RM_BulkLoadData;
+
+// one RID of a getRecords call and the position of its record in the caller's array
+typedef struct RM_RecordRequest {
+    RID id;
+    int index;
+} RM_RecordRequest;
+
 /* Global variables */
 
 BM_BufferPool bufferPool;
 BM_PageHandle catalogPageHandle;
+// maps a table name to the index of its catalog entry
+KV_TableHandle tableNames;
+// the page numbers of the catalog pages, page 0 first (numbered as they are found or added)
+int *catalogPageNums;
+// the state of the open tables by the index of their catalog entries (NULL for a closed table)
+RM_TableState **openTables;
+int numOpenTableSlots;
 
 /* Declarations */
 
 RM_SystemCatalog* getSystemCatalog();
 RC markSystemCatalogDirty();
-ResourceManagerSchema *getTableByName(char *name);
+RC markTableDirty(RM_TableState *table);
+void addPendingTuples(RM_TableState *table, int count);
+void checkpointTableEntry(RM_TableState *table);
+int getTableIndex(char *name);
+RM_CatalogPage *getCatalogPage(BM_PageHandle *handle, int pageIndex);
+int getFirstTableIndex(int pageIndex);
+int getCatalogPageIndex(int tableIndex);
+ResourceManagerSchema *pinTableEntry(int tableIndex, BM_PageHandle *handle);
+RM_TableState *getOpenTable(int tableIndex);
+int addCatalogPage();
+int takeTableEntry();
+int indexTableNames();
+int flushTablePages();
 RM_PageHeader *getPageHeader(BM_PageHandle* handle);
-bool *getSlots(BM_PageHandle* handle);
-char *getTupleData(BM_PageHandle* handle);
+uint64_t *getSlotMap(BM_PageHandle* handle);
+int getSlotMapWords(int numSlots);
+bool isSlotUsed(const uint64_t *slotMap, int slot);
+void setSlotUsed(uint64_t *slotMap, int slot, bool used);
+int findFreeSlot(const uint64_t *slotMap, int numSlots);
+int findUsedSlot(const uint64_t *slotMap, int numSlots, int from);
+RM_SlotEntry *getSlotDirectory(BM_PageHandle* handle);
+int getDirectoryEnd(int numSlots);
+int getStoredSize(int length);
+bool isRecordSlot(BM_PageHandle* handle, int slot);
+bool isForwarded(BM_PageHandle* handle, int slot);
 int getFreePage();
-int setFreePage(BM_PageHandle* handle);
+int setFreePage(BM_PageHandle* page);
 int appendToFreeList(int pageNum);
 int getAttrSize(Schema *schema, int attrIndex);
-int getNextSlotInWalk(ResourceManagerSchema *table, BM_PageHandle **handle, bool** slots, int *slotIndex);
-int closeSlotWalk(ResourceManagerSchema *table, BM_PageHandle **handle);
+int *computeAttrOffsets(Schema *schema);
+bool isFixedLayout(Schema *schema);
+bool isStoredInPlace(RM_TableState *table, Schema *schema);
+int packTuple(Schema *schema, const char *data, char *tuple);
+void unpackTuple(Schema *schema, const char *tuple, char *data);
+int encodeRecord(RM_TableState *table, Schema *schema, const char *data, char *tuple);
+int getMaxStoredSize(Schema *schema);
+int layoutPaxColumns(Schema *schema, int numSlots, uint16_t *offsets);
+void scatterColumns(BM_PageHandle *handle, int slot, const char *data);
+void gatherColumns(BM_PageHandle *handle, int slot, int attrs, char *data);
+int getExprAttrs(Expr *expr);
+RM_ColumnSegment *getColumnSegments(BM_PageHandle *handle);
+RM_ColumnSegment *getRowSegment(BM_PageHandle *handle, int column, int slot, int *offset);
+int layoutColumnGroup(Schema *schema, int numSlots, uint16_t *firstSegments);
+void widenSegmentRange(RM_ColumnSegment *segment, DataType type, const char *value);
+RC writeColumns(RM_TableState *table, Schema *schema, BM_PageHandle *handle, int slot, const char *data);
+RC readColumns(RM_TableState *table, BM_PageHandle *handle, int slot, int attrs, BM_PageHandle *segments, char *data);
+int getNumSegments(RM_PageHeader *header);
+int freeColumnSegments(BM_PageHandle *group);
+int freeTableSegments(int pageNum);
+bool segmentMayMatch(Expr *expr, Schema *schema, BM_PageHandle *handle, int slot, bool negated);
+int getRecordsPerPage(Schema *schema, int layout);
+void formatTablePage(BM_PageHandle *handle, Schema *schema, int layout);
+bool hasTupleRoom(RM_PageHeader *header, int maxStored);
+void compactPage(BM_PageHandle *handle);
+void placeTuple(BM_PageHandle *handle, int slot, const char *tuple, int length, int flags);
+void releaseTuple(BM_PageHandle *handle, int slot);
+int addTablePage(RM_TableState *table, Schema *schema);
+RC pinTablePage(RM_TableState *table, int pageNum, BM_PageHandle *handle);
+RC unpinTablePage(RM_TableState *table, BM_PageHandle *handle);
+void pushFreeSpacePage(RM_TableState *table, BM_PageHandle *handle, int maxStored);
+void removeFreeSpacePage(RM_TableState *table, BM_PageHandle *handle);
+int reclaimTablePage(RM_TableState *table, BM_PageHandle *page);
+int setTablePageClass(RM_TableState *table);
+void freeSlot(RM_TableState *table, BM_PageHandle *handle, int slot, int maxStored);
+RC storeTuple(RM_TableState *table, Schema *schema, const char *tuple, int length, int flags, RID *id);
+RC readTuple(RM_TableState *table, Schema *schema, BM_PageHandle *handle, int slot, char *data);
+int compareRecordRequests(const void *a, const void *b);
+RC findNextMatch(RM_ScanHandle *scan, Record *match);
+RC copyScanColumns(RM_ScanHandle *scan, int slot, int attrs);
+int getNextSlotInWalk(RM_TableState *table, BM_PageHandle **handle, uint64_t** slots, int *slotIndex);
+int closeSlotWalk(RM_TableState *table, BM_PageHandle **handle);
 
 /* Helpers */
 
@@ -96,66 +283,336 @@ RC markSystemCatalogDirty()
     return markDirty(&bufferPool, &catalogPageHandle); 
 }
 
-ResourceManagerSchema *getTableByName(char *name)
+// helper to mark the catalog entry of an open table dirty
+RC markTableDirty(RM_TableState *table)
+{
+    return markDirty(&bufferPool, table->entryHandle);
+}
+
+// helper to count inserted (or deleted) tuples of an open table without touching its entry's page
+void addPendingTuples(RM_TableState *table, int count)
+{
+    __atomic_fetch_add(&(table->pendingTuples), count, __ATOMIC_RELAXED);
+}
+
+// helper to fold the pending tuple count of an open table into its catalog entry
+void checkpointTableEntry(RM_TableState *table)
+{
+    int pending = __atomic_exchange_n(&(table->pendingTuples), 0, __ATOMIC_RELAXED);
+    if (pending != 0)
+    {
+        table->entry->numTuples += pending;
+        markTableDirty(table);
+    }
+}
+
+// helper to get the index of a table's catalog entry
+// returns -1 if there is no table with the name
+int getTableIndex(char *name)
+{
+    // Look the name up in the name index instead of scanning the catalog
+    int *tableIndex = (int *)getKey(&tableNames, name, strlen(name), NULL);
+    if (tableIndex == NULL)
+    {
+        return -1;  // Return -1 if no matching table is found
+    }
+    return *tableIndex;
+}
+
+// helper to get the table entries on a pinned catalog page
+RM_CatalogPage *getCatalogPage(BM_PageHandle *handle, int pageIndex)
+{
+    return (RM_CatalogPage *)(handle->data + CATALOG_PAGE_OFFSET(pageIndex));
+}
+
+// helper to get the index of the first entry of a catalog page
+int getFirstTableIndex(int pageIndex)
+{
+    if (pageIndex == 0)
+        return 0;
+    return CATALOG_PAGE_TABLES(0) + (pageIndex - 1) * CATALOG_PAGE_TABLES(1);
+}
+
+// helper to get the catalog page that holds an entry
+int getCatalogPageIndex(int tableIndex)
+{
+    if (tableIndex < (int)CATALOG_PAGE_TABLES(0))
+        return 0;
+    return 1 + (tableIndex - CATALOG_PAGE_TABLES(0)) / CATALOG_PAGE_TABLES(1);
+}
+
+// helper to pin the catalog page of an entry and get the entry
+// returns NULL for failure
+ResourceManagerSchema *pinTableEntry(int tableIndex, BM_PageHandle *handle)
+{
+    int pageIndex = getCatalogPageIndex(tableIndex);
+    if (pinPage(&bufferPool, handle, catalogPageNums[pageIndex]) != RC_OK)
+        return NULL;
+    return &(getCatalogPage(handle, pageIndex)->tables[tableIndex - getFirstTableIndex(pageIndex)]);
+}
+
+// helper to get the state of an open table by the index of its catalog entry
+// returns NULL if the table is not open
+RM_TableState *getOpenTable(int tableIndex)
+{
+    if (tableIndex >= numOpenTableSlots)
+        return NULL;
+    return openTables[tableIndex];
+}
+
+// helper to chain another (empty) catalog page after the last one
+// returns 0 for success and 1 for failure
+int addCatalogPage()
+{
+    RM_SystemCatalog *catalog = getSystemCatalog();
+    BM_PageHandle handle;
+
+    int *pageNums = (int *)realloc(catalogPageNums, sizeof(int) * (catalog->numCatalogPages + 1));
+    if (pageNums == NULL)
+        return 1;
+    catalogPageNums = pageNums;
+
+    int newPage = getFreePage();
+    if (newPage == NO_PAGE || pinPage(&bufferPool, &handle, newPage) != RC_OK)
+        return 1;
+    memset(handle.data, 0, PAGE_SIZE);
+    getCatalogPage(&handle, catalog->numCatalogPages)->nextCatalogPage = NO_PAGE;
+    markDirty(&bufferPool, &handle);
+    if (unpinPage(&bufferPool, &handle) != RC_OK)
+        return 1;
+
+    // link it from the last page
+    int lastIndex = catalog->numCatalogPages - 1;
+    if (pinPage(&bufferPool, &handle, catalogPageNums[lastIndex]) != RC_OK)
+        return 1;
+    getCatalogPage(&handle, lastIndex)->nextCatalogPage = newPage;
+    markDirty(&bufferPool, &handle);
+    if (unpinPage(&bufferPool, &handle) != RC_OK)
+        return 1;
+
+    catalogPageNums[catalog->numCatalogPages++] = newPage;
+    markSystemCatalogDirty();
+    return 0;
+}
+
+// helper to find a free catalog entry, the catalog gets another page when all of them are full
+// returns the index of the entry and -1 for failure
+int takeTableEntry()
 {
     RM_SystemCatalog *catalog = getSystemCatalog();
-    int tableIndex = 0;  // Initialize the loop counter outside the while loop
+    BM_PageHandle handle;
 
-    // Scan the catalog for the table using a while loop
-    while (tableIndex < catalog->numTables)
+    while (true)
     {
-        ResourceManagerSchema *table = &(catalog->tables[tableIndex]);
+        if (catalog->firstOpenCatalogPage == catalog->numCatalogPages && addCatalogPage() != 0)
+            return -1;
 
-        // Find the matching name and point the data to the schema handle
-        if (strcmp(table->name, name) == 0)
+        int pageIndex = catalog->firstOpenCatalogPage;
+        if (pinPage(&bufferPool, &handle, catalogPageNums[pageIndex]) != RC_OK)
+            return -1;
+        RM_CatalogPage *page = getCatalogPage(&handle, pageIndex);
+        int entry = -1;
+        if (page->numTables < (int)CATALOG_PAGE_TABLES(pageIndex))
         {
-            return table;
+            for (entry = 0; page->tables[entry].name[0] != '\0'; entry++)
+                ;
         }
+        if (unpinPage(&bufferPool, &handle) != RC_OK)
+            return -1;
+        if (entry != -1)
+            return getFirstTableIndex(pageIndex) + entry;
+
+        catalog->firstOpenCatalogPage++;
+        markSystemCatalogDirty();
+    }
+}
 
-        tableIndex++;  // Manually increment the loop counter
+// (re)build the name index and the catalog page numbers from the catalog pages,
+// returns 0 on success and 1 on failure
+int indexTableNames()
+{
+    RM_SystemCatalog *catalog = getSystemCatalog();
+    BM_PageHandle handle;
+
+    if (tableNames.mgmt != NULL)
+        freeKeyTable(&tableNames);
+    if (initKeyTable(&tableNames, catalog->numTables) != 0)
+        return 1;
+    free(catalogPageNums);
+    catalogPageNums = (int *)malloc(sizeof(int) * catalog->numCatalogPages);
+    if (catalogPageNums == NULL)
+        return 1;
+
+    int pageNum = 0;
+    for (int pageIndex = 0; pageIndex < catalog->numCatalogPages; pageIndex++)
+    {
+        catalogPageNums[pageIndex] = pageNum;
+        if (pinPage(&bufferPool, &handle, pageNum) != RC_OK)
+            return 1;
+        RM_CatalogPage *page = getCatalogPage(&handle, pageIndex);
+        for (int entry = 0; entry < (int)CATALOG_PAGE_TABLES(pageIndex); entry++)
+        {
+            ResourceManagerSchema *table = &(page->tables[entry]);
+            int tableIndex = getFirstTableIndex(pageIndex) + entry;
+            if (table->name[0] == '\0')
+                continue;
+            if (setKey(&tableNames, table->name, strlen(table->name), &tableIndex, sizeof(int)) != 0)
+            {
+                unpinPage(&bufferPool, &handle);
+                return 1;
+            }
+        }
+        pageNum = page->nextCatalogPage;
+        if (unpinPage(&bufferPool, &handle) != RC_OK)
+            return 1;
+    }
+    return 0;
+}
+// helper to write every dirty page of the buffer pool, pinned ones included (the main pages of the
+// open tables and the pages of scans, borrowed records and bulk loads)
+// returns 0 for success and 1 for failure
+int flushTablePages()
+{
+    // the unpinned pages go out in page order, then the pinned ones one by one
+    if (forceFlushPool(&bufferPool) != RC_OK)
+        return 1;
+    PageNumber *pageNums = getFrameContents(&bufferPool);
+    bool *dirtyFlags = getDirtyFlags(&bufferPool);
+    int failed = pageNums == NULL || dirtyFlags == NULL;
+    for (int i = 0; !failed && i < bufferPool.numPages; i++)
+    {
+        if (!dirtyFlags[i])
+            continue;
+        BM_PageHandle handle;
+        handle.pageNum = pageNums[i];
+        failed = forcePinnedPage(&bufferPool, &handle) != RC_OK;
     }
-    return NULL;  // Return NULL if no matching table is found
+    free(pageNums);
+    free(dirtyFlags);
+    return failed;
 }
+
 // helper to get get page header from a page frame 
 RM_PageHeader *getPageHeader(BM_PageHandle* handle)
 {
     return (RM_PageHeader *)handle->data;
 }
 
-// helper to get slot array from page frame
-bool *getSlots(BM_PageHandle* handle)
+// helper to get the slot map from page frame
+uint64_t *getSlotMap(BM_PageHandle* handle)
 {
     char *ptr = handle->data;
 
     // move up the ptr from the header
-    ptr += sizeof(RM_PageHeader);
-    return (bool *)ptr;
+    ptr += SLOT_MAP_OFFSET;
+    return (uint64_t *)ptr;
+}
+
+// helper to get the number of words in the slot map of a page with numSlots slots
+int getSlotMapWords(int numSlots)
+{
+    return (numSlots + SLOT_WORD_BITS - 1) / SLOT_WORD_BITS;
+}
+
+bool isSlotUsed(const uint64_t *slotMap, int slot)
+{
+    return (slotMap[slot / SLOT_WORD_BITS] >> (slot % SLOT_WORD_BITS)) & 1;
+}
+
+void setSlotUsed(uint64_t *slotMap, int slot, bool used)
+{
+    uint64_t bit = (uint64_t)1 << (slot % SLOT_WORD_BITS);
+    if (used)
+        slotMap[slot / SLOT_WORD_BITS] |= bit;
+    else
+        slotMap[slot / SLOT_WORD_BITS] &= ~bit;
+}
+
+// helper to find the first free slot, the bits past the last slot are kept set
+// returns the slot index or -1 if the page is full
+int findFreeSlot(const uint64_t *slotMap, int numSlots)
+{
+    for (int word = 0; word < getSlotMapWords(numSlots); word++)
+    {
+        if (~slotMap[word] != 0)
+            return word * SLOT_WORD_BITS + __builtin_ctzll(~slotMap[word]);
+    }
+    return -1;
+}
+
+// helper to find the first slot in use at or after from
+// returns the slot index or -1 if there is none
+int findUsedSlot(const uint64_t *slotMap, int numSlots, int from)
+{
+    if (from >= numSlots)
+        return -1;
+    int word = from / SLOT_WORD_BITS;
+    uint64_t bits = slotMap[word] & (~(uint64_t)0 << (from % SLOT_WORD_BITS));
+    while (bits == 0)
+    {
+        if (++word >= getSlotMapWords(numSlots))
+            return -1;
+        bits = slotMap[word];
+    }
+    int slot = word * SLOT_WORD_BITS + __builtin_ctzll(bits);
+    return (slot < numSlots) ? slot : -1;
+}
+
+// helper to get the slot directory from a page frame, it follows the slot map
+RM_SlotEntry *getSlotDirectory(BM_PageHandle* handle)
+{
+    // get start of slot map
+    char *ptr = (char *)getSlotMap(handle);
+
+    // move it down the slot map
+    RM_PageHeader *header = getPageHeader(handle);
+    ptr += sizeof(uint64_t) * getSlotMapWords(header->numSlots);
+    return (RM_SlotEntry *)ptr;
+}
+
+// helper to get where the slot directory of a page with numSlots slots ends
+int getDirectoryEnd(int numSlots)
+{
+    return (int)SLOT_MAP_OFFSET + getSlotMapWords(numSlots) * (int)sizeof(uint64_t) + numSlots * (int)sizeof(RM_SlotEntry);
 }
 
-// helper to get the tuple data from a page frame
-char *getTupleData(BM_PageHandle* handle)
+// helper to get the bytes a tuple of length takes on its page, every tuple has room
+// for a RID so that it can be replaced by a forwarding RID in place
+int getStoredSize(int length)
 {
-    // get start of slot array
-    char *ptr = (char *)getSlots(handle);
+    if (length == 0)
+        return 0;
+    return (length < (int)sizeof(RID)) ? (int)sizeof(RID) : length;
+}
 
-    // move it down the slot array
+// helper to tell if a slot holds a record of its own page (not a tuple moved there for another page)
+bool isRecordSlot(BM_PageHandle* handle, int slot)
+{
     RM_PageHeader *header = getPageHeader(handle);
-    ptr += sizeof(bool) * header->numSlots;
-    return ptr;
+    if (slot < 0 || slot >= header->numSlots || !isSlotUsed(getSlotMap(handle), slot))
+        return FALSE;
+    if (header->layout != RM_LAYOUT_ROW)
+        return TRUE;
+    return (getSlotDirectory(handle)[slot].length & SLOT_MOVED) == 0;
+}
+
+// helper to tell if a slot only holds the RID its record moved to (only on a row page)
+bool isForwarded(BM_PageHandle* handle, int slot)
+{
+    if (getPageHeader(handle)->layout != RM_LAYOUT_ROW)
+        return FALSE;
+    return (getSlotDirectory(handle)[slot].length & SLOT_FORWARD) != 0;
 }
 
-ResourceManagerSchema *getSystemSchema(RM_TableData *rel)
+RM_TableState *getTableState(RM_TableData *rel)
 {
-    return (ResourceManagerSchema *)rel->mgmtData;
+    return (RM_TableState *)rel->mgmtData;
 }
 
-// helper to get the tuple data at an index from a page frame
-char *getTupleDataAt(BM_PageHandle* handle, int recordSize, int index)
+// helper to get the tuple of a slot from a page frame
+char *getTupleDataAt(BM_PageHandle* handle, int index)
 {
-    // get start of tuple data and move it down
-    char *ptr = getTupleData(handle);
-    ptr += index * recordSize;
-    return ptr;
+    return handle->data + getSlotDirectory(handle)[index].offset;
 }
 
 // helper to get the next available free page
@@ -219,16 +676,40 @@ int getFreePage()
             }
     }
 }
-// helper to set a page as free by adding it to the free list
+// helper to set a pinned page as free by adding it to the beginning of the free list
 // returns 0 for success and 1 for failure
 // NOTE the page should not already be in the free list
-int setFreePage(BM_PageHandle* handle)
+int setFreePage(BM_PageHandle* page)
 {
-    // TODO: implement this for overflow pages
-    return 1;
+    USE_PAGE_HANDLE_HEADER(1);
+
+    RM_SystemCatalog *catalog = getSystemCatalog();
+    RM_PageHeader *pageHeader = getPageHeader(page);
+
+    // the old first page now comes after the page
+    if (catalog->freePage != NO_PAGE)
+    {
+        BEGIN_USE_PAGE_HANDLE_HEADER(catalog->freePage);
+        {
+            header->prevPage = page->pageNum;
+            markDirty(&bufferPool, &handle);
+        }
+        END_USE_PAGE_HANDLE_HEADER();
+    }
+
+    // set the page's prev to the catalog and the catalog's next to the page,
+    // it leaves its table's buffer page class
+    setPageClass(&bufferPool, page->pageNum, 0);
+    pageHeader->nextPage = catalog->freePage;
+    pageHeader->prevPage = 0;
+    catalog->freePage = page->pageNum;
+    markDirty(&bufferPool, page);
+    markSystemCatalogDirty();
+    return 0;
 }
 
 // takes a chain of free pages and appends them to the beginning of the free list
+// (the pages leave their table's buffer page class on the way)
 // returns 0 for success and 1 for failure
 // NOTE the chain should not already be in the free list
 int appendToFreeList(int pageNum)
@@ -236,76 +717,59 @@ int appendToFreeList(int pageNum)
     USE_PAGE_HANDLE_HEADER(1);
 
     RM_SystemCatalog *catalog = getSystemCatalog();
-    int condition = (catalog->freePage == NO_PAGE) ? 1 : 0;  // Prepare condition for switch-case
+    int curPage = pageNum;
 
-    switch (condition)
+    // cycle through the chain until the end, which is linked to the old first free page
+    while (1)
     {
-        case 1:  // Equivalent to catalog->freePage == NO_PAGE
+        setPageClass(&bufferPool, curPage, 0);
+        BEGIN_USE_PAGE_HANDLE_HEADER(curPage);
+        {
+            int nextPageCondition = (header->nextPage == NO_PAGE) ? 1 : 0;
+            switch (nextPageCondition)
             {
-                BEGIN_USE_PAGE_HANDLE_HEADER(pageNum);
-                {
-                    header->prevPage = 0;
-                    catalog->freePage = pageNum;
+                case 1:  // There is no next page, we are at the end of the chain
+                    header->nextPage = catalog->freePage;
                     markDirty(&bufferPool, &handle);
-                    markSystemCatalogDirty();
-                }
-                END_USE_PAGE_HANDLE_HEADER();
-                return 0;
-            }
-
-        default:  // Equivalent to else part
-            {
-                int curPage = pageNum;
-
-                // cycle through the chain until the end
-                while (1)
-                {
-                    BEGIN_USE_PAGE_HANDLE_HEADER(curPage);
-                    {
-                        int nextPageCondition = (header->nextPage == NO_PAGE) ? 1 : 0;
-                        switch (nextPageCondition)
-                        {
-                            case 1:  // There is no next page, we are at the end of the chain
-                                header->nextPage = catalog->freePage;
-                                markDirty(&bufferPool, &handle);
-                                END_USE_PAGE_HANDLE_HEADER();
-                                goto end_loop;  // Use goto to break out of the nested switch within the while
-                            
-                            default:
-                                curPage = header->nextPage;
-                                break;
-                        }
-                    }
                     END_USE_PAGE_HANDLE_HEADER();
-                }
-
-            end_loop:
-                // set the catalog's next's prev to the last page
-                BEGIN_USE_PAGE_HANDLE_HEADER(catalog->freePage);
-                {
-                    header->prevPage = curPage;
-                    markDirty(&bufferPool, &handle);
-                }
-                END_USE_PAGE_HANDLE_HEADER();
+                    goto end_loop;  // Use goto to break out of the nested switch within the while
 
-                // set the first page's prev to the catalog and the catalog's next to the first page
-                BEGIN_USE_PAGE_HANDLE_HEADER(pageNum);
-                {
-                    header->prevPage = 0;
-                    catalog->freePage = pageNum;
-                    markDirty(&bufferPool, &handle);
-                    markSystemCatalogDirty();
-                }
-                END_USE_PAGE_HANDLE_HEADER();
-                return 0;
+                default:
+                    curPage = header->nextPage;
+                    break;
             }
+        }
+        END_USE_PAGE_HANDLE_HEADER();
+    }
+
+end_loop:
+    // set the catalog's next's prev to the last page
+    if (catalog->freePage != NO_PAGE)
+    {
+        BEGIN_USE_PAGE_HANDLE_HEADER(catalog->freePage);
+        {
+            header->prevPage = curPage;
+            markDirty(&bufferPool, &handle);
+        }
+        END_USE_PAGE_HANDLE_HEADER();
+    }
+
+    // set the first page's prev to the catalog and the catalog's next to the first page
+    BEGIN_USE_PAGE_HANDLE_HEADER(pageNum);
+    {
+        header->prevPage = 0;
+        catalog->freePage = pageNum;
+        markDirty(&bufferPool, &handle);
+        markSystemCatalogDirty();
     }
+    END_USE_PAGE_HANDLE_HEADER();
+    return 0;
 }
 
-int getNextPage(ResourceManagerSchema *table, int pageNum)
+int getNextPage(RM_TableState *table, int pageNum)
 {
     // Create a condition that is suitable for using in a switch-case
-    int condition = (pageNum == table->pageNum) ? 1 : 0;
+    int condition = (pageNum == table->entry->pageNum) ? 1 : 0;
 
     switch (condition)
     {
@@ -327,104 +791,1003 @@ int getNextPage(ResourceManagerSchema *table, int pageNum)
 }
 
 
+// helper to tell if records of the schema are stored as they are, which holds when it has no
+// strings, so that a tuple can be read in place on its page
+bool isFixedLayout(Schema *schema)
+{
+    for (int i = 0; i < schema->numAttr; i++)
+    {
+        if (schema->dataTypes[i] == DT_STRING)
+            return FALSE;
+    }
+    return TRUE;
+}
 
-#define BEGIN_SLOT_WALK(table) \
-BM_PageHandle *handle = table->handle; \
-bool* slots; \
-int slotIndex = -1; \
-int slotResult = 0;
+// helper to tell if the records of a table can be read in place on its pages,
+// which holds for row pages of a schema without strings
+bool isStoredInPlace(RM_TableState *table, Schema *schema)
+{
+    return table->entry->layout == RM_LAYOUT_ROW && isFixedLayout(schema);
+}
 
-// call the above macro before initiating the slot walk
-// gets the next slotIndex along with the right slots array
-// if the page finished, it unpins the page (unless its the main page)
-// closeSlots must be called on termination (last page must be manually closed!)
-// 0 for success, 1 for failure, -1 for no more slots
-int getNextSlotInWalk(ResourceManagerSchema *table, BM_PageHandle **handle, bool** slots, int *slotIndex)
+// helper to pack a record into the tuple stored on its page: a string keeps its length and
+// its bytes up to the last non-zero one, any other attribute is copied as it is
+// returns the length of the tuple
+int packTuple(Schema *schema, const char *data, char *tuple)
 {
-    RC result;
-    RM_PageHeader *header = getPageHeader(*handle);
-    *slots = getSlots(*handle);
-    
-    // Use switch-case for slot index comparison
-    switch (*slotIndex < header->numSlots)
+    int length = 0;
+    for (int i = 0; i < schema->numAttr; i++)
     {
-        case 1:  // True: There are more slots to process in the current page
-            (*slotIndex)++;
-            return 0;
-        default:  // False: No more slots in the current page, need to handle page transition
-            break;
+        int attrSize = getAttrSize(schema, i);
+        if (schema->dataTypes[i] == DT_STRING)
+        {
+            uint16_t used = (uint16_t)attrSize;
+            while (used > 0 && data[used - 1] == '\0')
+                used--;
+            memcpy(tuple + length, &used, sizeof(uint16_t));
+            memcpy(tuple + length + sizeof(uint16_t), data, used);
+            length += sizeof(uint16_t) + used;
+        }
+        else
+        {
+            memcpy(tuple + length, data, attrSize);
+            length += attrSize;
+        }
+        data += attrSize;
     }
+    return length;
+}
 
-    *slotIndex = 0;
-    int nextPage = header->nextPage;
-    
-    // Nested switch-case for checking page transition conditions
-    switch (nextPage != NO_PAGE)
+// helper to unpack a tuple of a page into the record layout, strings are padded with zeros again
+void unpackTuple(Schema *schema, const char *tuple, char *data)
+{
+    for (int i = 0; i < schema->numAttr; i++)
     {
-        case 1:  // True: There is a next page
-            if (table->pageNum != (*handle)->pageNum)
-            {
-                result = unpinPage(&bufferPool, *handle);
-                switch (result)
-                {
-                    case RC_OK:
-                        break;  // Continue if unpin successful
-                    default:
-                        return 1;  // Error handling if unpin fails
-                }
-            }
-            // Fall through to attempt pinning the next page
-            result = pinPage(&bufferPool, *handle, nextPage);
-            switch (result)
-            {
-                case RC_OK:
-                    return getNextSlotInWalk(table, handle, slots, slotIndex);  // Recursion to continue the walk
-                default:
-                    return 1;  // Error handling if pin fails
-            }
+        int attrSize = getAttrSize(schema, i);
+        if (schema->dataTypes[i] == DT_STRING)
+        {
+            uint16_t used;
+            memcpy(&used, tuple, sizeof(uint16_t));
+            memcpy(data, tuple + sizeof(uint16_t), used);
+            memset(data + used, 0, attrSize - used);
+            tuple += sizeof(uint16_t) + used;
+        }
+        else
+        {
+            memcpy(data, tuple, attrSize);
+            tuple += attrSize;
+        }
+        data += attrSize;
+    }
+}
 
-        default:  // False: No next page, end of slots
-            return -1;
+// helper to turn a record into the tuple its table stores, PAX and column tables take the record as it is
+// returns the length of the tuple
+int encodeRecord(RM_TableState *table, Schema *schema, const char *data, char *tuple)
+{
+    if (table->entry->layout != RM_LAYOUT_ROW)
+    {
+        int recordSize = getRecordSize(schema);
+        memcpy(tuple, data, recordSize);
+        return recordSize;
     }
+    return packTuple(schema, data, tuple);
 }
 
-int closeSlotWalk(ResourceManagerSchema *table, BM_PageHandle **handle)
+// helper to get the most bytes a tuple of the schema can take on a page,
+// including the RID in front of a tuple that moved to another page
+int getMaxStoredSize(Schema *schema)
 {
-    // Create a condition that is suitable for using in a switch-case
-    int condition = (table->pageNum != (*handle)->pageNum) ? 1 : 0;
+    int length = sizeof(RID);
+    for (int i = 0; i < schema->numAttr; i++)
+    {
+        length += getAttrSize(schema, i);
+        if (schema->dataTypes[i] == DT_STRING)
+            length += sizeof(uint16_t);
+    }
+    return getStoredSize(length);
+}
 
-    switch (condition)
+// helper to lay out the column arrays of a PAX page with numSlots slots after its slot map,
+// each one starting on a word boundary (offsets gets their offsets unless it is NULL)
+// returns the end of the last array
+int layoutPaxColumns(Schema *schema, int numSlots, uint16_t *offsets)
+{
+    int offset = (int)SLOT_MAP_OFFSET + getSlotMapWords(numSlots) * (int)sizeof(uint64_t);
+    for (int i = 0; i < schema->numAttr; i++)
     {
-        case 1:
-            {
-                RC result = unpinPage(&bufferPool, *handle);
-                switch (result)
-                {
-                    case RC_OK:
-                        break;  // Successfully unpinned, proceed normally.
-                    default:
-                        return 1;  // Error in unpinning
-                }
-            }
-            break;
-        default:
-            break;  // No action needed if page numbers are the same
+        offset = (offset + (int)sizeof(uint64_t) - 1) / (int)sizeof(uint64_t) * (int)sizeof(uint64_t);
+        if (offsets != NULL)
+            offsets[i] = (uint16_t)offset;
+        offset += numSlots * getAttrSize(schema, i);
     }
-    
-    return 0;  // Indicate successful closure
+    return offset;
 }
 
+// helper to copy a record into the column arrays of a PAX page
+void scatterColumns(BM_PageHandle *handle, int slot, const char *data)
+{
+    RM_PageHeader *header = getPageHeader(handle);
+    for (int i = 0; i < header->numColumns; i++)
+    {
+        memcpy(handle->data + header->columnOffsets[i] + slot * header->columnSizes[i], data, header->columnSizes[i]);
+        data += header->columnSizes[i];
+    }
+}
 
+// helper to copy the attributes in attrs (a bit per attribute) of a slot of a PAX page
+// to their place in the record layout, the other attributes of data are left alone
+void gatherColumns(BM_PageHandle *handle, int slot, int attrs, char *data)
+{
+    RM_PageHeader *header = getPageHeader(handle);
+    for (int i = 0; i < header->numColumns; i++)
+    {
+        if (attrs & (1 << i))
+            memcpy(data, handle->data + header->columnOffsets[i] + slot * header->columnSizes[i], header->columnSizes[i]);
+        data += header->columnSizes[i];
+    }
+}
 
-/* Table and Manager */
+// helper to get the attributes an expression reads, a bit per attribute
+int getExprAttrs(Expr *expr)
+{
+    if (expr == NULL)
+        return 0;
 
-RC initRecordManager(void *mgmtData) {
-    // Ensure the system catalog can fit into one page
-    if (PAGE_SIZE < sizeof(RM_SystemCatalog) || MAX_NUM_TABLES <= 0) {
-        return RC_IM_NO_MORE_ENTRIES;
+    switch (expr->type)
+    {
+        case EXPR_ATTRREF:
+            return 1 << expr->expr.attrRef;
+        case EXPR_OP:
+            {
+                int attrs = getExprAttrs(expr->expr.op->args[0]);
+                if (expr->expr.op->type != OP_BOOL_NOT)
+                    attrs |= getExprAttrs(expr->expr.op->args[1]);
+                return attrs;
+            }
+        default:
+            return 0;
     }
+}
 
-    RC result;
+// helper to get the segments of a row group page, which follow its slot map
+RM_ColumnSegment *getColumnSegments(BM_PageHandle *handle)
+{
+    return (RM_ColumnSegment *)(handle->data + SLOT_MAP_OFFSET + getSlotMapWords(getPageHeader(handle)->numSlots) * sizeof(uint64_t));
+}
+
+// helper to get the segment that holds a column of a row of a row group page,
+// offset gets where the value lies in the segment's page
+// (a segment page is nothing but values, as many as fit)
+RM_ColumnSegment *getRowSegment(BM_PageHandle *handle, int column, int slot, int *offset)
+{
+    RM_PageHeader *header = getPageHeader(handle);
+    int valuesPerPage = PAGE_SIZE / header->columnSizes[column];
+    *offset = (slot % valuesPerPage) * header->columnSizes[column];
+    return &(getColumnSegments(handle)[header->columnOffsets[column] + slot / valuesPerPage]);
+}
+
+// helper to lay out the segment list of a row group page with numSlots rows, the segments
+// of a column follow each other (firstSegments gets the first one of every column unless it is NULL)
+// returns the end of the list
+int layoutColumnGroup(Schema *schema, int numSlots, uint16_t *firstSegments)
+{
+    int numSegments = 0;
+    for (int i = 0; i < schema->numAttr; i++)
+    {
+        int valuesPerPage = PAGE_SIZE / getAttrSize(schema, i);
+        if (firstSegments != NULL)
+            firstSegments[i] = (uint16_t)numSegments;
+        numSegments += (numSlots + valuesPerPage - 1) / valuesPerPage;
+    }
+    return (int)SLOT_MAP_OFFSET + getSlotMapWords(numSlots) * (int)sizeof(uint64_t) + numSegments * (int)sizeof(RM_ColumnSegment);
+}
+
+// helper to take a value written to a segment into the segment's range
+void widenSegmentRange(RM_ColumnSegment *segment, DataType type, const char *value)
+{
+    RM_ColumnBound bound;
+    bool boolValue;
+
+    switch (type)
+    {
+        case DT_INT:
+            memcpy(&(bound.intV), value, sizeof(int));
+            break;
+        case DT_FLOAT:
+            memcpy(&(bound.floatV), value, sizeof(float));
+            break;
+        case DT_BOOL:
+            memcpy(&boolValue, value, sizeof(bool));
+            bound.intV = boolValue ? 1 : 0;
+            break;
+        default:
+            return;
+    }
+
+    if (!segment->hasRange)
+    {
+        segment->min = segment->max = bound;
+        segment->hasRange = TRUE;
+    }
+    else if (type == DT_FLOAT)
+    {
+        if (bound.floatV < segment->min.floatV)
+            segment->min = bound;
+        if (bound.floatV > segment->max.floatV)
+            segment->max = bound;
+    }
+    else
+    {
+        if (bound.intV < segment->min.intV)
+            segment->min = bound;
+        if (bound.intV > segment->max.intV)
+            segment->max = bound;
+    }
+}
+
+// helper to write a record to the segments of a row of a pinned row group page, a segment
+// gets its page when its first value is written
+RC writeColumns(RM_TableState *table, Schema *schema, BM_PageHandle *handle, int slot, const char *data)
+{
+    RM_PageHeader *header = getPageHeader(handle);
+    BM_PageHandle segmentHandle;
+    RC result;
+
+    for (int i = 0; i < header->numColumns; i++)
+    {
+        int offset;
+        RM_ColumnSegment *segment = getRowSegment(handle, i, slot, &offset);
+        if (segment->pageNum == NO_PAGE)
+        {
+            segment->pageNum = getFreePage();
+            if (segment->pageNum == NO_PAGE)
+                return RC_WRITE_FAILED;
+            segment->hasRange = FALSE;
+            setPageClass(&bufferPool, segment->pageNum, table->entry->pageNum);
+        }
+
+        result = pinTablePage(table, segment->pageNum, &segmentHandle);
+        if (result != RC_OK)
+            return result;
+        memcpy(segmentHandle.data + offset, data, header->columnSizes[i]);
+        markDirty(&bufferPool, &segmentHandle);
+        result = unpinTablePage(table, &segmentHandle);
+        if (result != RC_OK)
+            return result;
+
+        widenSegmentRange(segment, schema->dataTypes[i], data);
+        data += header->columnSizes[i];
+    }
+    return RC_OK;
+}
+
+// helper to copy the attributes in attrs (a bit per attribute) of a row of a pinned row group page
+// from their segments to their place in the record layout, the other attributes of data are left alone
+// segments keeps a page per column pinned for the next call (NO_PAGE when none), or is NULL
+// to pin each page just for its value
+RC readColumns(RM_TableState *table, BM_PageHandle *handle, int slot, int attrs, BM_PageHandle *segments, char *data)
+{
+    RM_PageHeader *header = getPageHeader(handle);
+    BM_PageHandle segmentHandle;
+    RC result;
+
+    for (int i = 0; i < header->numColumns; i++)
+    {
+        if (attrs & (1 << i))
+        {
+            int offset;
+            RM_ColumnSegment *segment = getRowSegment(handle, i, slot, &offset);
+            if (segments == NULL)
+            {
+                result = pinTablePage(table, segment->pageNum, &segmentHandle);
+                if (result != RC_OK)
+                    return result;
+                memcpy(data, segmentHandle.data + offset, header->columnSizes[i]);
+                result = unpinTablePage(table, &segmentHandle);
+                if (result != RC_OK)
+                    return result;
+            }
+            else
+            {
+                // swap the held page of the column when the row is in another segment
+                if (segments[i].pageNum != segment->pageNum)
+                {
+                    if (segments[i].pageNum != NO_PAGE)
+                    {
+                        result = unpinTablePage(table, &segments[i]);
+                        segments[i].pageNum = NO_PAGE;
+                        if (result != RC_OK)
+                            return result;
+                    }
+                    result = pinTablePage(table, segment->pageNum, &segments[i]);
+                    if (result != RC_OK)
+                    {
+                        segments[i].pageNum = NO_PAGE;
+                        return result;
+                    }
+                }
+                memcpy(data, segments[i].data + offset, header->columnSizes[i]);
+            }
+        }
+        data += header->columnSizes[i];
+    }
+    return RC_OK;
+}
+
+// helper to get how many segments the list of a row group page has
+int getNumSegments(RM_PageHeader *header)
+{
+    int last = header->numColumns - 1;
+    int valuesPerPage = PAGE_SIZE / header->columnSizes[last];
+    return header->columnOffsets[last] + (header->numSlots + valuesPerPage - 1) / valuesPerPage;
+}
+
+// helper to give the segment pages of a pinned row group page back to the free list
+// returns 0 for success and 1 for failure
+int freeColumnSegments(BM_PageHandle *group)
+{
+    USE_PAGE_HANDLE_HEADER(1);
+    RM_ColumnSegment *segments = getColumnSegments(group);
+    int numSegments = getNumSegments(getPageHeader(group));
+
+    for (int i = 0; i < numSegments; i++)
+    {
+        if (segments[i].pageNum == NO_PAGE)
+            continue;
+        BEGIN_USE_PAGE_HANDLE_HEADER(segments[i].pageNum);
+        {
+            if (setFreePage(&handle) != 0)
+            {
+                unpinPage(&bufferPool, &handle);
+                return error;
+            }
+        }
+        END_USE_PAGE_HANDLE_HEADER();
+        segments[i].pageNum = NO_PAGE;
+        segments[i].hasRange = FALSE;
+    }
+    return markDirty(&bufferPool, group) == RC_OK ? 0 : 1;
+}
+
+// helper to give the segment pages of every row group of a closed table back to the free list
+// returns 0 for success and 1 for failure
+int freeTableSegments(int pageNum)
+{
+    USE_PAGE_HANDLE_HEADER(1);
+    while (pageNum != NO_PAGE)
+    {
+        BEGIN_USE_PAGE_HANDLE_HEADER(pageNum);
+        {
+            if (header->layout == RM_LAYOUT_COLUMN && freeColumnSegments(&handle) != 0)
+            {
+                unpinPage(&bufferPool, &handle);
+                return error;
+            }
+            pageNum = header->nextPage;
+        }
+        END_USE_PAGE_HANDLE_HEADER();
+    }
+    return 0;
+}
+
+// helper to tell if a row of a row group page, or any other row in the same segments of the
+// expression's columns, can satisfy the expression given the ranges of those segments
+// (negated asks the same of the expression's negation), TRUE whenever the ranges cannot tell
+bool segmentMayMatch(Expr *expr, Schema *schema, BM_PageHandle *handle, int slot, bool negated)
+{
+    if (expr->type != EXPR_OP)
+        return TRUE;
+    Operator *op = expr->expr.op;
+
+    switch (op->type)
+    {
+        case OP_BOOL_AND:
+            if (negated)
+                return segmentMayMatch(op->args[0], schema, handle, slot, TRUE) || segmentMayMatch(op->args[1], schema, handle, slot, TRUE);
+            return segmentMayMatch(op->args[0], schema, handle, slot, FALSE) && segmentMayMatch(op->args[1], schema, handle, slot, FALSE);
+        case OP_BOOL_OR:
+            if (negated)
+                return segmentMayMatch(op->args[0], schema, handle, slot, TRUE) && segmentMayMatch(op->args[1], schema, handle, slot, TRUE);
+            return segmentMayMatch(op->args[0], schema, handle, slot, FALSE) || segmentMayMatch(op->args[1], schema, handle, slot, FALSE);
+        case OP_BOOL_NOT:
+            return segmentMayMatch(op->args[0], schema, handle, slot, !negated);
+        case OP_COMP_EQUAL:
+        case OP_COMP_SMALLER:
+            break;
+        default:
+            return TRUE;
+    }
+
+    // only an attribute compared to a constant of its own type can be ruled out
+    bool attrFirst = op->args[0]->type == EXPR_ATTRREF && op->args[1]->type == EXPR_CONST;
+    if (!attrFirst && !(op->args[0]->type == EXPR_CONST && op->args[1]->type == EXPR_ATTRREF))
+        return TRUE;
+    int column = attrFirst ? op->args[0]->expr.attrRef : op->args[1]->expr.attrRef;
+    Value *constant = attrFirst ? op->args[1]->expr.cons : op->args[0]->expr.cons;
+
+    int offset;
+    RM_ColumnSegment *segment = getRowSegment(handle, column, slot, &offset);
+    if (!segment->hasRange || schema->dataTypes[column] != constant->dt)
+        return TRUE;
+    double min, max, value;
+    switch (constant->dt)
+    {
+        case DT_INT:
+            min = segment->min.intV;
+            max = segment->max.intV;
+            value = constant->v.intV;
+            break;
+        case DT_BOOL:
+            min = segment->min.intV;
+            max = segment->max.intV;
+            value = constant->v.boolV ? 1 : 0;
+            break;
+        case DT_FLOAT:
+            min = segment->min.floatV;
+            max = segment->max.floatV;
+            value = constant->v.floatV;
+            break;
+        default:
+            return TRUE;
+    }
+
+    if (op->type == OP_COMP_EQUAL)
+        return negated ? !(min == value && max == value) : (min <= value && value <= max);
+    // attr < value, or value < attr, and their negations attr >= value and attr <= value
+    if (attrFirst)
+        return negated ? max >= value : min < value;
+    return negated ? min <= value : max > value;
+}
+
+// helper to get how many slots a page of the table gets, and 0 if a record does not fit on a page
+// (a row page has enough for a page full of the smallest tuples, a PAX page a column entry per slot,
+// a row group page as many rows as the narrowest column has in one segment page if its list fits)
+int getRecordsPerPage(Schema *schema, int layout)
+{
+    int space = PAGE_SIZE - (int)SLOT_MAP_OFFSET;
+    int recordsPerPage;
+
+    if (layout == RM_LAYOUT_COLUMN)
+    {
+        recordsPerPage = 0;
+        for (int i = 0; i < schema->numAttr; i++)
+        {
+            int valuesPerPage = PAGE_SIZE / getAttrSize(schema, i);
+            if (valuesPerPage == 0)
+                return 0;
+            if (valuesPerPage > recordsPerPage)
+                recordsPerPage = valuesPerPage;
+        }
+        while (recordsPerPage > 0 && layoutColumnGroup(schema, recordsPerPage, NULL) > PAGE_SIZE)
+            recordsPerPage--;
+        return recordsPerPage;
+    }
+
+    if (layout == RM_LAYOUT_PAX)
+    {
+        // a slot costs one bit of the map plus its record, the arrays are aligned to whole words
+        int recordSize = getRecordSize(schema);
+        recordsPerPage = space * 8 / (recordSize * 8 + 1);
+        while (recordsPerPage > 0 && layoutPaxColumns(schema, recordsPerPage, NULL) > PAGE_SIZE)
+            recordsPerPage--;
+        return recordsPerPage;
+    }
+
+    int minLength = 0;
+    for (int i = 0; i < schema->numAttr; i++)
+        minLength += (schema->dataTypes[i] == DT_STRING) ? (int)sizeof(uint16_t) : getAttrSize(schema, i);
+    int minStored = getStoredSize(minLength);
+
+    if (getDirectoryEnd(1) + getMaxStoredSize(schema) > PAGE_SIZE)
+        return 0;
+
+    // a slot costs one bit of the map, its directory entry and its tuple, and the map is rounded up to whole words
+    recordsPerPage = space * 8 / ((minStored + (int)sizeof(RM_SlotEntry)) * 8 + 1);
+    while (recordsPerPage > 0 && getDirectoryEnd(recordsPerPage) + recordsPerPage * minStored > PAGE_SIZE)
+        recordsPerPage--;
+    return recordsPerPage;
+}
+
+// helper to set up an empty page of a table, every slot is free
+void formatTablePage(BM_PageHandle *handle, Schema *schema, int layout)
+{
+    RM_PageHeader *header = getPageHeader(handle);
+    uint64_t *slots = getSlotMap(handle);
+    int recordsPerPage = getRecordsPerPage(schema, layout);
+    int words = getSlotMapWords(recordsPerPage);
+
+    header->numSlots = recordsPerPage;
+    header->numFree = recordsPerPage;
+    header->nextFreeSpace = NO_PAGE;
+    header->prevFreeSpace = NO_PAGE;
+    header->onFreeSpaceList = FALSE;
+    header->layout = layout;
+    memset(slots, 0, sizeof(uint64_t) * words);
+
+    if (layout == RM_LAYOUT_PAX)
+    {
+        // the column arrays take the rest of the page up front
+        header->numColumns = schema->numAttr;
+        layoutPaxColumns(schema, recordsPerPage, header->columnOffsets);
+        for (int i = 0; i < schema->numAttr; i++)
+            header->columnSizes[i] = (uint16_t)getAttrSize(schema, i);
+        header->heapStart = PAGE_SIZE;
+        header->freeBytes = 0;
+    }
+    else if (layout == RM_LAYOUT_COLUMN)
+    {
+        // the segments get their pages as the rows are written
+        RM_ColumnSegment *segments = getColumnSegments(handle);
+        header->numColumns = schema->numAttr;
+        for (int i = 0; i < schema->numAttr; i++)
+            header->columnSizes[i] = (uint16_t)getAttrSize(schema, i);
+        layoutColumnGroup(schema, recordsPerPage, header->columnOffsets);
+        for (int i = 0; i < getNumSegments(header); i++)
+        {
+            segments[i].pageNum = NO_PAGE;
+            segments[i].hasRange = FALSE;
+        }
+        header->heapStart = PAGE_SIZE;
+        header->freeBytes = 0;
+    }
+    else
+    {
+        header->numColumns = 0;
+        header->heapStart = PAGE_SIZE;
+        header->freeBytes = PAGE_SIZE - getDirectoryEnd(recordsPerPage);
+        memset(getSlotDirectory(handle), 0, sizeof(RM_SlotEntry) * recordsPerPage);
+    }
+
+    // the bits past the last slot count as used, so a free bit is always a real slot
+    if (recordsPerPage % SLOT_WORD_BITS != 0)
+        slots[words - 1] = ~(uint64_t)0 << (recordsPerPage % SLOT_WORD_BITS);
+}
+
+// helper to tell if any tuple of the table can still be put on a page
+bool hasTupleRoom(RM_PageHeader *header, int maxStored)
+{
+    // every slot of a PAX or row group page has its room in the column arrays or segments
+    return header->numFree > 0 && (header->layout != RM_LAYOUT_ROW || header->freeBytes >= maxStored);
+}
+
+// helper to move every tuple to the end of the page so that the holes left by deleted and
+// shrunk tuples become one free block again
+void compactPage(BM_PageHandle *handle)
+{
+    RM_PageHeader *header = getPageHeader(handle);
+    RM_SlotEntry *directory = getSlotDirectory(handle);
+    uint64_t *slots = getSlotMap(handle);
+    char copy[PAGE_SIZE];
+    memcpy(copy, handle->data, PAGE_SIZE);
+
+    int heapStart = PAGE_SIZE;
+    for (int slot = findUsedSlot(slots, header->numSlots, 0); slot != -1; slot = findUsedSlot(slots, header->numSlots, slot + 1))
+    {
+        int size = getStoredSize(directory[slot].length & SLOT_LENGTH_MASK);
+        heapStart -= size;
+        memcpy(handle->data + heapStart, copy + directory[slot].offset, size);
+        directory[slot].offset = heapStart;
+    }
+    header->heapStart = heapStart;
+}
+
+// helper to put a tuple into a slot without one, the caller made sure the page has the room
+// (which is compacted first when its free bytes are not in one piece)
+void placeTuple(BM_PageHandle *handle, int slot, const char *tuple, int length, int flags)
+{
+    RM_PageHeader *header = getPageHeader(handle);
+    if (header->layout == RM_LAYOUT_PAX)
+    {
+        scatterColumns(handle, slot, tuple);
+        return;
+    }
+    RM_SlotEntry *entry = &(getSlotDirectory(handle)[slot]);
+    int size = getStoredSize(length);
+
+    if (header->heapStart - getDirectoryEnd(header->numSlots) < size)
+        compactPage(handle);
+    header->heapStart -= size;
+    header->freeBytes -= size;
+    entry->offset = header->heapStart;
+    entry->length = length | flags;
+    memcpy(handle->data + entry->offset, tuple, length);
+}
+
+// helper to give the bytes of a slot's tuple back to its page, the slot itself stays in use
+void releaseTuple(BM_PageHandle *handle, int slot)
+{
+    RM_PageHeader *header = getPageHeader(handle);
+    if (header->layout != RM_LAYOUT_ROW)
+        return;
+    RM_SlotEntry *entry = &(getSlotDirectory(handle)[slot]);
+    int size = getStoredSize(entry->length & SLOT_LENGTH_MASK);
+
+    // the lowest tuple simply gives its bytes to the free block, any other leaves a hole
+    if (entry->offset == header->heapStart)
+        header->heapStart += size;
+    header->freeBytes += size;
+    entry->offset = 0;
+    entry->length = 0;
+}
+
+// helper to grow a table by one page, linked into the chain right after the main page
+// and put on the table's free-space list
+// returns the page number of the new page and NO_PAGE for failure
+int addTablePage(RM_TableState *table, Schema *schema)
+{
+    RM_PageHeader *mainHeader = getPageHeader(table->handle);
+    int nextPage = mainHeader->nextPage;
+    int newPage = getFreePage();
+    if (newPage == NO_PAGE)
+        return NO_PAGE;
+
+    USE_PAGE_HANDLE_HEADER(NO_PAGE);
+    setPageClass(&bufferPool, newPage, table->entry->pageNum);
+    BEGIN_USE_PAGE_HANDLE_HEADER(newPage);
+    {
+        formatTablePage(&handle, schema, table->entry->layout);
+        header->prevPage = table->entry->pageNum;
+        header->nextPage = nextPage;
+        pushFreeSpacePage(table, &handle, getMaxStoredSize(schema));
+        markDirty(&bufferPool, &handle);
+    }
+    END_USE_PAGE_HANDLE_HEADER();
+
+    // the page that used to follow the main page now follows the new one
+    if (nextPage != NO_PAGE)
+    {
+        BEGIN_USE_PAGE_HANDLE_HEADER(nextPage);
+        {
+            header->prevPage = newPage;
+            markDirty(&bufferPool, &handle);
+        }
+        END_USE_PAGE_HANDLE_HEADER();
+    }
+    mainHeader->nextPage = newPage;
+    markDirty(&bufferPool, table->handle);
+    return newPage;
+}
+
+// helper to pin a page of an open table, its main page is pinned already while it is open
+RC pinTablePage(RM_TableState *table, int pageNum, BM_PageHandle *handle)
+{
+    if (pageNum == table->entry->pageNum)
+    {
+        *handle = *(table->handle);
+        return RC_OK;
+    }
+    return pinPage(&bufferPool, handle, pageNum);
+}
+
+RC unpinTablePage(RM_TableState *table, BM_PageHandle *handle)
+{
+    if (handle->pageNum == table->entry->pageNum)
+        return RC_OK;
+    return unpinPage(&bufferPool, handle);
+}
+
+// helper to put a page that has room again back on its table's free-space list
+void pushFreeSpacePage(RM_TableState *table, BM_PageHandle *handle, int maxStored)
+{
+    RM_PageHeader *header = getPageHeader(handle);
+    BM_PageHandle first;
+    if (header->onFreeSpaceList || !hasTupleRoom(header, maxStored))
+        return;
+
+    // the old first page now comes after this one
+    if (table->entry->freeSpacePage != NO_PAGE && pinTablePage(table, table->entry->freeSpacePage, &first) == RC_OK)
+    {
+        getPageHeader(&first)->prevFreeSpace = handle->pageNum;
+        markDirty(&bufferPool, &first);
+        unpinTablePage(table, &first);
+    }
+    header->nextFreeSpace = table->entry->freeSpacePage;
+    header->prevFreeSpace = NO_PAGE;
+    header->onFreeSpaceList = TRUE;
+    table->entry->freeSpacePage = handle->pageNum;
+    markTableDirty(table);
+}
+
+// helper to take a page off its table's free-space list, wherever it is on the list
+void removeFreeSpacePage(RM_TableState *table, BM_PageHandle *handle)
+{
+    RM_PageHeader *header = getPageHeader(handle);
+    BM_PageHandle other;
+    if (!header->onFreeSpaceList)
+        return;
+
+    if (table->entry->freeSpacePage == handle->pageNum)
+    {
+        table->entry->freeSpacePage = header->nextFreeSpace;
+    }
+    else
+    {
+        // link the pages before and after the page to each other
+        if (pinTablePage(table, header->prevFreeSpace, &other) == RC_OK)
+        {
+            getPageHeader(&other)->nextFreeSpace = header->nextFreeSpace;
+            markDirty(&bufferPool, &other);
+            unpinTablePage(table, &other);
+        }
+        if (header->nextFreeSpace != NO_PAGE && pinTablePage(table, header->nextFreeSpace, &other) == RC_OK)
+        {
+            getPageHeader(&other)->prevFreeSpace = header->prevFreeSpace;
+            markDirty(&bufferPool, &other);
+            unpinTablePage(table, &other);
+        }
+    }
+    header->nextFreeSpace = NO_PAGE;
+    header->prevFreeSpace = NO_PAGE;
+    header->onFreeSpaceList = FALSE;
+    markTableDirty(table);
+}
+
+// helper to put every page of an open table (and its column segments) in the table's buffer page class
+// returns 0 for success and 1 for failure
+int setTablePageClass(RM_TableState *table)
+{
+    BM_PageHandle page;
+    int pageNum = table->entry->pageNum;
+
+    while (pageNum != NO_PAGE)
+    {
+        if (setPageClass(&bufferPool, pageNum, table->entry->pageNum) != RC_OK || pinTablePage(table, pageNum, &page) != RC_OK)
+            return 1;
+        RM_PageHeader *header = getPageHeader(&page);
+        if (header->layout == RM_LAYOUT_COLUMN)
+        {
+            RM_ColumnSegment *segments = getColumnSegments(&page);
+            for (int i = 0; i < getNumSegments(header); i++)
+            {
+                if (segments[i].pageNum != NO_PAGE)
+                    setPageClass(&bufferPool, segments[i].pageNum, table->entry->pageNum);
+            }
+        }
+        pageNum = header->nextPage;
+        if (unpinTablePage(table, &page) != RC_OK)
+            return 1;
+    }
+    return 0;
+}
+
+// helper to give an empty overflow page back to the free list, after taking it
+// off the table's free-space list and out of the table's page chain
+// returns 0 for success and 1 for failure
+int reclaimTablePage(RM_TableState *table, BM_PageHandle *page)
+{
+    RM_PageHeader *pageHeader = getPageHeader(page);
+    BM_PageHandle other;
+    removeFreeSpacePage(table, page);
+    if (pageHeader->layout == RM_LAYOUT_COLUMN && freeColumnSegments(page) != 0)
+        return 1;
+
+    // an overflow page always comes after another page of the table, at least the main page
+    if (pinTablePage(table, pageHeader->prevPage, &other) != RC_OK)
+        return 1;
+    getPageHeader(&other)->nextPage = pageHeader->nextPage;
+    markDirty(&bufferPool, &other);
+    if (unpinTablePage(table, &other) != RC_OK)
+        return 1;
+
+    if (pageHeader->nextPage != NO_PAGE)
+    {
+        if (pinTablePage(table, pageHeader->nextPage, &other) != RC_OK)
+            return 1;
+        getPageHeader(&other)->prevPage = pageHeader->prevPage;
+        markDirty(&bufferPool, &other);
+        if (unpinTablePage(table, &other) != RC_OK)
+            return 1;
+    }
+    return setFreePage(page);
+}
+
+// helper to free a slot and its tuple on a pinned page of the table
+void freeSlot(RM_TableState *table, BM_PageHandle *handle, int slot, int maxStored)
+{
+    RM_PageHeader *header = getPageHeader(handle);
+    releaseTuple(handle, slot);
+    setSlotUsed(getSlotMap(handle), slot, FALSE);
+    header->numFree++;
+
+    // An overflow page that became empty is given back right away, unless a scan or a
+    // borrowed record of the table may be on it, then the last one to finish gives it back
+    if (header->numFree == header->numSlots && handle->pageNum != table->entry->pageNum)
+    {
+        if (table->numScans == 0 && table->numBorrows == 0 && reclaimTablePage(table, handle) == 0)
+            return;
+        table->numEmptyPages++;
+    }
+    pushFreeSpacePage(table, handle, maxStored);
+}
+
+// helper to store a tuple on the first page of the free-space list, the table grows when the
+// list is empty and a page that lost its room to updates is only taken off the list here
+// returns the RID of the tuple in id
+RC storeTuple(RM_TableState *table, Schema *schema, const char *tuple, int length, int flags, RID *id)
+{
+    int maxStored = getMaxStoredSize(schema);
+    BM_PageHandle handle;
+    RM_PageHeader *header;
+    RC result;
+
+    while (true)
+    {
+        if (table->entry->freeSpacePage == NO_PAGE && addTablePage(table, schema) == NO_PAGE)
+            return RC_WRITE_FAILED;
+        result = pinTablePage(table, table->entry->freeSpacePage, &handle);
+        if (result != RC_OK)
+            return result;
+        header = getPageHeader(&handle);
+        if (hasTupleRoom(header, maxStored))
+            break;
+
+        removeFreeSpacePage(table, &handle);
+        markDirty(&bufferPool, &handle);
+        unpinTablePage(table, &handle);
+    }
+
+    // Take the first free slot of the page
+    id->page = handle.pageNum;
+    id->slot = findFreeSlot(getSlotMap(&handle), header->numSlots);
+    if (header->layout == RM_LAYOUT_COLUMN)
+    {
+        result = writeColumns(table, schema, &handle, id->slot, tuple);
+        if (result != RC_OK)
+        {
+            markDirty(&bufferPool, &handle);
+            unpinTablePage(table, &handle);
+            return result;
+        }
+    }
+    else
+        placeTuple(&handle, id->slot, tuple, length, flags);
+    setSlotUsed(getSlotMap(&handle), id->slot, TRUE);
+    header->numFree--;
+
+    // A page without room for another tuple leaves the free-space list
+    if (!hasTupleRoom(header, maxStored))
+        removeFreeSpacePage(table, &handle);
+
+    result = markDirty(&bufferPool, &handle);
+    RC unpinResult = unpinTablePage(table, &handle);
+    return (result != RC_OK) ? result : unpinResult;
+}
+
+// helper to unpack the record of a slot on a pinned page into data, a forwarded record
+// is read from the page it moved to
+RC readTuple(RM_TableState *table, Schema *schema, BM_PageHandle *handle, int slot, char *data)
+{
+    if (getPageHeader(handle)->layout == RM_LAYOUT_PAX)
+    {
+        gatherColumns(handle, slot, ~0, data);
+        return RC_OK;
+    }
+    if (getPageHeader(handle)->layout == RM_LAYOUT_COLUMN)
+        return readColumns(table, handle, slot, ~0, NULL, data);
+
+    RM_SlotEntry *entry = &(getSlotDirectory(handle)[slot]);
+    char *tuple = handle->data + entry->offset;
+
+    if (entry->length & SLOT_FORWARD)
+    {
+        RID target;
+        BM_PageHandle targetHandle;
+        memcpy(&target, tuple, sizeof(RID));
+        RC result = pinTablePage(table, target.page, &targetHandle);
+        if (result != RC_OK)
+            return result;
+        unpackTuple(schema, getTupleDataAt(&targetHandle, target.slot) + sizeof(RID), data);
+        return unpinTablePage(table, &targetHandle);
+    }
+    unpackTuple(schema, tuple, data);
+    return RC_OK;
+}
+
+#define BEGIN_SLOT_WALK(table) \
+BM_PageHandle walkHandle = *(table->handle); \
+BM_PageHandle *handle = &walkHandle; \
+uint64_t* slots; \
+int slotIndex = -1; \
+int slotResult = 0;
+
+// call the above macro before initiating the slot walk
+// gets the next slotIndex along with the right slots array
+// if the page finished, it unpins the page (unless its the main page)
+// closeSlots must be called on termination (last page must be manually closed!)
+// 0 for success, 1 for failure, -1 for no more slots
+int getNextSlotInWalk(RM_TableState *table, BM_PageHandle **handle, uint64_t** slots, int *slotIndex)
+{
+    RC result;
+    RM_PageHeader *header = getPageHeader(*handle);
+    *slots = getSlotMap(*handle);
+    
+    // Use switch-case for slot index comparison
+    switch (*slotIndex + 1 < header->numSlots)
+    {
+        case 1:  // True: There are more slots to process in the current page
+            (*slotIndex)++;
+            return 0;
+        default:  // False: No more slots in the current page, need to handle page transition
+            break;
+    }
+
+    *slotIndex = -1;
+    int nextPage = header->nextPage;
+    
+    // Nested switch-case for checking page transition conditions
+    switch (nextPage != NO_PAGE)
+    {
+        case 1:  // True: There is a next page
+            {
+                // pin the next page through the current one (a swizzled link skips the page table,
+                // and the page joins the table's buffer class) before letting go of the current one
+                BM_PageHandle next;
+                result = pinNextPage(&bufferPool, &next, *handle, nextPage);
+                switch (result)
+                {
+                    case RC_OK:
+                        break;  // Continue if pin successful
+                    default:
+                        return 1;  // Error handling if pin fails
+                }
+                if (table->entry->pageNum != (*handle)->pageNum)
+                {
+                    result = unpinPage(&bufferPool, *handle);
+                    switch (result)
+                    {
+                        case RC_OK:
+                            break;  // Continue if unpin successful
+                        default:
+                            return 1;  // Error handling if unpin fails
+                    }
+                }
+                **handle = next;
+                return getNextSlotInWalk(table, handle, slots, slotIndex);  // Recursion to continue the walk
+            }
+
+        default:  // False: No next page, end of slots
+            return -1;
+    }
+}
+
+int closeSlotWalk(RM_TableState *table, BM_PageHandle **handle)
+{
+    // Create a condition that is suitable for using in a switch-case
+    int condition = (table->entry->pageNum != (*handle)->pageNum) ? 1 : 0;
+
+    switch (condition)
+    {
+        case 1:
+            {
+                RC result = unpinPage(&bufferPool, *handle);
+                switch (result)
+                {
+                    case RC_OK:
+                        break;  // Successfully unpinned, proceed normally.
+                    default:
+                        return 1;  // Error in unpinning
+                }
+            }
+            break;
+        default:
+            break;  // No action needed if page numbers are the same
+    }
+    
+    return 0;  // Indicate successful closure
+}
+
+
+
+/* Table and Manager */
+
+RC initRecordManager(void *mgmtData) {
+    // Ensure the system catalog and at least one table entry fit into page 0
+    if (PAGE_SIZE < CATALOG_PAGE_OFFSET(0) + sizeof(RM_CatalogPage) + sizeof(ResourceManagerSchema)) {
+        return RC_IM_NO_MORE_ENTRIES;
+    }
+
+    RC result;
     char *fileName;
     bool newSystem = 0;
 
@@ -449,7 +1812,13 @@ RC initRecordManager(void *mgmtData) {
 
     // Initialize buffer pool with a do-while loop
     do {
-        result = initBufferPool(&bufferPool, fileName, 16, RS_LRU, NULL);
+        result = initBufferPool(&bufferPool, fileName, BUFFER_POOL_SIZE, RS_LRU, NULL);
+        if (result == RC_OK) {
+            result = setVictimCacheSize(&bufferPool, VICTIM_CACHE_SIZE);
+        }
+        if (result == RC_OK) {
+            result = setSwizzling(&bufferPool, SWIZZLE_PAGE_CHAINS);
+        }
         if (result == RC_OK) {
             break; // Exit the loop if buffer pool is initialized successfully
         } else {
@@ -467,54 +1836,104 @@ RC initRecordManager(void *mgmtData) {
         }
     } while (0); // Loop runs only once
 
-    // Additional initialization code can go here
-
-    return RC_OK; // Return success
-}
-            return result;
-    }
-
     // Create system schema if it's a new file using a switch-case to check newSystem status
     switch (newSystem) {
         case 1:
             {
                 RM_SystemCatalog *catalog = getSystemCatalog();
+                catalog->format = CATALOG_FORMAT;
                 catalog->totalNumPages = 1;
                 catalog->freePage = NO_PAGE;
                 catalog->numTables = 0;
+                catalog->numCatalogPages = 1;
+                catalog->firstOpenCatalogPage = 0;
+                getCatalogPage(&catalogPageHandle, 0)->nextCatalogPage = NO_PAGE;
+                getCatalogPage(&catalogPageHandle, 0)->numTables = 0;
                 markSystemCatalogDirty();
                 break;
             }
         default:
-            // No action needed if not a new system
+            // an existing page file must have been created with the same catalog layout
+            if (getSystemCatalog()->format != CATALOG_FORMAT) {
+                unpinPage(&bufferPool, &catalogPageHandle);
+                shutdownBufferPool(&bufferPool);
+                return RC_RM_UNKNOWN_CATALOG_FORMAT;
+            }
             break;
     }
 
-    RM_SystemCatalog *catalog = getSystemCatalog();  // This might be unused if you follow strict C standards for variable use
+    // Index the table names of the catalog
+    if (indexTableNames() != 0) {
+        return RC_ALLOCATION_FAILED;
+    }
 
     return RC_OK;
 }
 
 
+RC checkpointRecordManager() {
+    RM_SystemCatalog *catalog = getSystemCatalog();
+    BM_PageHandle handle;
+
+    // Write the table pages before the counts that take in their tuples, so that the catalog
+    // is never ahead of them on disk
+    if (flushTablePages() != 0) {
+        return RC_WRITE_FAILED;
+    }
+
+    // Fold the pending tuple counts of the open tables into their catalog entries and
+    // write the catalog pages, which stay pinned while the catalog or a table on them is open
+    for (int pageIndex = 0; pageIndex < catalog->numCatalogPages; pageIndex++) {
+        if (pinPage(&bufferPool, &handle, catalogPageNums[pageIndex]) != RC_OK) {
+            return RC_WRITE_FAILED;
+        }
+        int firstIndex = getFirstTableIndex(pageIndex);
+        for (int tableIndex = firstIndex; tableIndex < firstIndex + (int)CATALOG_PAGE_TABLES(pageIndex); tableIndex++) {
+            RM_TableState *table = getOpenTable(tableIndex);
+            if (table != NULL) {
+                checkpointTableEntry(table);
+            }
+        }
+        RC result = forcePinnedPage(&bufferPool, &handle);
+        RC unpinResult = unpinPage(&bufferPool, &handle);
+        if (result != RC_OK) return result;
+        if (unpinResult != RC_OK) return unpinResult;
+    }
+
+    return RC_OK;
+}
+
 RC shutdownRecordManager() {
-    RC result = unpinPage(&bufferPool, &catalogPageHandle);
+    RC result = checkpointRecordManager();
     if (result != RC_OK) return result;
+    result = unpinPage(&bufferPool, &catalogPageHandle);
+    if (result != RC_OK) return result;
+    freeKeyTable(&tableNames);
+    free(catalogPageNums);
+    catalogPageNums = NULL;
+    free(openTables);
+    openTables = NULL;
+    numOpenTableSlots = 0;
     return shutdownBufferPool(&bufferPool);
 }
 
 RC createTable(char *name, Schema *schema) {
+    return createTableWithLayout(name, schema, RM_LAYOUT_ROW);
+}
+
+RC createTableWithLayout(char *name, Schema *schema, RM_TableLayout layout) {
     RM_SystemCatalog *catalog = getSystemCatalog();
 
     // Check if table already exists
-    if (getTableByName(name) != NULL) {
+    if (getTableIndex(name) != -1) {
         return RC_WRITE_FAILED; // Table exists
     }
 
-    // Check if catalog can hold another table and schema is correct
+    // Check if schema is correct (the catalog grows by a page when it is full)
     int conditions[] = {
-        catalog->numTables < MAX_NUM_TABLES,
         schema->numAttr <= MAX_NUM_ATTR,
-        schema->keySize <= MAX_NUM_KEYS
+        schema->keySize <= MAX_NUM_KEYS,
+        layout == RM_LAYOUT_ROW || layout == RM_LAYOUT_PAX || layout == RM_LAYOUT_COLUMN
     };
 
     // Use a for loop to check conditions
@@ -524,15 +1943,24 @@ RC createTable(char *name, Schema *schema) {
         }
     }
 
-    // Continue with the table creation logic here...
-    
-    return RC_OK; // Return success if all checks pass
-}
-    ResourceManagerSchema *table = &(catalog->tables[catalog->numTables]);
+    if (getRecordsPerPage(schema, layout) <= 0) return RC_WRITE_FAILED;
+
+    // Take a free catalog entry, which keeps its index until the table is deleted
+    int tableIndex = takeTableEntry();
+    if (tableIndex == -1) return RC_WRITE_FAILED;
+    BM_PageHandle entryHandle;
+    ResourceManagerSchema *table = pinTableEntry(tableIndex, &entryHandle);
+    if (table == NULL) return RC_WRITE_FAILED;
+
+    table->pageNum = getFreePage();
+    if (table->pageNum == NO_PAGE) {
+        unpinPage(&bufferPool, &entryHandle);
+        return RC_WRITE_FAILED;
+    }
     strncpy(table->name, name, TABLE_NAME_SIZE - 1);
     table->name[TABLE_NAME_SIZE - 1] = '\0'; // Ensure null termination
     table->numTuples = 0;
-    table->handle = NULL;
+    table->layout = layout;
 
     // Copy attribute data
     table->numAttr = schema->numAttr;
@@ -554,85 +1982,93 @@ RC createTable(char *name, Schema *schema) {
         table->keyAttrs[keyIndex] = schema->keyAttrs[keyIndex];
         keyIndex++;
     }
+    table->freeSpacePage = table->pageNum;
+    int pageNum = table->pageNum;
+    getCatalogPage(&entryHandle, getCatalogPageIndex(tableIndex))->numTables++;
+    markDirty(&bufferPool, &entryHandle);
+    RC entryResult = unpinPage(&bufferPool, &entryHandle);
+    if (entryResult != RC_OK) return entryResult;
+    if (setKey(&tableNames, name, strlen(name), &tableIndex, sizeof(int)) != 0) return RC_ALLOCATION_FAILED;
     catalog->numTables++;
 
-    table->pageNum = getFreePage();
-    if (table->pageNum == NO_PAGE) return RC_WRITE_FAILED;
-
-    // Initialize page
-    int pageHeader = sizeof(pageHeader);
-    int slotSize = sizeof(bool);
-    int recordSize = getRecordSize(schema);
-    int recordsPerPage = (PAGE_SIZE - pageHeader) / (recordSize + slotSize);
-    if (recordsPerPage <= 0) return RC_WRITE_FAILED;
-
+    // Initialize page, the main page starts out as the whole free-space list
     USE_PAGE_HANDLE_HEADER(RC_WRITE_FAILED);
-    BEGIN_USE_PAGE_HANDLE_HEADER(table->pageNum);
+    BEGIN_USE_PAGE_HANDLE_HEADER(pageNum);
     {
         // Mark all the slots as free
-        bool *slots = getSlots(&handle);
-        header->numSlots = recordsPerPage;
-        int slotIndex = 0;
-        while (slotIndex < recordsPerPage)
-        {
-            slots[slotIndex] = FALSE;
-            slotIndex++;
-        }
+        formatTablePage(&handle, schema, layout);
+        header->onFreeSpaceList = TRUE;
         markDirty(&bufferPool, &handle);
     }
     END_USE_PAGE_HANDLE_HEADER();
 
     markSystemCatalogDirty();
     return RC_OK;
-    }
+}
 
 RC openTable(RM_TableData *rel, char *name)
 {
-    ResourceManagerSchema *table = getTableByName(name);
+    int tableIndex = getTableIndex(name);
+    if (tableIndex == -1)
+        return RC_IM_KEY_NOT_FOUND;
+    if (getOpenTable(tableIndex) != NULL)
+        return RC_WRITE_FAILED;
 
-    // Using switch-case for initial null check and handle validation
-    switch ((intptr_t)table)
+    // make room for the table in the open table index
+    if (tableIndex >= numOpenTableSlots)
     {
-        case (intptr_t)NULL:
-            return RC_IM_KEY_NOT_FOUND;
-        default:
-            if (table->handle != NULL) 
-                return RC_WRITE_FAILED;
-            break;
+        int numSlots = (tableIndex + 1) * 2;
+        RM_TableState **slots = (RM_TableState **)realloc(openTables, sizeof(RM_TableState *) * numSlots);
+        if (slots == NULL)
+            return RC_ALLOCATION_FAILED;
+        memset(slots + numOpenTableSlots, 0, sizeof(RM_TableState *) * (numSlots - numOpenTableSlots));
+        openTables = slots;
+        numOpenTableSlots = numSlots;
+    }
+    RM_TableState *table = (RM_TableState *)calloc(1, sizeof(RM_TableState));
+    if (table == NULL)
+        return RC_ALLOCATION_FAILED;
+    table->tableIndex = tableIndex;
+
+    // the catalog page of the entry stays pinned until the table is closed
+    table->entryHandle = (BM_PageHandle *)malloc(sizeof(BM_PageHandle));
+    table->entry = pinTableEntry(tableIndex, table->entryHandle);
+    if (table->entry == NULL)
+    {
+        free(table->entryHandle);
+        free(table);
+        return RC_WRITE_FAILED;
     }
+    openTables[tableIndex] = table;
 
-    rel->name = table->name;
+    rel->name = table->entry->name;
     rel->schema = (Schema *)malloc(sizeof(Schema));
-    rel->schema->attrNames = (char **)malloc(sizeof(char*) * table->numAttr);
+    char **attrNames = (char **)malloc(sizeof(char*) * table->entry->numAttr);
 
     // point to attribute data
-    rel->schema->numAttr = table->numAttr;
     int attrIndex = 0;
-    while (attrIndex < table->numAttr) // Converted for loop to while loop
+    while (attrIndex < table->entry->numAttr) // Converted for loop to while loop
     {
-        rel->schema->attrNames[attrIndex] = &(table->attrNames[attrIndex * ATTR_NAME_SIZE]);
+        attrNames[attrIndex] = &(table->entry->attrNames[attrIndex * ATTR_NAME_SIZE]);
         attrIndex++;
     }
-    
-    rel->schema->dataTypes = table->dataTypes;
-    rel->schema->typeLength = table->typeLength;
 
-    // point to key data
-    rel->schema->keySize = table->keySize;
-    rel->schema->keyAttrs = table->keyAttrs;
+    // point to attribute and key data
+    initSchema(rel->schema, table->entry->numAttr, attrNames, table->entry->dataTypes, table->entry->typeLength,
+               table->entry->keySize, table->entry->keyAttrs);
 
-    // the RM_TableData will also point to the system schema
-    // the system schema stays open until the RM is shut down 
+    // the RM_TableData points to the open table's state, which leads to its catalog entry
     rel->mgmtData = (void *)table;
     table->handle = (BM_PageHandle *)malloc(sizeof(BM_PageHandle));
 
-    // pin the table's page
-    RC result = pinPage(&bufferPool, table->handle, table->pageNum);
+    // pin the table's page, the main page number doubles as the table's buffer page class
+    setPageClass(&bufferPool, table->entry->pageNum, table->entry->pageNum);
+    RC result = pinPage(&bufferPool, table->handle, table->entry->pageNum);
     return result;
 }
 
 RC closeTable(RM_TableData *rel) {
-    ResourceManagerSchema *table = getSystemSchema(rel);
+    RM_TableState *table = getTableState(rel);
 
     RC result;
 
@@ -652,58 +2088,120 @@ RC closeTable(RM_TableData *rel) {
 
     } while (0); // Loop runs only once
 
-    return RC_OK; // Return success if all operations complete without error
-}
-
     // Free allocated memory
+    clearSchema(rel->schema);
     free((void *)rel->schema->attrNames);
     free((void *)rel->schema);
     free(table->handle);
     table->handle = NULL;
-    return RC_OK;
+
+    // the entry is written back with its tuple count once its page is let go
+    checkpointTableEntry(table);
+    BM_PageHandle *entryHandle = table->entryHandle;
+    result = unpinPage(&bufferPool, entryHandle);
+    free(entryHandle);
+    openTables[table->tableIndex] = NULL;
+    free(table);
+    return result;
 }
 
 RC deleteTable(char *name) {
     RM_SystemCatalog *catalog = getSystemCatalog();
 
-    // Use a for loop to scan the catalog for the table
-    for (int tableIndex = 0; tableIndex < catalog->numTables; tableIndex++) {
-        ResourceManagerSchema *table = &(catalog->tables[tableIndex]);
-        int nameMatch = strcmp(table->name, name); // Store comparison result
+    // Find the entry through the name index
+    int tableIndex = getTableIndex(name);
+    if (tableIndex == -1) {
+        return RC_IM_KEY_NOT_FOUND; // Table not found
+    }
+    BM_PageHandle entryHandle;
+    ResourceManagerSchema *table = pinTableEntry(tableIndex, &entryHandle);
+    if (table == NULL) {
+        return RC_WRITE_FAILED;
+    }
 
-        // Use switch-case to handle matching name case
-        switch (nameMatch) {
-            case 0:  // Name matches
-                {
-                    int appendResult = appendToFreeList(table->pageNum);
-                    switch (appendResult) {
-                        case 1:
-                            return RC_WRITE_FAILED;
+    // a column table's segments are not in its page chain
+    int appendResult = (getOpenTable(tableIndex) != NULL) ? 1
+        : (table->layout == RM_LAYOUT_COLUMN && freeTableSegments(table->pageNum) != 0)
+        ? 1 : appendToFreeList(table->pageNum);
 
-                        default:
-                            // Shift entries in the table catalog down
-                            catalog->numTables--;
-                            for (int remainingIndex = tableIndex; remainingIndex < catalog->numTables; remainingIndex++) {
-                                catalog->tables[remainingIndex] = catalog->tables[remainingIndex + 1];
-                            }
-                            markSystemCatalogDirty();
-                            return RC_OK;
-                    }
-                }
+    // Use switch-case to handle the outcome of freeing the pages
+    switch (appendResult) {
+        case 1:
+            unpinPage(&bufferPool, &entryHandle);
+            return RC_WRITE_FAILED;
 
-            default:
-                // Name does not match, continue scanning
-                break;
-        }
+        default:
+            // The entry is freed in place, no other entry moves
+            if (removeKey(&tableNames, table->name, strlen(table->name)) != 0) {
+                unpinPage(&bufferPool, &entryHandle);
+                return RC_WRITE_FAILED;
+            }
+            memset(table, 0, sizeof(ResourceManagerSchema));
+            getCatalogPage(&entryHandle, getCatalogPageIndex(tableIndex))->numTables--;
+            markDirty(&bufferPool, &entryHandle);
+
+            catalog->numTables--;
+            if (getCatalogPageIndex(tableIndex) < catalog->firstOpenCatalogPage) {
+                catalog->firstOpenCatalogPage = getCatalogPageIndex(tableIndex);
+            }
+            markSystemCatalogDirty();
+            return unpinPage(&bufferPool, &entryHandle);
     }
-    return RC_IM_KEY_NOT_FOUND; // Table not found
 }
 
 
+RC vacuumTable (RM_TableData *rel)
+{
+    RM_TableState *table = getTableState(rel);
+    RC result;
+
+    // a scan or a borrowed record may be on any of the pages
+    if (table->numScans > 0 || table->numBorrows > 0)
+        return RC_WRITE_FAILED;
+
+    // walk the overflow pages and give back the empty ones
+    int pageNum = getPageHeader(table->handle)->nextPage;
+    while (pageNum != NO_PAGE)
+    {
+        BM_PageHandle handle;
+        result = pinTablePage(table, pageNum, &handle);
+        if (result != RC_OK)
+            return result;
+
+        RM_PageHeader *header = getPageHeader(&handle);
+        pageNum = header->nextPage;
+        if (header->numFree == header->numSlots && reclaimTablePage(table, &handle) != 0)
+        {
+            unpinTablePage(table, &handle);
+            return RC_WRITE_FAILED;
+        }
+        result = unpinTablePage(table, &handle);
+        if (result != RC_OK)
+            return result;
+    }
+    table->numEmptyPages = 0;
+    markTableDirty(table);
+    return RC_OK;
+}
+
 int getNumTuples (RM_TableData *rel)
 {
-    ResourceManagerSchema *table = getSystemSchema(rel);
-    return table->numTuples;
+    RM_TableState *table = getTableState(rel);
+    return table->entry->numTuples + __atomic_load_n(&(table->pendingTuples), __ATOMIC_RELAXED);
+}
+
+RC setTableBufferQuota (RM_TableData *rel, int reservedFrames, int maxFrames, int priority)
+{
+    RM_TableState *table = getTableState(rel);
+
+    // the table's pages are tagged with its main page number as they join the table,
+    // the ones it had before the buffer pool was started are tagged here
+    if (setTablePageClass(table) != 0)
+        return RC_WRITE_FAILED;
+    RC result = setClassQuota(&bufferPool, table->entry->pageNum, reservedFrames, maxFrames);
+    if (result != RC_OK)
+        return result;
+    return setClassPriority(&bufferPool, table->entry->pageNum, priority);
 }
 
 /* Manager stats */
@@ -728,16 +2226,16 @@ int getNumFreePages()
             break;
     }
 
-    int count = 1;
+    int count = 0;
 
     // Changed while loop to do-while loop
     do
     {
         BEGIN_USE_PAGE_HANDLE_HEADER(curPage);
+        count++;
         // Check if this is the last page in the chain
         switch (header->nextPage) {
             case NO_PAGE:
-                count++;
                 END_USE_PAGE_HANDLE_HEADER();
                 return count;
 
@@ -757,85 +2255,194 @@ int getNumTables()
 
 /* Handling records in a table */
 /* Handling records in a table */
- RC insertRecord(RM_TableData *rel, Record *record) {
-    ResourceManagerSchema *schema = getSystemSchema(rel);
-    bool *slotAvailability;
-    BEGIN_SLOT_WALK(schema);
-
-    // Loop indefinitely until we find a slot or exhaust options
-    for (;;) {
-        int slotResult = getNextSlotInWalk(schema, &handle, &slotAvailability, &slotIndex);
-        
-        // Handle the result of getting the next slot
-        if (slotResult != 0) {
-            if (slotResult == -1) {
-                // Need a new page
-                int newPage = getFreePage();
-                if (newPage == NO_PAGE) {
-                    closeSlotWalk(schema, &handle);
-                    return RC_WRITE_FAILED;
-                }
-                RC result = pinPage(&bufferPool, handle, newPage);
-                if (result != RC_OK) {
-                    closeSlotWalk(schema, &handle);
-                    return result;
-                }
-                slotIndex = 0; // Reset slot index for the new page
-                continue; // Continue to find the next slot
-            } else {
-                // An error occurred
-                closeSlotWalk(schema, &handle);
-                return RC_WRITE_FAILED;
-            }
+#define BEGIN_USE_TABLE_PAGE_HANDLE_HEADER(id) \
+RM_TableState *table = getTableState(rel); \
+USE_PAGE_HANDLE_HEADER(RC_WRITE_FAILED); \
+if (id.page == table->entry->pageNum) \
+{ \
+    handle = *table->handle; \
+    header = getPageHeader(&handle); \
+} \
+else \
+{ \
+    BEGIN_USE_PAGE_HANDLE_HEADER(id.page) \
+}
+
+#define END_USE_TABLE_PAGE_HANDLE_HEADER() \
+if (id.page != table->entry->pageNum) \
+{ \
+    END_USE_PAGE_HANDLE_HEADER() \
+}
+
+RC insertRecord(RM_TableData *rel, Record *record) {
+    RM_TableState *table = getTableState(rel);
+    char tuple[PAGE_SIZE];
+
+    // Every page with room is on the table's free-space list,
+    // the table only grows when the list is empty
+    int length = encodeRecord(table, rel->schema, record->data, tuple);
+    RC result = storeTuple(table, rel->schema, tuple, length, 0, &(record->id));
+    if (result != RC_OK) {
+        return result;
+    }
+
+    addPendingTuples(table, 1);
+    return RC_OK;
+}
+
+RC insertRecords(RM_TableData *rel, Record **records, int numRecords, RID *rids) {
+    RM_TableState *table = getTableState(rel);
+    RM_BulkLoadHandle loader;
+    RC result;
+    int i = 0;
+
+    // Fill the pages with room on the free-space list first, as insertRecord would
+    while (i < numRecords && table->entry->freeSpacePage != NO_PAGE) {
+        result = insertRecord(rel, records[i]);
+        if (result != RC_OK) {
+            return result;
+        }
+        if (rids != NULL) {
+            rids[i] = records[i]->id;
+        }
+        i++;
+    }
+    if (i == numRecords) {
+        return RC_OK;
+    }
+
+    result = startBulkLoad(rel, &loader);
+    if (result != RC_OK) {
+        return result;
+    }
+
+    // Load the rest onto fresh pages, the ones loaded before an error are kept
+    for (; i < numRecords && result == RC_OK; i++) {
+        result = loadRecord(&loader, records[i]);
+        if (result == RC_OK && rids != NULL) {
+            rids[i] = records[i]->id;
+        }
+    }
+
+    RC finishResult = finishBulkLoad(&loader);
+    return (result != RC_OK) ? result : finishResult;
+}
+
+RC startBulkLoad(RM_TableData *rel, RM_BulkLoadHandle *loader) {
+    RM_BulkLoadData *loadData = (RM_BulkLoadData *)malloc(sizeof(RM_BulkLoadData));
+    if (loadData == NULL) {
+        return RC_ALLOCATION_FAILED;
+    }
+
+    loadData->handle.pageNum = NO_PAGE;
+    loadData->firstPage = NO_PAGE;
+    loadData->maxStored = getMaxStoredSize(rel->schema);
+    loadData->numLoaded = 0;
+    loader->rel = rel;
+    loader->mgmtData = loadData;
+    return RC_OK;
+}
+
+RC loadRecord(RM_BulkLoadHandle *loader, Record *record) {
+    RM_BulkLoadData *loadData = (RM_BulkLoadData *)loader->mgmtData;
+    RM_TableState *table = getTableState(loader->rel);
+    BM_PageHandle *handle = &(loadData->handle);
+    RC result;
+    char tuple[PAGE_SIZE];
+    int length = encodeRecord(table, loader->rel->schema, record->data, tuple);
+
+    // Move on to a fresh page when there is none yet or the current one is full,
+    // a finished page is written once (one markDirty) when it is let go
+    if (handle->pageNum == NO_PAGE || !hasTupleRoom(getPageHeader(handle), getStoredSize(length))) {
+        BM_PageHandle next;
+        int newPage = getFreePage();
+        if (newPage == NO_PAGE) {
+            return RC_WRITE_FAILED;
+        }
+        setPageClass(&bufferPool, newPage, table->entry->pageNum);
+        result = pinPage(&bufferPool, &next, newPage);
+        if (result != RC_OK) {
+            return result;
         }
+        formatTablePage(&next, loader->rel->schema, table->entry->layout);
 
-        // Check if the slot is available
-        if (!slotAvailability[slotIndex]) {
-            int recordSize = getRecordSize(rel->schema);
-            char *tupleData = getTupleDataAt(handle, recordSize, slotIndex);
-            memcpy(tupleData, record->data, recordSize);
-            slotAvailability[slotIndex] = true;
-
-            RC result = markDirty(&bufferPool, handle);
+        if (handle->pageNum == NO_PAGE) {
+            loadData->firstPage = newPage;
+            getPageHeader(&next)->prevPage = table->entry->pageNum;
+        } else {
+            getPageHeader(handle)->nextPage = newPage;
+            getPageHeader(&next)->prevPage = handle->pageNum;
+            markDirty(&bufferPool, handle);
+            result = unpinPage(&bufferPool, handle);
             if (result != RC_OK) {
+                unpinPage(&bufferPool, &next);
                 return result;
             }
+        }
+        *handle = next;
+    }
 
-            // Set the record ID
-            record->id.page = handle->pageNum;
-            record->id.slot = slotIndex;
-            schema->numTuples++;
-            markSystemCatalogDirty();
-            closeSlotWalk(schema, &handle);
-            return RC_OK;
+    // Fill the slots in order
+    RM_PageHeader *header = getPageHeader(handle);
+    int slot = header->numSlots - header->numFree;
+    if (header->layout == RM_LAYOUT_COLUMN) {
+        result = writeColumns(table, loader->rel->schema, handle, slot, tuple);
+        if (result != RC_OK) {
+            return result;
         }
+    } else {
+        placeTuple(handle, slot, tuple, length, 0);
     }
+    setSlotUsed(getSlotMap(handle), slot, TRUE);
+    header->numFree--;
 
-    // This line will never be reached due to the infinite loop.
-    closeSlotWalk(schema, &handle);
-    return RC_WRITE_FAILED; // Fallback return
+    record->id.page = handle->pageNum;
+    record->id.slot = slot;
+    loadData->numLoaded++;
+    return RC_OK;
 }
 
+RC finishBulkLoad(RM_BulkLoadHandle *loader) {
+    RM_BulkLoadData *loadData = (RM_BulkLoadData *)loader->mgmtData;
+    RM_TableState *table = getTableState(loader->rel);
+    BM_PageHandle *handle = &(loadData->handle);
+    RC result = RC_OK;
+
+    if (handle->pageNum != NO_PAGE) {
+        // Splice the new chain in right after the main page
+        RM_PageHeader *mainHeader = getPageHeader(table->handle);
+        RM_PageHeader *header = getPageHeader(handle);
+        int lastPage = handle->pageNum;
+        int nextPage = mainHeader->nextPage;
+        header->nextPage = nextPage;
+
+        // Only the last page can have room left
+        pushFreeSpacePage(table, handle, loadData->maxStored);
+        markDirty(&bufferPool, handle);
+        result = unpinPage(&bufferPool, handle);
+
+        if (result == RC_OK && nextPage != NO_PAGE) {
+            BM_PageHandle next;
+            result = pinPage(&bufferPool, &next, nextPage);
+            if (result == RC_OK) {
+                getPageHeader(&next)->prevPage = lastPage;
+                markDirty(&bufferPool, &next);
+                result = unpinPage(&bufferPool, &next);
+            }
+        }
+        mainHeader->nextPage = loadData->firstPage;
+        markDirty(&bufferPool, table->handle);
 
+        // The count is raised once for the whole load
+        addPendingTuples(table, loadData->numLoaded);
+    }
 
-#define BEGIN_USE_TABLE_PAGE_HANDLE_HEADER(id) \
-ResourceManagerSchema *table = getSystemSchema(rel); \
-USE_PAGE_HANDLE_HEADER(RC_WRITE_FAILED); \
-if (id.page == table->pageNum) \
-{ \
-    handle = *table->handle; \
-    header = getPageHeader(&handle); \
-} \
-else \
-{ \
-    BEGIN_USE_PAGE_HANDLE_HEADER(id.page) \
+    free(loader->mgmtData);
+    loader->mgmtData = NULL;
+    return result;
 }
 
-#define END_USE_TABLE_PAGE_HANDLE_HEADER() \
-if (id.page != table->pageNum) \
-{ \
-    END_USE_PAGE_HANDLE_HEADER() \
-}
+
 
 typedef enum {
     CHECK_SLOT_RANGE,
@@ -846,178 +2453,513 @@ typedef enum {
 RC deleteRecord(RM_TableData *rel, RID id) {
     BEGIN_USE_TABLE_PAGE_HANDLE_HEADER(id);
 
-    // Check if the slot index is valid
-    if (id.slot >= header->numSlots) {
+    // Check if the slot holds a record
+    if (!isRecordSlot(&handle, id.slot)) {
         END_USE_TABLE_PAGE_HANDLE_HEADER();
-        return RC_WRITE_FAILED; // Invalid slot index
+        return RC_WRITE_FAILED; // Invalid or free slot
     }
 
-    bool *slots = getSlots(&handle);
-    int i = id.slot; // Start with the specific slot we want to delete
+    int maxStored = getMaxStoredSize(rel->schema);
 
-    // Use a do-while loop to check if the slot is available
+    // Use a do-while loop so that a failure can leave the page behind
     do {
-        if (slots[i] == FALSE) {
-            END_USE_TABLE_PAGE_HANDLE_HEADER();
-            return RC_WRITE_FAILED; // Slot is already free
-        }
-        
-        // Mark the slot as free
-        slots[i] = FALSE;
-        table->numTuples--;
-        markSystemCatalogDirty();
-        RC result = markDirty(&bufferPool, &handle);
-        if (result != RC_OK) {
-            END_USE_TABLE_PAGE_HANDLE_HEADER();
-            return RC_WRITE_FAILED; // Failed to mark the page dirty
+        // A forwarded record is removed from the page it moved to first
+        if (isForwarded(&handle, id.slot)) {
+            RID target;
+            BM_PageHandle targetHandle;
+            memcpy(&target, getTupleDataAt(&handle, id.slot), sizeof(RID));
+            result = pinTablePage(table, target.page, &targetHandle);
+            if (result != RC_OK) {
+                break;
+            }
+            freeSlot(table, &targetHandle, target.slot, maxStored);
+            markDirty(&bufferPool, &targetHandle);
+            result = unpinTablePage(table, &targetHandle);
+            if (result != RC_OK) {
+                break;
+            }
         }
 
-        END_USE_TABLE_PAGE_HANDLE_HEADER();
-        return RC_OK; // Successfully deleted the record
-
+        // Free the slot, a page that gets its room back goes on the free-space list
+        freeSlot(table, &handle, id.slot, maxStored);
+        addPendingTuples(table, -1);
+        result = markDirty(&bufferPool, &handle);
     } while (0); // Loop will execute only once
 
-    // If we exit the loop without finding the slot, return an error
-    END_USE_TABLE_PAGE_HANDLE_HEADER();
-    return RC_WRITE_FAILED; // Fallback return
-}
-    // If we exit the loop without finding the slot, return an error
     END_USE_TABLE_PAGE_HANDLE_HEADER();
-    return RC_WRITE_FAILED; // Fallback return
+    return (result == RC_OK) ? RC_OK : RC_WRITE_FAILED;
 }
 
 RC updateRecord(RM_TableData *rel, Record *record) {
     RID id = record->id;
     BEGIN_USE_TABLE_PAGE_HANDLE_HEADER(id);
 
-    // Validate slot range
-    if (id.slot >= header->numSlots) {
+    // Validate the slot
+    if (!isRecordSlot(&handle, id.slot)) {
         END_USE_TABLE_PAGE_HANDLE_HEADER();
-        return RC_WRITE_FAILED; // Invalid slot index
+        return RC_WRITE_FAILED; // Invalid or free slot
     }
 
-    bool *slots = getSlots(&handle);
-    
-    // Use a for loop to check if the slot is available
-    for (int i = 0; i < header->numSlots; i++) {
-        if (i == id.slot) {
-            if (!slots[i]) {
-                END_USE_TABLE_PAGE_HANDLE_HEADER();
-                return RC_WRITE_FAILED; // Slot is not in use
-            }
+    // The tuple is packed behind room for the RID it starts with when it lives on another page
+    int maxStored = getMaxStoredSize(rel->schema);
+    char tuple[PAGE_SIZE];
+    int length = encodeRecord(table, rel->schema, record->data, tuple + sizeof(RID));
+    memcpy(tuple, &id, sizeof(RID));
+
+    // A forwarded record is updated where it lives as long as it still fits there
+    bool forwarded = isForwarded(&handle, id.slot);
+    RID target;
+    BM_PageHandle targetHandle;
+    if (forwarded) {
+        memcpy(&target, getTupleDataAt(&handle, id.slot), sizeof(RID));
+        result = pinTablePage(table, target.page, &targetHandle);
+        if (result != RC_OK) {
+            END_USE_TABLE_PAGE_HANDLE_HEADER();
+            return result;
+        }
 
-            // Update record in the slot
-            int recordSize = getRecordSize(rel->schema);
-            char *tupleData = getTupleDataAt(&handle, recordSize, id.slot);
-            memcpy(tupleData, record->data, recordSize);
+        RM_PageHeader *targetHeader = getPageHeader(&targetHandle);
+        RM_SlotEntry *targetEntry = &(getSlotDirectory(&targetHandle)[target.slot]);
+        if (targetHeader->freeBytes + getStoredSize(targetEntry->length & SLOT_LENGTH_MASK) >= getStoredSize(length + sizeof(RID))) {
+            releaseTuple(&targetHandle, target.slot);
+            placeTuple(&targetHandle, target.slot, tuple, length + sizeof(RID), SLOT_MOVED);
+            pushFreeSpacePage(table, &targetHandle, maxStored);
+            markDirty(&bufferPool, &targetHandle);
+            result = unpinTablePage(table, &targetHandle);
+            END_USE_TABLE_PAGE_HANDLE_HEADER();
+            return result;
+        }
+    }
 
-            // Mark the page as dirty
-            RC result = markDirty(&bufferPool, &handle);
-            if (result != RC_OK) {
-                END_USE_TABLE_PAGE_HANDLE_HEADER();
-                return result; // Failed to mark the page dirty
+    // Update the record in its slot if the page has the room, else forward it to a page
+    // with room and keep its new RID in the slot, so that the record's RID stays the same
+    // (a record always fits its slot on a PAX page, and is written to its segments on a row group page)
+    if (header->layout == RM_LAYOUT_COLUMN) {
+        result = writeColumns(table, rel->schema, &handle, id.slot, tuple + sizeof(RID));
+        if (result != RC_OK) {
+            markDirty(&bufferPool, &handle);
+            END_USE_TABLE_PAGE_HANDLE_HEADER();
+            return result;
+        }
+    } else if (header->layout == RM_LAYOUT_PAX ||
+        header->freeBytes + getStoredSize(getSlotDirectory(&handle)[id.slot].length & SLOT_LENGTH_MASK) >= getStoredSize(length)) {
+        releaseTuple(&handle, id.slot);
+        placeTuple(&handle, id.slot, tuple + sizeof(RID), length, 0);
+    } else {
+        RID moved;
+        result = storeTuple(table, rel->schema, tuple, length + sizeof(RID), SLOT_MOVED, &moved);
+        if (result != RC_OK) {
+            if (forwarded) {
+                unpinTablePage(table, &targetHandle);
             }
+            END_USE_TABLE_PAGE_HANDLE_HEADER();
+            return result;
+        }
+        releaseTuple(&handle, id.slot);
+        placeTuple(&handle, id.slot, (char *)&moved, sizeof(RID), SLOT_FORWARD);
+    }
 
+    // The page the record was forwarded to before no longer holds it
+    if (forwarded) {
+        freeSlot(table, &targetHandle, target.slot, maxStored);
+        markDirty(&bufferPool, &targetHandle);
+        result = unpinTablePage(table, &targetHandle);
+        if (result != RC_OK) {
             END_USE_TABLE_PAGE_HANDLE_HEADER();
-            return RC_OK; // Successfully updated the record
+            return result;
         }
     }
 
-    // If we exit the loop without finding the slot, return an error
+    // Mark the page as dirty
+    pushFreeSpacePage(table, &handle, maxStored);
+    result = markDirty(&bufferPool, &handle);
     END_USE_TABLE_PAGE_HANDLE_HEADER();
-    return RC_WRITE_FAILED; // Fallback return
+    return result;
 }
+
 RC getRecord(RM_TableData *rel, RID id, Record *record) {
     BEGIN_USE_TABLE_PAGE_HANDLE_HEADER(id);
 
-    // Check if the slot index is valid
-    if (id.slot >= header->numSlots) {
+    // Check if the slot index is valid and the slot holds a record
+    if (!isRecordSlot(&handle, id.slot)) {
         END_USE_TABLE_PAGE_HANDLE_HEADER();
-        return RC_WRITE_FAILED; // Invalid slot index
+        return RC_WRITE_FAILED; // Invalid or free slot
     }
 
-    bool *slots = getSlots(&handle);
-    
-    // Use a do-while loop to check if the slot is in use and retrieve data
-    do {
-        // Check if the slot is in use
-        if (!slots[id.slot]) {
-            END_USE_TABLE_PAGE_HANDLE_HEADER();
-            return RC_WRITE_FAILED; // Slot is not in use
+    // Retrieve data
+    result = readTuple(table, rel->schema, &handle, id.slot, record->data);
+    record->id.page = id.page;
+    record->id.slot = id.slot;
+
+    END_USE_TABLE_PAGE_HANDLE_HEADER();
+    return result;
+}
+
+// orders the requests of getRecords by page, then by slot
+int compareRecordRequests(const void *a, const void *b)
+{
+    const RM_RecordRequest *left = (const RM_RecordRequest *)a;
+    const RM_RecordRequest *right = (const RM_RecordRequest *)b;
+    if (left->id.page != right->id.page)
+        return (left->id.page < right->id.page) ? -1 : 1;
+    return (left->id.slot > right->id.slot) - (left->id.slot < right->id.slot);
+}
+
+RC getRecords(RM_TableData *rel, RID *rids, int numRecords, Record **records) {
+    RM_TableState *table = getTableState(rel);
+    RC result = RC_OK;
+
+    if (numRecords <= 0) {
+        return RC_OK;
+    }
+    RM_RecordRequest *requests = (RM_RecordRequest *)malloc(sizeof(RM_RecordRequest) * numRecords);
+    if (requests == NULL) {
+        return RC_ALLOCATION_FAILED;
+    }
+
+    // Group the requests by page so that each page is pinned once
+    for (int i = 0; i < numRecords; i++) {
+        requests[i].id = rids[i];
+        requests[i].index = i;
+    }
+    qsort(requests, numRecords, sizeof(RM_RecordRequest), compareRecordRequests);
+
+    int i = 0;
+    while (i < numRecords) {
+        int pageNum = requests[i].id.page;
+        BM_PageHandle handle;
+
+        // The main page stays pinned while the table is open
+        if (pageNum == table->entry->pageNum) {
+            handle = *table->handle;
+        } else {
+            if (pinPage(&bufferPool, &handle, pageNum) != RC_OK) {
+                // None of the records on this page can be read
+                result = RC_WRITE_FAILED;
+                while (i < numRecords && requests[i].id.page == pageNum) {
+                    i++;
+                }
+                continue;
+            }
         }
 
-        // Retrieve data
-        int recordSize = getRecordSize(rel->schema);
-        char *tupleData = getTupleDataAt(&handle, recordSize, id.slot);
-        memcpy(record->data, tupleData, recordSize);
-        record->id.page = id.page;
-        record->id.slot = id.slot;
+        // Copy out every requested record of the page, a missing one fails the call
+        // but does not stop the others from being read
+        for (; i < numRecords && requests[i].id.page == pageNum; i++) {
+            RID id = requests[i].id;
+            Record *record = records[requests[i].index];
+            if (!isRecordSlot(&handle, id.slot) || readTuple(table, rel->schema, &handle, id.slot, record->data) != RC_OK) {
+                result = RC_WRITE_FAILED;
+                continue;
+            }
+            record->id = id;
+        }
 
-        // Exit the loop after successful retrieval
-        break; // Break out of the loop since we successfully retrieved the record
+        if (pageNum != table->entry->pageNum && unpinPage(&bufferPool, &handle) != RC_OK) {
+            result = RC_WRITE_FAILED;
+        }
+    }
 
-    } while (0); // The loop will only execute once
+    free(requests);
+    return result;
+}
 
-    END_USE_TABLE_PAGE_HANDLE_HEADER();
-    return RC_OK; // Successfully retrieved the record
+RC borrowRecord(RM_TableData *rel, RID id, Record *record) {
+    RM_TableState *table = getTableState(rel);
+    BM_PageHandle handle;
+    RC result;
+
+    // Tuples with strings are packed on their page and PAX pages split records into columns,
+    // such a record is lent as an unpacked copy
+    if (!isStoredInPlace(table, rel->schema)) {
+        record->data = (char *)malloc(getRecordSize(rel->schema));
+        if (record->data == NULL) {
+            return RC_ALLOCATION_FAILED;
+        }
+        result = getRecord(rel, id, record);
+        if (result != RC_OK) {
+            free(record->data);
+            record->data = NULL;
+        }
+        return result;
+    }
+
+    // The main page stays pinned while the table is open, any other page is pinned for the borrower
+    result = pinTablePage(table, id.page, &handle);
+    if (result != RC_OK) {
+        return result;
+    }
+    if (!isRecordSlot(&handle, id.slot)) {
+        unpinTablePage(table, &handle);
+        return RC_WRITE_FAILED; // Slot is not in use
+    }
+
+    // Hand out the tuple where it lies in the frame instead of copying it
+    // (a tuple without strings never outgrows its slot, so it is never forwarded)
+    record->id = id;
+    record->data = getTupleDataAt(&handle, id.slot);
+    table->numBorrows++;
+    return RC_OK;
+}
+
+RC releaseRecord(RM_TableData *rel, Record *record) {
+    RM_TableState *table = getTableState(rel);
+    RC result = RC_OK;
+
+    // Undo what borrowRecord did: free the copy, or let go of the page the record lies in
+    // (the table's layout and schema decide which one it was lent as)
+    if (!isStoredInPlace(table, rel->schema)) {
+        free(record->data);
+    } else {
+        BM_PageHandle handle;
+        handle.pageNum = record->id.page;
+        handle.data = NULL;
+        result = unpinTablePage(table, &handle);
+
+        // the pages emptied while records were lent can be given back now
+        table->numBorrows--;
+        if (result == RC_OK && table->numBorrows == 0 && table->numScans == 0 && table->numEmptyPages > 0)
+            result = vacuumTable(rel);
+    }
+    record->data = NULL;
+    return result;
 }
 
 /* Scans */
 
 RC startScan (RM_TableData *rel, RM_ScanHandle *scan, Expr *cond)
 {
-    ResourceManagerSchema *table = getSystemSchema(rel);
-    BM_PageHandle *handle = table->handle;
+    RM_TableState *table = getTableState(rel);
     scan->rel = rel;
     scan->mgmtData = malloc(sizeof(RM_ScanData));
     RM_ScanData *scanData = (RM_ScanData *)scan->mgmtData;
+    scanData->handle = *(table->handle);
     scanData->id.slot = -1;
-    scanData->id.page = handle->pageNum;
+    scanData->id.page = scanData->handle.pageNum;
     scanData->cond = cond;
+    scanData->tuple = isStoredInPlace(table, rel->schema) ? NULL : (char *)calloc(1, getRecordSize(rel->schema));
+    scanData->condAttrs = getExprAttrs(cond);
+    scanData->projAttrs = ~0;
+    for (int i = 0; i < MAX_NUM_ATTR; i++)
+        scanData->segments[i].pageNum = NO_PAGE;
+    scanData->segmentEnd = 0;
+    table->numScans++;
     return RC_OK;
 }
 
-RC next (RM_ScanHandle *scan, Record *record)
+RC startProjectedScan (RM_TableData *rel, RM_ScanHandle *scan, Expr *cond, int numAttrs, int *attrNums)
 {
+    RC result = startScan(rel, scan, cond);
+    if (result != RC_OK)
+        return result;
+
+    // PAX and column pages only copy out the wanted attributes and the condition's
     RM_ScanData *scanData = (RM_ScanData *)scan->mgmtData;
-    RM_TableData *rel = scan->rel;
-    ResourceManagerSchema *table = getSystemSchema(rel);
-    BM_PageHandle *handle = table->handle;
-    RM_PageHeader *header = getPageHeader(handle);
-    bool *slots = getSlots(handle);
+    scanData->projAttrs = 0;
+    for (int i = 0; i < numAttrs; i++)
+        scanData->projAttrs |= 1 << attrNums[i];
+    return RC_OK;
+}
+
+// moves the scan to the next record that satisfies its condition and points match at it,
+// in the page the scan holds or unpacked into the scan's buffer when the table has strings
+// or is PAX or columnar (those give the condition only its own columns, the rest once it matches),
+// following the page chain from the main page and pinning each page once
+// returns RC_RM_NO_MORE_TUPLES when the last page is done
+RC findNextMatch(RM_ScanHandle *scan, Record *match)
+{
+    RM_ScanData *scanData = (RM_ScanData *)scan->mgmtData;
+    RM_TableState *table = getTableState(scan->rel);
+    RC result;
 
-    while (scanData->id.slot < header->numSlots - 1)
+    while (true)
     {
-        scanData->id.slot++;
-        if (slots[scanData->id.slot])
+        BM_PageHandle *handle = &(scanData->handle);
+        RM_PageHeader *header = getPageHeader(handle);
+        uint64_t *slots = getSlotMap(handle);
+        RM_SlotEntry *directory = getSlotDirectory(handle);
+
+        // jump from one used slot to the next
+        int slot;
+        while ((slot = findUsedSlot(slots, header->numSlots, scanData->id.slot + 1)) != -1)
         {
-            RC result = getRecord(rel, scanData->id, record);
-            if (result != RC_OK) 
-                return result;
+            scanData->id.slot = slot;
+
+            if (header->layout != RM_LAYOUT_ROW)
+            {
+                // a row group page skips the rows whose segments rule the condition out,
+                // a run of rows sharing the segments of the condition's columns at a time
+                if (header->layout == RM_LAYOUT_COLUMN && scanData->cond != NULL)
+                {
+                    if (slot >= scanData->segmentEnd)
+                    {
+                        scanData->segmentEnd = header->numSlots;
+                        for (int i = 0; i < header->numColumns; i++)
+                        {
+                            int valuesPerPage = PAGE_SIZE / header->columnSizes[i];
+                            int end = (slot / valuesPerPage + 1) * valuesPerPage;
+                            if ((scanData->condAttrs & (1 << i)) && end < scanData->segmentEnd)
+                                scanData->segmentEnd = end;
+                        }
+                        scanData->segmentMatches = segmentMayMatch(scanData->cond, scan->rel->schema, handle, slot, FALSE);
+                    }
+                    if (!scanData->segmentMatches)
+                    {
+                        scanData->id.slot = scanData->segmentEnd - 1;
+                        continue;
+                    }
+                }
+
+                match->id = scanData->id;
+                match->data = scanData->tuple;
+                if (scanData->cond == NULL)
+                    return copyScanColumns(scan, slot, scanData->projAttrs);
+                result = copyScanColumns(scan, slot, scanData->condAttrs);
+                if (result != RC_OK)
+                    return result;
+
+                Value *value;
+                result = evalExpr(match, scan->rel->schema, scanData->cond, &value);
+                if (result != RC_OK)
+                    return result;
+
+                bool matches = value->v.boolV;
+                freeVal(value);
+                if (matches)
+                    return copyScanColumns(scan, slot, scanData->projAttrs & ~scanData->condAttrs);
+                continue;
+            }
+
+            // a forwarded record is met on the page it moved to, under the RID of its slot here
+            if (directory[slot].length & SLOT_FORWARD)
+                continue;
+            char *tuple = handle->data + directory[slot].offset;
+            match->id = scanData->id;
+            if (directory[slot].length & SLOT_MOVED)
+            {
+                memcpy(&(match->id), tuple, sizeof(RID));
+                tuple += sizeof(RID);
+            }
+            if (scanData->tuple != NULL)
+            {
+                unpackTuple(scan->rel->schema, tuple, scanData->tuple);
+                tuple = scanData->tuple;
+            }
+            match->data = tuple;
 
-            if (scanData->cond == NULL) 
+            if (scanData->cond == NULL)
                 return RC_OK;
 
             Value *value;
-            result = evalExpr(record, scan->rel->schema, scanData->cond, &value);
-            if (result != RC_OK) 
+            result = evalExpr(match, scan->rel->schema, scanData->cond, &value);
+            if (result != RC_OK)
                 return result;
 
-            if (value->v.boolV)
-            {
-                freeVal(value);
+            bool matches = value->v.boolV;
+            freeVal(value);
+            if (matches)
                 return RC_OK;
+        }
+        scanData->id.slot = header->numSlots;
+
+        if (header->nextPage == NO_PAGE)
+            return RC_RM_NO_MORE_TUPLES;
+
+        // pin the next page of the chain before letting go of the current one
+        BM_PageHandle next;
+        result = pinNextPage(&bufferPool, &next, handle, header->nextPage);
+        if (result != RC_OK)
+            return result;
+        if (handle->pageNum != table->entry->pageNum)
+        {
+            result = unpinPage(&bufferPool, handle);
+            if (result != RC_OK)
+            {
+                unpinPage(&bufferPool, &next);
+                return result;
             }
-            freeVal(value);
         }
+        scanData->handle = next;
+        scanData->id.page = next.pageNum;
+        scanData->id.slot = -1;
+        scanData->segmentEnd = 0;
+    }
+}
+
+// helper to copy the attributes in attrs of a slot of the PAX or row group page a scan holds
+// into the scan's buffer
+RC copyScanColumns(RM_ScanHandle *scan, int slot, int attrs)
+{
+    RM_ScanData *scanData = (RM_ScanData *)scan->mgmtData;
+    if (getPageHeader(&(scanData->handle))->layout == RM_LAYOUT_PAX)
+    {
+        gatherColumns(&(scanData->handle), slot, attrs, scanData->tuple);
+        return RC_OK;
     }
-    return RC_RM_NO_MORE_TUPLES;
+    return readColumns(getTableState(scan->rel), &(scanData->handle), slot, attrs, scanData->segments, scanData->tuple);
+}
+
+RC next (RM_ScanHandle *scan, Record *record)
+{
+    Record match;
+    RC result = findNextMatch(scan, &match);
+    if (result != RC_OK)
+        return result;
+
+    // only a matching record is copied out
+    memcpy(record->data, match.data, getRecordSize(scan->rel->schema));
+    record->id = match.id;
+    return RC_OK;
+}
+
+RC nextBorrowed (RM_ScanHandle *scan, Record *record)
+{
+    return findNextMatch(scan, record);
+}
+
+RC nextBatch (RM_ScanHandle *scan, Record **records, int maxRecords, int *numRecords)
+{
+    RC result = RC_OK;
+    *numRecords = 0;
+
+    // fill the batch until it is full or the scan is done
+    while (*numRecords < maxRecords)
+    {
+        result = next(scan, records[*numRecords]);
+        if (result != RC_OK)
+            break;
+        (*numRecords)++;
+    }
+
+    // the end of the table is only reported once no record is left for the batch
+    if (result == RC_RM_NO_MORE_TUPLES && *numRecords > 0)
+        return RC_OK;
+    return result;
 }
 
 RC closeScan (RM_ScanHandle *scan)
 {
+    RM_ScanData *scanData = (RM_ScanData *)scan->mgmtData;
+    RM_TableState *table = getTableState(scan->rel);
+    RC result = RC_OK;
+
+    // the main page stays pinned with the table, any other page is the scan's own
+    if (scanData->handle.pageNum != table->entry->pageNum)
+        result = unpinPage(&bufferPool, &(scanData->handle));
+    for (int i = 0; i < MAX_NUM_ATTR; i++)
+    {
+        if (scanData->segments[i].pageNum != NO_PAGE && unpinPage(&bufferPool, &(scanData->segments[i])) != RC_OK)
+            result = RC_WRITE_FAILED;
+    }
+    free(scanData->tuple);
     free(scan->mgmtData);
-    return RC_OK;
+    scan->mgmtData = NULL;
+
+    // the pages emptied while scans were open can be given back now
+    table->numScans--;
+    if (result == RC_OK && table->numScans == 0 && table->numBorrows == 0 && table->numEmptyPages > 0)
+        result = vacuumTable(scan->rel);
+    return result;
 }
 
 /* Dealing with schemas */
@@ -1045,20 +2987,41 @@ int getAttrSize(Schema *schema, int attrIndex)
 }
 
 
-int getRecordSize (Schema *schema)
+// the offset of every attribute in a record, computed once per schema, with the record size after the last one
+int *computeAttrOffsets(Schema *schema)
 {
-    int size = 0;
+    int *offsets = (int *)malloc(sizeof(int) * (schema->numAttr + 1));
+    if (offsets == NULL)
+        return NULL;
+
+    offsets[0] = 0;
     for (int attrIndex = 0; attrIndex < schema->numAttr; attrIndex++)
     {
-        size += getAttrSize(schema, attrIndex);
+        offsets[attrIndex + 1] = offsets[attrIndex] + getAttrSize(schema, attrIndex);
     }
-    return size;
+    return offsets;
 }
 
-Schema *createSchema (int numAttr, char **attrNames, DataType *dataTypes, int *typeLength, int keySize, int *keys)
+int getAttrOffset (Schema *schema, int attrNum)
+{
+    // a Schema not made by createSchema or openTable has no offsets, they are added up instead
+    if (schema->attrOffsets == NULL)
+    {
+        int offset = 0;
+        for (int attrIndex = 0; attrIndex < attrNum; attrIndex++)
+            offset += getAttrSize(schema, attrIndex);
+        return offset;
+    }
+    return schema->attrOffsets[attrNum];
+}
+
+int getRecordSize (Schema *schema)
+{
+    return getAttrOffset(schema, schema->numAttr);
+}
+
+RC initSchema (Schema *schema, int numAttr, char **attrNames, DataType *dataTypes, int *typeLength, int keySize, int *keys)
 {
-    Schema *schema = (Schema *)malloc(sizeof(Schema));
-    
     // create attributes
     schema->numAttr = numAttr;
     schema->attrNames = attrNames;
@@ -1068,11 +3031,37 @@ Schema *createSchema (int numAttr, char **attrNames, DataType *dataTypes, int *t
     // create keys
     schema->keyAttrs = keys;
     schema->keySize = keySize;
+
+    schema->attrOffsets = computeAttrOffsets(schema);
+    if (schema->attrOffsets == NULL)
+        return RC_ALLOCATION_FAILED;
+    return RC_OK;
+}
+
+RC clearSchema (Schema *schema)
+{
+    free((void *)schema->attrOffsets);
+    schema->attrOffsets = NULL;
+    return RC_OK;
+}
+
+Schema *createSchema (int numAttr, char **attrNames, DataType *dataTypes, int *typeLength, int keySize, int *keys)
+{
+    Schema *schema = (Schema *)malloc(sizeof(Schema));
+    if (schema == NULL)
+        return NULL;
+
+    if (initSchema(schema, numAttr, attrNames, dataTypes, typeLength, keySize, keys) != RC_OK)
+    {
+        free(schema);
+        return NULL;
+    }
     return schema;
 }
 
 RC freeSchema (Schema *schema)
 {
+    clearSchema(schema);
     free((void *)schema);
     return RC_OK;
 }
@@ -1095,39 +3084,83 @@ RC freeRecord (Record *record)
     return RC_OK;
 }
 
-RC getRecord(RM_TableData *rel, RID id, Record *record) {
-    BEGIN_USE_TABLE_PAGE_HANDLE_HEADER(id);
+RC getAttr (Record *record, Schema *schema, int attrNum, Value **value)
+{
+    if (attrNum >= schema->numAttr) 
+        return RC_WRITE_FAILED;
 
-    // Check if the slot index is valid
-    if (id.slot >= header->numSlots) {
-        END_USE_TABLE_PAGE_HANDLE_HEADER();
-        return RC_WRITE_FAILED; // Invalid slot index
+    char *dataPtr = record->data + getAttrOffset(schema, attrNum);
+    int attrSize = getAttrSize(schema, attrNum);
+    *value = (Value *)malloc(sizeof(Value));
+    Value *valuePtr = *value;
+    valuePtr->dt = schema->dataTypes[attrNum];
+
+    switch (valuePtr->dt)
+    {
+        case DT_INT:
+            memcpy(&(valuePtr->v.intV), dataPtr, sizeof(int));
+            break;
+        case DT_STRING:
+            valuePtr->v.stringV = malloc(attrSize);
+            memcpy(valuePtr->v.stringV, dataPtr, attrSize);
+            break;
+        case DT_FLOAT:
+            memcpy(&(valuePtr->v.floatV), dataPtr, sizeof(float));
+            break;
+        default:
+            memcpy(&(valuePtr->v.boolV), dataPtr, sizeof(bool));
+            break;
     }
+    return RC_OK;
+}
 
-    bool *slots = getSlots(&handle);
-    
-    // Use a do-while loop to check if the slot is in use and retrieve data
-    do {
-        // Check if the slot is in use
-        if (!slots[id.slot]) {
-            END_USE_TABLE_PAGE_HANDLE_HEADER();
-            return RC_WRITE_FAILED; // Slot is not in use
-        }
+// typed accessors, they read and write the record's bytes in place without allocating
+// (attrNum must be an attribute of that type)
+int getAttrInt (Record *record, Schema *schema, int attrNum)
+{
+    int value;
+    memcpy(&value, record->data + getAttrOffset(schema, attrNum), sizeof(int));
+    return value;
+}
+
+float getAttrFloat (Record *record, Schema *schema, int attrNum)
+{
+    float value;
+    memcpy(&value, record->data + getAttrOffset(schema, attrNum), sizeof(float));
+    return value;
+}
+
+bool getAttrBool (Record *record, Schema *schema, int attrNum)
+{
+    bool value;
+    memcpy(&value, record->data + getAttrOffset(schema, attrNum), sizeof(bool));
+    return value;
+}
 
-        // Retrieve data
-        int recordSize = getRecordSize(rel->schema);
-        char *tupleData = getTupleDataAt(&handle, recordSize, id.slot);
-        memcpy(record->data, tupleData, recordSize);
-        record->id.page = id.page;
-        record->id.slot = id.slot;
+const char *getAttrStringRef (Record *record, Schema *schema, int attrNum)
+{
+    return record->data + getAttrOffset(schema, attrNum);
+}
 
-        // Exit the loop after successful retrieval
-        break; // Break out of the loop since we successfully retrieved the record
+void setAttrInt (Record *record, Schema *schema, int attrNum, int value)
+{
+    memcpy(record->data + getAttrOffset(schema, attrNum), &value, sizeof(int));
+}
 
-    } while (0); // The loop will only execute once
+void setAttrFloat (Record *record, Schema *schema, int attrNum, float value)
+{
+    memcpy(record->data + getAttrOffset(schema, attrNum), &value, sizeof(float));
+}
 
-    END_USE_TABLE_PAGE_HANDLE_HEADER();
-    return RC_OK; // Successfully retrieved the record
+void setAttrBool (Record *record, Schema *schema, int attrNum, bool value)
+{
+    memcpy(record->data + getAttrOffset(schema, attrNum), &value, sizeof(bool));
+}
+
+void setAttrString (Record *record, Schema *schema, int attrNum, const char *value)
+{
+    // pad with zeros so that the packed tuple keeps only the string itself
+    strncpy(record->data + getAttrOffset(schema, attrNum), value, getAttrSize(schema, attrNum));
 }
 
 RC setAttr(Record *record, Schema *schema, int attrNum, Value *value)
@@ -1135,14 +3168,7 @@ RC setAttr(Record *record, Schema *schema, int attrNum, Value *value)
     if (attrNum >= schema->numAttr) 
         return RC_WRITE_FAILED;
 
-    char *dataPtr = record->data;
-    int attrIndex = 0;
-    while (attrIndex < attrNum)
-    {
-        dataPtr += getAttrSize(schema, attrIndex);
-        attrIndex++;
-    }
-
+    char *dataPtr = record->data + getAttrOffset(schema, attrNum);
     int attrSize = getAttrSize(schema, attrNum);
 
     if (value->dt == DT_INT)
@@ -1151,7 +3177,8 @@ RC setAttr(Record *record, Schema *schema, int attrNum, Value *value)
     }
     else if (value->dt == DT_STRING)
     {
-        memcpy(dataPtr, value->v.stringV, attrSize);
+        // pad with zeros so that the packed tuple keeps only the string itself
+        strncpy(dataPtr, value->v.stringV, attrSize);
     }
     else if (value->dt == DT_FLOAT)
     {
@@ -12,14 +12,37 @@ typedef struct RM_ScanHandle
 	void *mgmtData;
 } RM_ScanHandle;
 
+// Bookkeeping for bulk loads
+typedef struct RM_BulkLoadHandle
+{
+	RM_TableData *rel;
+	void *mgmtData;
+} RM_BulkLoadHandle;
+
+// How a table lays out the records on its pages: whole records (ROW), within each page
+// one array per attribute (PAX) so that a scan condition only touches the columns it reads,
+// or every attribute on pages of its own (COLUMN) so that a scan only reads the columns it uses
+typedef enum RM_TableLayout
+{
+	RM_LAYOUT_ROW = 0,
+	RM_LAYOUT_PAX = 1,
+	RM_LAYOUT_COLUMN = 2
+} RM_TableLayout;
+
 // table and manager
 extern RC initRecordManager (void *mgmtData);
 extern RC shutdownRecordManager ();
+// writes the tuple counts of the open tables (kept in memory between checkpoints) to the catalog
+extern RC checkpointRecordManager ();
 extern RC createTable (char *name, Schema *schema);
+extern RC createTableWithLayout (char *name, Schema *schema, RM_TableLayout layout);
 extern RC openTable (RM_TableData *rel, char *name);
 extern RC closeTable (RM_TableData *rel);
 extern RC deleteTable (char *name);
+// gives the empty overflow pages of a table back to the free list (fails while a scan is open)
+extern RC vacuumTable (RM_TableData *rel);
 extern int getNumTuples (RM_TableData *rel);
+extern RC setTableBufferQuota (RM_TableData *rel, int reservedFrames, int maxFrames, int priority);
 
 // manager stats
 extern int getNumPages ();
@@ -31,15 +54,41 @@ extern RC insertRecord (RM_TableData *rel, Record *record);
 extern RC deleteRecord (RM_TableData *rel, RID id);
 extern RC updateRecord (RM_TableData *rel, Record *record);
 extern RC getRecord (RM_TableData *rel, RID id, Record *record);
+extern RC insertRecords (RM_TableData *rel, Record **records, int numRecords, RID *rids);
+extern RC getRecords (RM_TableData *rel, RID *rids, int numRecords, Record **records);
+// zero-copy access: record->data is pointed at the tuple in its pinned page and must only
+// be read until releaseRecord (record must not come from createRecord, its data is replaced,
+// and its id must be left as borrowRecord set it)
+extern RC borrowRecord (RM_TableData *rel, RID id, Record *record);
+extern RC releaseRecord (RM_TableData *rel, Record *record);
+
+// bulk loads (finishBulkLoad must be called even if loadRecord failed)
+extern RC startBulkLoad (RM_TableData *rel, RM_BulkLoadHandle *loader);
+extern RC loadRecord (RM_BulkLoadHandle *loader, Record *record);
+extern RC finishBulkLoad (RM_BulkLoadHandle *loader);
 
 // scans
 extern RC startScan (RM_TableData *rel, RM_ScanHandle *scan, Expr *cond);
+// like startScan, but the records only have to hold the attributes in attrNums (and the ones the
+// condition reads), PAX and column tables leave the others zeroed
+extern RC startProjectedScan (RM_TableData *rel, RM_ScanHandle *scan, Expr *cond, int numAttrs, int *attrNums);
 extern RC next (RM_ScanHandle *scan, Record *record);
+// copies up to maxRecords matching records into records, numRecords is set to how many
+extern RC nextBatch (RM_ScanHandle *scan, Record **records, int maxRecords, int *numRecords);
+// like next, but record->data points into the page held by the scan instead of being filled,
+// it is read only and stays valid until the next call on the scan or closeScan
+extern RC nextBorrowed (RM_ScanHandle *scan, Record *record);
 extern RC closeScan (RM_ScanHandle *scan);
 
 // dealing with schemas
 extern int getRecordSize (Schema *schema);
+// byte offset of an attribute in a record (attrNum = numAttr gives the record size)
+extern int getAttrOffset (Schema *schema, int attrNum);
 extern Schema *createSchema (int numAttr, char **attrNames, DataType *dataTypes, int *typeLength, int keySize, int *keys);
+// like createSchema for a Schema the caller owns (the arrays are referenced, not copied),
+// clearSchema frees what initSchema set up but not the Schema itself
+extern RC initSchema (Schema *schema, int numAttr, char **attrNames, DataType *dataTypes, int *typeLength, int keySize, int *keys);
+extern RC clearSchema (Schema *schema);
 extern RC freeSchema (Schema *schema);
 
 // dealing with records and attribute values
@@ -47,5 +96,14 @@ extern RC createRecord (Record **record, Schema *schema);
 extern RC freeRecord (Record *record);
 extern RC getAttr (Record *record, Schema *schema, int attrNum, Value **value);
 extern RC setAttr (Record *record, Schema *schema, int attrNum, Value *value);
+// typed access to the record's bytes in place, nothing is allocated (attrNum must have the type)
+extern int getAttrInt (Record *record, Schema *schema, int attrNum);
+extern float getAttrFloat (Record *record, Schema *schema, int attrNum);
+extern bool getAttrBool (Record *record, Schema *schema, int attrNum);
+extern const char *getAttrStringRef (Record *record, Schema *schema, int attrNum);
+extern void setAttrInt (Record *record, Schema *schema, int attrNum, int value);
+extern void setAttrFloat (Record *record, Schema *schema, int attrNum, float value);
+extern void setAttrBool (Record *record, Schema *schema, int attrNum, bool value);
+extern void setAttrString (Record *record, Schema *schema, int attrNum, const char *value);
 
 #endif // RECORD_MGR_H
@@ -0,0 +1,92 @@
+#include "policy_sim.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+// replays a trace recorded with startTrace against every replacement strategy and
+// pool size in memory (policy_sim), and reports the hits, misses and write-backs each
+// combination would see
+//
+// usage: simulate_trace.o <trace file> [max frames] [min frames]
+
+#define DEFAULT_MAX_FRAMES 16
+
+static const ReplacementStrategy strategies[] = { RS_FIFO, RS_LRU, RS_CLOCK, RS_LFU, RS_LRU_K };
+static const char *strategyNames[] = { "FIFO", "LRU", "CLOCK", "LFU", "LRU-K" };
+
+// load the whole trace into memory
+// returns the number of records, or -1 if the file cannot be read
+static long readTrace(const char *fileName, BM_TraceRecord **records)
+{
+    FILE *file = fopen(fileName, "rb");
+    if (file == NULL)
+        return -1;
+
+    long capacity = 1024, count = 0;
+    *records = (BM_TraceRecord *)malloc(sizeof(BM_TraceRecord) * capacity);
+    while (*records != NULL && fread(&(*records)[count], sizeof(BM_TraceRecord), 1, file) == 1)
+    {
+        if (++count == capacity)
+        {
+            capacity *= 2;
+            BM_TraceRecord *grown = (BM_TraceRecord *)realloc(*records, sizeof(BM_TraceRecord) * capacity);
+            if (grown == NULL)
+            {
+                free(*records);
+                *records = NULL;
+            }
+            else *records = grown;
+        }
+    }
+    fclose(file);
+    return (*records == NULL) ? -1 : count;
+}
+
+int main(int argc, char *argv[])
+{
+    BM_TraceRecord *records;
+    PS_Result result;
+    long count;
+    int maxFrames = DEFAULT_MAX_FRAMES;
+    int minFrames = 1;
+
+    if (argc < 2)
+    {
+        fprintf(stderr, "usage: %s <trace file> [max frames] [min frames]\n", argv[0]);
+        return 1;
+    }
+    if (argc > 2)
+        maxFrames = atoi(argv[2]);
+    if (argc > 3)
+        minFrames = atoi(argv[3]);
+    if (minFrames < 1 || maxFrames < minFrames)
+    {
+        fprintf(stderr, "invalid pool size range %d..%d\n", minFrames, maxFrames);
+        return 1;
+    }
+
+    count = readTrace(argv[1], &records);
+    if (count < 0)
+    {
+        fprintf(stderr, "cannot read trace %s\n", argv[1]);
+        return 1;
+    }
+
+    printf("%-8s %8s %10s %10s %10s %10s %8s\n", "strategy", "frames", "pins", "hits", "misses", "writes", "failed");
+    for (int s = 0; s < (int)(sizeof(strategies) / sizeof(strategies[0])); s++)
+    {
+        for (int numFrames = minFrames; numFrames <= maxFrames; numFrames++)
+        {
+            if (simulatePolicy(records, count, strategies[s], numFrames, &result) != 0)
+            {
+                fprintf(stderr, "out of memory\n");
+                free(records);
+                return 1;
+            }
+            printf("%-8s %8d %10ld %10ld %10ld %10ld %8ld\n", strategyNames[s], numFrames,
+                   result.pins, result.hits, result.misses, result.writeBacks, result.failed);
+        }
+    }
+
+    free(records);
+    return 0;
+}
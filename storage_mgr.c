@@ -17,17 +17,17 @@ typedef enum {
 
 RC createPageFile(char *fileName) {
     FILE *fp = fopen(fileName, "w+");
-    FileOperationStatus status;
+    FileOperationStatus status = SUCCESS;
 
     if (fp == NULL) {
-        return NULL_POINTER; // Handle file opening failure
+        return RC_FILE_NOT_FOUND; // Handle file opening failure
     }
 
     // Allocate memory for an empty page
     void *emptyPage = malloc(PAGE_SIZE); 
     if (emptyPage == NULL) {
         fclose(fp);
-        return 0;  // Handle memory allocation failure
+        return RC_WRITE_FAILED;  // Handle memory allocation failure
     }
 
     // Initialize the empty page
@@ -48,14 +48,7 @@ RC createPageFile(char *fileName) {
     fclose(fp);
     free(emptyPage);
 
-    // Check the status after the loop
-    if (status == WRITE_ERROR) {
-        return WRITE_ERROR; // Return write error status
-    }
-
-    return SUCCESS; // Return success if everything went well
-}
-
+    // Map the status after the loop to a return code
     switch (status) {
         case NULL_POINTER:
             return RC_FILE_NOT_FOUND;
@@ -233,6 +226,31 @@ RC readBlock(int pageNum, SM_FileHandle *fHandle, SM_PageHandle memPage) {
     return RC_OK;  // Successfully read the entire page
 }
 
+RC readBlocks(int startPage, int numPages, SM_FileHandle *fHandle, SM_PageHandle *memPages) {
+    if (fHandle == NULL || fHandle->mgmtInfo == NULL) {
+        return RC_FILE_NOT_FOUND;  // Check for valid file handle and file pointer
+    }
+
+    if (startPage < 0 || numPages < 0 || startPage + numPages > fHandle->totalNumPages) {
+        return RC_READ_NON_EXISTING_PAGE;  // Run does not lie within the file
+    }
+
+    FILE *fp = (FILE *)fHandle->mgmtInfo;
+    if (fseek(fp, (long)startPage * PAGE_SIZE, SEEK_SET) != 0) {
+        return RC_SEEK_FAILED;
+    }
+
+    // The pages are adjacent on disk, so every read continues where the last one ended
+    for (int i = 0; i < numPages; i++) {
+        size_t bytesRead = fread(memPages[i], sizeof(char), PAGE_SIZE, fp);
+        if (bytesRead < PAGE_SIZE) {
+            return feof(fp) ? RC_READ_NON_EXISTING_PAGE : RC_READ_FAILED;
+        }
+    }
+
+    return RC_OK;
+}
+
 int getBlockPos (SM_FileHandle *fHandle)
 {
     return fHandle->curPagePos;
@@ -346,6 +364,42 @@ RC writeCurrentBlock (SM_FileHandle *fHandle, SM_PageHandle memPage)
     return writeBlock(fHandle->curPagePos, fHandle, memPage);
 }
 
+/**
+ * Writes a run of consecutive pages with a single seek and flush.
+ *
+ * @param startPage The first page of the run.
+ * @param numPages The number of pages in the run.
+ * @param fHandle Pointer to the file handle structure.
+ * @param memPages One page buffer for each page of the run, in page order.
+ * @return Result code indicating success or failure.
+ */
+RC writeBlocks(int startPage, int numPages, SM_FileHandle *fHandle, SM_PageHandle *memPages) {
+    if (fHandle == NULL || fHandle->mgmtInfo == NULL) {
+        return RC_FILE_NOT_FOUND;  // Check for valid file handle and file pointer
+    }
+
+    if (startPage < 0 || numPages < 0 || startPage + numPages > fHandle->totalNumPages) {
+        return RC_PAGE_OUT_OF_RANGE;  // Run does not lie within the file
+    }
+
+    FILE *fp = (FILE *)fHandle->mgmtInfo;
+    if (fseek(fp, (long)startPage * PAGE_SIZE, SEEK_SET) != 0) {
+        return RC_SEEK_FAILED;
+    }
+
+    // The pages are adjacent on disk, so every write continues where the last one ended
+    for (int i = 0; i < numPages; i++) {
+        size_t bytesWritten = fwrite(memPages[i], sizeof(char), PAGE_SIZE, fp);
+        if (bytesWritten != PAGE_SIZE) {
+            fflush(fp);  // Flush whatever part of the run made it out
+            return RC_WRITE_FAILED;
+        }
+    }
+
+    fflush(fp);  // One flush for the whole run
+    return RC_OK;
+}
+
 
 RC appendEmptyBlock(SM_FileHandle *fHandle) {
     if (fHandle == NULL || fHandle->mgmtInfo == NULL) {
@@ -381,6 +435,12 @@ RC ensureCapacity(int numberOfPages, SM_FileHandle *fHandle) {
         return RC_FILE_NOT_FOUND;  // Check for valid file handle and file pointer
     }
 
+    // Another handle on the file (e.g. of another process) may have grown it since
+    long fileSize = _getFileSize((FILE *)fHandle->mgmtInfo);
+    if (fileSize != -1 && fileSize / PAGE_SIZE > fHandle->totalNumPages) {
+        fHandle->totalNumPages = fileSize / PAGE_SIZE;
+    }
+
     while (fHandle->totalNumPages < numberOfPages) {
         RC result = appendEmptyBlock(fHandle);
         if (result != RC_OK) {
@@ -41,6 +41,9 @@ typedef struct Schema
 	int *typeLength;
 	int *keyAttrs;
 	int keySize;
+	// byte offset of every attribute in a record and the record size after them, set up by
+	// createSchema, initSchema and openTable (a Schema filled in field by field leaves it NULL)
+	int *attrOffsets;
 } Schema;
 
 // TableData: Management Structure for a Record Manager to handle one relation
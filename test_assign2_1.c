@@ -0,0 +1,1161 @@
+#include "storage_mgr.h"
+#include "buffer_mgr_stat.h"
+#include "buffer_mgr.h"
+#include "dberror.h"
+#include "policy_sim.h"
+#include "test_helper.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+
+#define PAGE_FILE_NAME "testbuffer.bin"
+#define TRACE_FILE_NAME "testbuffer.trace"
+#define SEGMENT_NAME "/testbuffer.pool"
+
+// test name
+char *testName;
+
+// test methods
+static void testFlushInPageOrder (void);
+static void testVictimSearch (void);
+static void testRandomWorkload (void);
+static void testVictimCache (void);
+static void testPageClasses (void);
+static void testMissRatioCurve (void);
+static void testTraceReplay (void);
+static void testPolicySimulation (void);
+static void testConcurrentMisses (void);
+static void testPinPages (void);
+static void testSwizzling (void);
+static void testSharedPool (void);
+
+// helper methods
+static void createDummyPages (int numPages);
+static void writePage (BM_BufferPool *const bm, PageNumber pageNum);
+static int checkPageOnDisk (PageNumber pageNum);
+static int isPageDirty (BM_BufferPool *const bm, PageNumber pageNum);
+static int getPageFrame (BM_BufferPool *const bm, PageNumber pageNum);
+static int getPageFixCount (BM_BufferPool *const bm, PageNumber pageNum);
+static void pinAndUnpin (BM_BufferPool *const bm, PageNumber pageNum);
+static int countResidentPages (BM_BufferPool *const bm, PageNumber first, PageNumber last);
+static void createNumberedPages (int numPages);
+static int getPageNumber (BM_PageHandle *const page);
+static void *pinRandomPages (void *arg);
+static int walkChain (BM_BufferPool *const bm, PageNumber first, int length);
+static void replayTrace (BM_TraceRecord *records, int numRecords, ReplacementStrategy strategy, int numFrames, int *reads, int *writes);
+static void addPinUnpin (BM_TraceRecord *records, int *numRecords, PageNumber pageNum);
+
+// one thread of a concurrent test, errors counts the pins that went wrong
+typedef struct TestWorker {
+	BM_BufferPool *bm;
+	int seed;
+	int numPages;
+	int errors;
+} TestWorker;
+
+// main method
+int
+main (void)
+{
+	initStorageManager();
+	testName = "";
+
+	testFlushInPageOrder();
+	testVictimSearch();
+	testRandomWorkload();
+	testVictimCache();
+	testPageClasses();
+	testMissRatioCurve();
+	testTraceReplay();
+	testPolicySimulation();
+	testConcurrentMisses();
+	testPinPages();
+	testSwizzling();
+	testSharedPool();
+
+	return 0;
+}
+
+// ************************************************************
+// create a page file of numPages empty pages
+void
+createDummyPages (int numPages)
+{
+	SM_FileHandle fh;
+
+	remove(PAGE_FILE_NAME);
+	TEST_CHECK(createPageFile(PAGE_FILE_NAME));
+	TEST_CHECK(openPageFile(PAGE_FILE_NAME, &fh));
+	TEST_CHECK(ensureCapacity(numPages, &fh));
+	TEST_CHECK(closePageFile(&fh));
+}
+
+// pin a page, write "Page-<pageNum>" to it, mark it dirty and unpin it
+void
+writePage (BM_BufferPool *const bm, PageNumber pageNum)
+{
+	BM_PageHandle h;
+
+	TEST_CHECK(pinPage(bm, &h, pageNum));
+	sprintf(h.data, "Page-%i", pageNum);
+	TEST_CHECK(markDirty(bm, &h));
+	TEST_CHECK(unpinPage(bm, &h));
+}
+
+// returns 1 if page pageNum of the page file holds "Page-<pageNum>"
+int
+checkPageOnDisk (PageNumber pageNum)
+{
+	SM_FileHandle fh;
+	char data[PAGE_SIZE];
+	char expected[32];
+
+	TEST_CHECK(openPageFile(PAGE_FILE_NAME, &fh));
+	TEST_CHECK(readBlock(pageNum, &fh, data));
+	TEST_CHECK(closePageFile(&fh));
+	sprintf(expected, "Page-%i", pageNum);
+	return strcmp(data, expected) == 0;
+}
+
+// returns 1 if the page is resident and dirty, 0 if it is resident and clean, -1 otherwise
+int
+isPageDirty (BM_BufferPool *const bm, PageNumber pageNum)
+{
+	PageNumber *frameContents = getFrameContents(bm);
+	bool *dirtyFlags = getDirtyFlags(bm);
+	int result = -1;
+
+	for (int i = 0; i < bm->numPages; i++)
+		if (frameContents[i] == pageNum)
+			result = dirtyFlags[i] ? 1 : 0;
+	free(frameContents);
+	free(dirtyFlags);
+	return result;
+}
+
+// returns the frame holding the page or -1 if it is not resident
+int
+getPageFrame (BM_BufferPool *const bm, PageNumber pageNum)
+{
+	PageNumber *frameContents = getFrameContents(bm);
+	int result = -1;
+
+	for (int i = 0; i < bm->numPages; i++)
+		if (frameContents[i] == pageNum)
+			result = i;
+	free(frameContents);
+	return result;
+}
+
+// returns the fix count of a resident page
+int
+getPageFixCount (BM_BufferPool *const bm, PageNumber pageNum)
+{
+	int *fixCounts = getFixCounts(bm);
+	int result = fixCounts[getPageFrame(bm, pageNum)];
+
+	free(fixCounts);
+	return result;
+}
+
+// pin a page and unpin it again
+void
+pinAndUnpin (BM_BufferPool *const bm, PageNumber pageNum)
+{
+	BM_PageHandle h;
+
+	TEST_CHECK(pinPage(bm, &h, pageNum));
+	TEST_CHECK(unpinPage(bm, &h));
+}
+
+// returns the number of pages from first to last that are resident
+int
+countResidentPages (BM_BufferPool *const bm, PageNumber first, PageNumber last)
+{
+	PageNumber *frameContents = getFrameContents(bm);
+	int count = 0;
+
+	for (int i = 0; i < bm->numPages; i++)
+		if (frameContents[i] >= first && frameContents[i] <= last)
+			count++;
+	free(frameContents);
+	return count;
+}
+
+// create a page file of numPages pages, each starting with its page number as an int
+void
+createNumberedPages (int numPages)
+{
+	SM_FileHandle fh;
+	char data[PAGE_SIZE];
+
+	createDummyPages(numPages);
+	TEST_CHECK(openPageFile(PAGE_FILE_NAME, &fh));
+	for (int i = 0; i < numPages; i++)
+	{
+		memset(data, 0, PAGE_SIZE);
+		memcpy(data, &i, sizeof(int));
+		TEST_CHECK(writeBlock(i, &fh, data));
+	}
+	TEST_CHECK(closePageFile(&fh));
+}
+
+// the page number a page of createNumberedPages starts with
+int
+getPageNumber (BM_PageHandle *const page)
+{
+	int pageNum;
+
+	memcpy(&pageNum, page->data, sizeof(int));
+	return pageNum;
+}
+
+// thread body: pin random pages of a numbered file and count the ones with the wrong content
+void *
+pinRandomPages (void *arg)
+{
+	TestWorker *worker = (TestWorker *)arg;
+	unsigned int seed = worker->seed;
+	BM_PageHandle h;
+
+	for (int i = 0; i < 20000; i++)
+	{
+		PageNumber pageNum = rand_r(&seed) % worker->numPages;
+		if (pinPage(worker->bm, &h, pageNum) != RC_OK)
+		{
+			worker->errors++;
+			continue;
+		}
+		if (getPageNumber(&h) != pageNum)
+			worker->errors++;
+		if (i % 5 == 0)
+			markDirty(worker->bm, &h);
+		unpinPage(worker->bm, &h);
+	}
+	return NULL;
+}
+
+// follow the chain first, first + 1, ... with pinNextPage, holding the previous page
+// returns the number of pages that did not hold their page number
+int
+walkChain (BM_BufferPool *const bm, PageNumber first, int length)
+{
+	BM_PageHandle current, next;
+	int errors = 0;
+
+	TEST_CHECK(pinPage(bm, &current, first));
+	errors += getPageNumber(&current) != first;
+	for (int i = 1; i < length; i++)
+	{
+		TEST_CHECK(pinNextPage(bm, &next, &current, first + i));
+		errors += getPageNumber(&next) != first + i;
+		TEST_CHECK(unpinPage(bm, &current));
+		current = next;
+	}
+	TEST_CHECK(unpinPage(bm, &current));
+	return errors;
+}
+
+// replay a trace on a fresh pool and return the reads and writes it caused
+void
+replayTrace (BM_TraceRecord *records, int numRecords, ReplacementStrategy strategy, int numFrames, int *reads, int *writes)
+{
+	BM_BufferPool bm;
+	BM_PageHandle h;
+
+	createDummyPages(12);
+	TEST_CHECK(initBufferPool(&bm, PAGE_FILE_NAME, numFrames, strategy, NULL));
+	for (int i = 0; i < numRecords; i++)
+	{
+		h.pageNum = records[i].pageNum;
+		switch (records[i].op)
+		{
+			case TRACE_PIN:
+				TEST_CHECK(pinPage(&bm, &h, records[i].pageNum));
+				break;
+			case TRACE_UNPIN:
+				TEST_CHECK(unpinPage(&bm, &h));
+				break;
+			case TRACE_DIRTY:
+				TEST_CHECK(markDirty(&bm, &h));
+				break;
+		}
+	}
+	*reads = getNumReadIO(&bm);
+	*writes = getNumWriteIO(&bm);
+	TEST_CHECK(shutdownBufferPool(&bm));
+}
+
+// append a pin and an unpin of pageNum to a trace
+void
+addPinUnpin (BM_TraceRecord *records, int *numRecords, PageNumber pageNum)
+{
+	records[*numRecords].timeStamp = *numRecords;
+	records[*numRecords].op = TRACE_PIN;
+	records[*numRecords].pageNum = pageNum;
+	(*numRecords)++;
+	records[*numRecords].timeStamp = *numRecords;
+	records[*numRecords].op = TRACE_UNPIN;
+	records[*numRecords].pageNum = pageNum;
+	(*numRecords)++;
+}
+
+// ************************************************************
+void
+testFlushInPageOrder (void)
+{
+	BM_BufferPool *bm = MAKE_POOL();
+	BM_PageHandle *h = MAKE_PAGE_HANDLE();
+	PageNumber pages[] = { 7, 3, 4, 5, 1, 9, 2, 6 };
+	testName = "test flushing the dirty set in page order";
+
+	createDummyPages(10);
+	TEST_CHECK(initBufferPool(bm, PAGE_FILE_NAME, 8, RS_LRU, NULL));
+	for (int i = 0; i < 8; i++)
+		writePage(bm, pages[i]);
+	ASSERT_EQUALS_INT(8, getNumDirtyPages(bm), "every page is dirty");
+	ASSERT_EQUALS_INT(0, getNumWriteIO(bm), "nothing written yet");
+
+	// a partial flush takes the lowest page numbers first and the next one continues after them
+	TEST_CHECK(flushSome(bm, 3));
+	ASSERT_EQUALS_INT(3, getNumWriteIO(bm), "flushSome writes 3 pages");
+	ASSERT_EQUALS_INT(5, getNumDirtyPages(bm), "5 pages still dirty");
+	ASSERT_EQUALS_INT(0, isPageDirty(bm, 1), "page 1 written by the first sweep");
+	ASSERT_EQUALS_INT(0, isPageDirty(bm, 3), "page 3 written by the first sweep");
+	ASSERT_EQUALS_INT(1, isPageDirty(bm, 4), "page 4 left for the next sweep");
+	TEST_CHECK(flushSome(bm, 3));
+	ASSERT_EQUALS_INT(6, getNumWriteIO(bm), "flushSome writes 3 more pages");
+	ASSERT_EQUALS_INT(0, isPageDirty(bm, 4), "page 4 written by the second sweep");
+	ASSERT_EQUALS_INT(0, isPageDirty(bm, 6), "page 6 written by the second sweep");
+	ASSERT_EQUALS_INT(1, isPageDirty(bm, 7), "page 7 left for the next sweep");
+
+	// a pinned dirty page is skipped by forceFlushPool
+	TEST_CHECK(pinPage(bm, h, 7));
+	TEST_CHECK(forceFlushPool(bm));
+	ASSERT_EQUALS_INT(7, getNumWriteIO(bm), "only page 9 written");
+	ASSERT_EQUALS_INT(1, isPageDirty(bm, 7), "pinned page 7 stays dirty");
+	ASSERT_EQUALS_INT(0, isPageDirty(bm, 9), "page 9 written");
+	TEST_CHECK(unpinPage(bm, h));
+	TEST_CHECK(forceFlushPool(bm));
+	ASSERT_EQUALS_INT(8, getNumWriteIO(bm), "every page written once");
+	ASSERT_EQUALS_INT(0, getNumDirtyPages(bm), "no dirty page left");
+
+	// a flush with nothing dirty does not write
+	TEST_CHECK(forceFlushPool(bm));
+	ASSERT_EQUALS_INT(8, getNumWriteIO(bm), "clean pool writes nothing");
+	TEST_CHECK(shutdownBufferPool(bm));
+
+	for (int i = 0; i < 8; i++)
+		ASSERT_TRUE(checkPageOnDisk(pages[i]), "page content written to disk");
+
+	TEST_CHECK(destroyPageFile(PAGE_FILE_NAME));
+	free(bm);
+	free(h);
+	TEST_DONE();
+}
+
+// ************************************************************
+void
+testVictimSearch (void)
+{
+	BM_BufferPool *bm = MAKE_POOL();
+	BM_PageHandle h[37];
+	BM_PageHandle *extra = MAKE_PAGE_HANDLE();
+	ReplacementStrategy strategies[] = { RS_FIFO, RS_LRU, RS_CLOCK };
+	testName = "test victim search over more frames than one vector holds";
+
+	createDummyPages(60);
+
+	// with every frame but one pinned, each strategy has to find that frame
+	for (int s = 0; s < 3; s++)
+	{
+		TEST_CHECK(initBufferPool(bm, PAGE_FILE_NAME, 37, strategies[s], NULL));
+		for (int i = 0; i < 37; i++)
+			TEST_CHECK(pinPage(bm, &h[i], i));
+		int freeFrame = getPageFrame(bm, 29);
+		TEST_CHECK(unpinPage(bm, &h[29]));
+		TEST_CHECK(pinPage(bm, extra, 50));
+		ASSERT_EQUALS_INT(freeFrame, getPageFrame(bm, 50), "the only unpinned frame is the victim");
+		ASSERT_EQUALS_INT(-1, getPageFrame(bm, 29), "page 29 evicted");
+		ASSERT_ERROR(pinPage(bm, &h[29], 51), "no frame left when every page is pinned");
+		TEST_CHECK(unpinPage(bm, extra));
+		for (int i = 0; i < 37; i++)
+			if (i != 29)
+				TEST_CHECK(unpinPage(bm, &h[i]));
+		TEST_CHECK(shutdownBufferPool(bm));
+	}
+
+	// FIFO takes the oldest unpinned page, LRU the least recently used one
+	TEST_CHECK(initBufferPool(bm, PAGE_FILE_NAME, 20, RS_FIFO, NULL));
+	for (int i = 0; i < 20; i++)
+	{
+		TEST_CHECK(pinPage(bm, &h[i], i));
+		if (i != 0)
+			TEST_CHECK(unpinPage(bm, &h[i]));
+	}
+	TEST_CHECK(pinPage(bm, extra, 1));
+	TEST_CHECK(unpinPage(bm, extra));
+	TEST_CHECK(pinPage(bm, extra, 20));
+	TEST_CHECK(unpinPage(bm, extra));
+	ASSERT_EQUALS_INT(-1, getPageFrame(bm, 1), "FIFO evicts page 1 (page 0 is pinned) even though it was just used");
+	TEST_CHECK(pinPage(bm, extra, 21));
+	TEST_CHECK(unpinPage(bm, extra));
+	ASSERT_EQUALS_INT(-1, getPageFrame(bm, 2), "FIFO evicts page 2 next");
+	TEST_CHECK(unpinPage(bm, &h[0]));
+	TEST_CHECK(shutdownBufferPool(bm));
+
+	TEST_CHECK(initBufferPool(bm, PAGE_FILE_NAME, 20, RS_LRU, NULL));
+	for (int i = 0; i < 20; i++)
+	{
+		TEST_CHECK(pinPage(bm, &h[i], i));
+		TEST_CHECK(unpinPage(bm, &h[i]));
+	}
+	for (int i = 0; i < 10; i++)
+	{
+		TEST_CHECK(pinPage(bm, &h[i], i));
+		TEST_CHECK(unpinPage(bm, &h[i]));
+	}
+	TEST_CHECK(pinPage(bm, &h[10], 10));
+	TEST_CHECK(pinPage(bm, extra, 20));
+	TEST_CHECK(unpinPage(bm, extra));
+	ASSERT_EQUALS_INT(-1, getPageFrame(bm, 11), "LRU evicts page 11 (page 10 is pinned)");
+	ASSERT_TRUE(getPageFrame(bm, 0) != -1, "recently used page 0 stays");
+	TEST_CHECK(pinPage(bm, extra, 21));
+	TEST_CHECK(unpinPage(bm, extra));
+	ASSERT_EQUALS_INT(-1, getPageFrame(bm, 12), "LRU evicts page 12 next");
+	TEST_CHECK(unpinPage(bm, &h[10]));
+	TEST_CHECK(shutdownBufferPool(bm));
+
+	TEST_CHECK(destroyPageFile(PAGE_FILE_NAME));
+	free(bm);
+	free(extra);
+	TEST_DONE();
+}
+
+// ************************************************************
+void
+testRandomWorkload (void)
+{
+	BM_BufferPool *bm = MAKE_POOL();
+	BM_PageHandle held[30];
+	BM_PageHandle h;
+	ReplacementStrategy strategies[] = { RS_FIFO, RS_LRU, RS_CLOCK };
+	int expectedFixCounts[120];
+	char expected[32];
+	testName = "test a random pin/unpin workload against the expected fix counts";
+
+	createDummyPages(120);
+	for (int s = 0; s < 3; s++)
+	{
+		int numHeld = 0;
+		int errors = 0;
+		memset(expectedFixCounts, 0, sizeof(expectedFixCounts));
+		srand(s + 1);
+		TEST_CHECK(initBufferPool(bm, PAGE_FILE_NAME, 37, strategies[s], NULL));
+		for (int k = 0; k < 20000; k++)
+		{
+			PageNumber pageNum = (rand() % 3 == 0) ? rand() % 10 : rand() % 120;
+			BM_PageHandle *page = (numHeld < 30 && rand() % 4 == 0) ? &held[numHeld] : &h;
+			TEST_CHECK(pinPage(bm, page, pageNum));
+
+			// a page read back from the file or found in its frame holds what was last written
+			sprintf(expected, "Page-%i", pageNum);
+			if (page->data[0] != '\0' && strcmp(page->data, expected) != 0)
+				errors++;
+			if (rand() % 5 == 0)
+			{
+				strcpy(page->data, expected);
+				TEST_CHECK(markDirty(bm, page));
+			}
+			expectedFixCounts[pageNum]++;
+			if (page == &h)
+			{
+				TEST_CHECK(unpinPage(bm, page));
+				expectedFixCounts[pageNum]--;
+			}
+			else
+				numHeld++;
+			if (numHeld > 0 && rand() % 3 == 0)
+			{
+				numHeld--;
+				TEST_CHECK(unpinPage(bm, &held[numHeld]));
+				expectedFixCounts[held[numHeld].pageNum]--;
+			}
+		}
+		ASSERT_EQUALS_INT(0, errors, "every pinned page has its content");
+
+		// every held page is resident once with its fix count, no other frame is pinned
+		PageNumber *frameContents = getFrameContents(bm);
+		int *fixCounts = getFixCounts(bm);
+		int pinnedFrames = 0;
+		int pinnedPages = 0;
+		for (int i = 0; i < bm->numPages; i++)
+		{
+			if (fixCounts[i] > 0)
+				pinnedFrames++;
+			for (int j = i + 1; j < bm->numPages; j++)
+				if (frameContents[i] != NO_PAGE && frameContents[i] == frameContents[j])
+					errors++;
+			if (frameContents[i] != NO_PAGE && fixCounts[i] != expectedFixCounts[frameContents[i]])
+				errors++;
+		}
+		for (int p = 0; p < 120; p++)
+			if (expectedFixCounts[p] > 0)
+				pinnedPages++;
+		ASSERT_EQUALS_INT(0, errors, "frames match the expected fix counts and hold distinct pages");
+		ASSERT_EQUALS_INT(pinnedPages, pinnedFrames, "every pinned page is resident");
+		free(frameContents);
+		free(fixCounts);
+
+		while (numHeld > 0)
+		{
+			numHeld--;
+			TEST_CHECK(unpinPage(bm, &held[numHeld]));
+		}
+		TEST_CHECK(shutdownBufferPool(bm));
+	}
+
+	TEST_CHECK(destroyPageFile(PAGE_FILE_NAME));
+	free(bm);
+	TEST_DONE();
+}
+
+// ************************************************************
+void
+testVictimCache (void)
+{
+	BM_BufferPool *bm = MAKE_POOL();
+	BM_PageHandle *h = MAKE_PAGE_HANDLE();
+	char noise[PAGE_SIZE];
+	testName = "test the compressed victim cache";
+
+	createDummyPages(20);
+	TEST_CHECK(initBufferPool(bm, PAGE_FILE_NAME, 4, RS_LRU, NULL));
+	TEST_CHECK(setVictimCacheSize(bm, 64 * 1024));
+
+	// evicted pages are written back and keep a compressed copy
+	for (int i = 0; i < 8; i++)
+		writePage(bm, i);
+	ASSERT_EQUALS_INT(8, getNumReadIO(bm), "every page read once");
+	ASSERT_EQUALS_INT(4, getNumWriteIO(bm), "the evicted pages were written");
+	TEST_CHECK(pinPage(bm, h, 0));
+	ASSERT_EQUALS_INT(1, getNumVictimCacheHits(bm), "page 0 comes from the victim cache");
+	ASSERT_EQUALS_INT(8, getNumReadIO(bm), "page 0 is not read again");
+	ASSERT_EQUALS_STRING("Page-0", h->data, "page 0 content restored from the cache");
+	TEST_CHECK(unpinPage(bm, h));
+	TEST_CHECK(pinPage(bm, h, 2));
+	ASSERT_EQUALS_STRING("Page-2", h->data, "page 2 content restored from the cache");
+	TEST_CHECK(unpinPage(bm, h));
+	ASSERT_EQUALS_INT(2, getNumVictimCacheHits(bm), "page 2 comes from the victim cache");
+
+	// a page rewritten after leaving the cache is cached again with its new content
+	TEST_CHECK(pinPage(bm, h, 0));
+	sprintf(h->data, "%s", "Page-0-rewritten");
+	TEST_CHECK(markDirty(bm, h));
+	TEST_CHECK(unpinPage(bm, h));
+	for (int i = 4; i < 8; i++)
+		pinAndUnpin(bm, i);
+	TEST_CHECK(pinPage(bm, h, 0));
+	ASSERT_EQUALS_STRING("Page-0-rewritten", h->data, "no stale copy of page 0");
+	TEST_CHECK(unpinPage(bm, h));
+
+	// a page that does not compress is read from the file again
+	TEST_CHECK(pinPage(bm, h, 10));
+	for (int i = 0; i < PAGE_SIZE; i++)
+		noise[i] = (char)((i * 2654435761u) >> 13);
+	memcpy(h->data, noise, PAGE_SIZE);
+	TEST_CHECK(markDirty(bm, h));
+	TEST_CHECK(unpinPage(bm, h));
+	for (int i = 11; i < 15; i++)
+		pinAndUnpin(bm, i);
+	int reads = getNumReadIO(bm);
+	TEST_CHECK(pinPage(bm, h, 10));
+	ASSERT_EQUALS_INT(reads + 1, getNumReadIO(bm), "incompressible page read from the file");
+	ASSERT_TRUE(memcmp(noise, h->data, PAGE_SIZE) == 0, "incompressible page content");
+	TEST_CHECK(unpinPage(bm, h));
+
+	// with the cache turned off every miss is a read
+	TEST_CHECK(setVictimCacheSize(bm, 0));
+	for (int i = 15; i < 19; i++)
+		pinAndUnpin(bm, i);
+	int hits = getNumVictimCacheHits(bm);
+	reads = getNumReadIO(bm);
+	TEST_CHECK(pinPage(bm, h, 1));
+	ASSERT_EQUALS_INT(hits, getNumVictimCacheHits(bm), "no hit without a cache");
+	ASSERT_EQUALS_INT(reads + 1, getNumReadIO(bm), "page 1 read from the file");
+	ASSERT_EQUALS_STRING("Page-1", h->data, "page 1 content from the file");
+	TEST_CHECK(unpinPage(bm, h));
+
+	TEST_CHECK(shutdownBufferPool(bm));
+	TEST_CHECK(destroyPageFile(PAGE_FILE_NAME));
+	free(bm);
+	free(h);
+	TEST_DONE();
+}
+
+// ************************************************************
+void
+testPageClasses (void)
+{
+	BM_BufferPool *bm = MAKE_POOL();
+	testName = "test page class quotas and priorities";
+
+	createDummyPages(200);
+
+	// a class at its maximum replaces its own pages and leaves the rest of the pool alone
+	TEST_CHECK(initBufferPool(bm, PAGE_FILE_NAME, 10, RS_LRU, NULL));
+	for (int i = 100; i < 200; i++)
+		TEST_CHECK(setPageClass(bm, i, 2));
+	TEST_CHECK(setClassQuota(bm, 2, 0, 3));
+	for (int i = 0; i < 4; i++)
+		pinAndUnpin(bm, i);
+	for (int i = 100; i < 150; i++)
+		pinAndUnpin(bm, i);
+	ASSERT_EQUALS_INT(3, countResidentPages(bm, 100, 199), "the scan holds at most 3 frames");
+	ASSERT_EQUALS_INT(4, countResidentPages(bm, 0, 3), "the other pages stay");
+	ASSERT_EQUALS_INT(3, countResidentPages(bm, NO_PAGE, NO_PAGE), "free frames are left free");
+	ASSERT_ERROR(setPageClass(bm, 5, -1), "class ids are not negative");
+	ASSERT_ERROR(setClassQuota(bm, 2, 4, 3), "reservation above the maximum");
+	TEST_CHECK(shutdownBufferPool(bm));
+
+	// the lowest priority class gives up its frames first
+	TEST_CHECK(initBufferPool(bm, PAGE_FILE_NAME, 10, RS_LRU, NULL));
+	for (int i = 0; i < 4; i++)
+		TEST_CHECK(setPageClass(bm, i, 1));
+	TEST_CHECK(setClassPriority(bm, 1, 5));
+	for (int i = 0; i < 4; i++)
+		pinAndUnpin(bm, i);
+	for (int i = 100; i < 200; i++)
+		pinAndUnpin(bm, i);
+	ASSERT_EQUALS_INT(4, countResidentPages(bm, 0, 3), "high priority pages survive the scan");
+	int reads = getNumReadIO(bm);
+	for (int i = 0; i < 4; i++)
+		pinAndUnpin(bm, i);
+	ASSERT_EQUALS_INT(reads, getNumReadIO(bm), "high priority pages are hits");
+	TEST_CHECK(shutdownBufferPool(bm));
+
+	// reserved frames are kept even for a class with the default priority
+	TEST_CHECK(initBufferPool(bm, PAGE_FILE_NAME, 10, RS_FIFO, NULL));
+	for (int i = 0; i < 4; i++)
+		TEST_CHECK(setPageClass(bm, i, 1));
+	TEST_CHECK(setClassQuota(bm, 1, 4, 0));
+	for (int i = 0; i < 4; i++)
+		pinAndUnpin(bm, i);
+	for (int i = 100; i < 200; i++)
+		pinAndUnpin(bm, i);
+	ASSERT_EQUALS_INT(4, countResidentPages(bm, 0, 3), "reserved pages survive the scan");
+	ASSERT_EQUALS_INT(6, countResidentPages(bm, 100, 199), "the scan uses the other frames");
+	TEST_CHECK(shutdownBufferPool(bm));
+
+	// while a frame is free nothing is evicted, whatever the policy would pick
+	TEST_CHECK(initBufferPool(bm, PAGE_FILE_NAME, 4, RS_FIFO, NULL));
+	TEST_CHECK(setPageClass(bm, 0, 1));
+	TEST_CHECK(setClassPriority(bm, 1, 5));
+	for (int i = 0; i < 4; i++)
+		pinAndUnpin(bm, i);
+	ASSERT_EQUALS_INT(4, countResidentPages(bm, 0, 3), "every page got a free frame");
+	ASSERT_EQUALS_INT(4, getNumReadIO(bm), "each page read once");
+	TEST_CHECK(shutdownBufferPool(bm));
+
+	TEST_CHECK(destroyPageFile(PAGE_FILE_NAME));
+	free(bm);
+	TEST_DONE();
+}
+
+// ************************************************************
+void
+testMissRatioCurve (void)
+{
+	BM_BufferPool *bm = MAKE_POOL();
+	int numAccesses = 20000;
+	int *trace = (int *)malloc(sizeof(int) * numAccesses);
+	testName = "test the miss-ratio curve against real LRU pools";
+
+	// a skewed trace over 50 pages, more than the curve keeps track of
+	srand(7);
+	for (int i = 0; i < numAccesses; i++)
+		trace[i] = (rand() % 10 < 7) ? rand() % 8 : rand() % 50;
+	createDummyPages(50);
+
+	TEST_CHECK(initBufferPool(bm, PAGE_FILE_NAME, 20, RS_LRU, NULL));
+	ASSERT_EQUALS_INT(0, getMissRatioCurveSize(bm), "no curve before it is enabled");
+	ASSERT_ERROR(enableMissRatioCurve(bm, 20, 0), "the sampling rate must be positive");
+	TEST_CHECK(enableMissRatioCurve(bm, 20, 1));
+	ASSERT_EQUALS_INT(20, getMissRatioCurveSize(bm), "curve for pool sizes up to 20");
+	for (int i = 0; i < numAccesses; i++)
+		pinAndUnpin(bm, trace[i]);
+	double *curve = getMissRatioCurve(bm);
+	TEST_CHECK(shutdownBufferPool(bm));
+
+	// with every key sampled the curve is exact: it predicts the reads of each pool size
+	ASSERT_EQUALS_INT(numAccesses, (int)(curve[0] * numAccesses + 0.5), "a pool of 0 frames misses always");
+	for (int size = 1; size <= 20; size++)
+	{
+		TEST_CHECK(initBufferPool(bm, PAGE_FILE_NAME, size, RS_LRU, NULL));
+		for (int i = 0; i < numAccesses; i++)
+			pinAndUnpin(bm, trace[i]);
+		ASSERT_EQUALS_INT(getNumReadIO(bm), (int)(curve[size] * numAccesses + 0.5), "predicted misses match the pool");
+		ASSERT_TRUE(curve[size] <= curve[size - 1], "the curve does not rise");
+		TEST_CHECK(shutdownBufferPool(bm));
+	}
+	free(curve);
+
+	// a sampled curve still covers every size and does not rise
+	TEST_CHECK(initBufferPool(bm, PAGE_FILE_NAME, 20, RS_LRU, NULL));
+	TEST_CHECK(enableMissRatioCurve(bm, 20, 4));
+	for (int i = 0; i < numAccesses; i++)
+		pinAndUnpin(bm, trace[i]);
+	curve = getMissRatioCurve(bm);
+	for (int size = 1; size <= 20; size++)
+		ASSERT_TRUE(curve[size] <= curve[size - 1] && curve[size] >= 0.0, "the sampled curve does not rise");
+	free(curve);
+	TEST_CHECK(enableMissRatioCurve(bm, 0, 1));
+	ASSERT_TRUE(getMissRatioCurve(bm) == NULL, "no curve once it is disabled");
+	TEST_CHECK(shutdownBufferPool(bm));
+
+	TEST_CHECK(destroyPageFile(PAGE_FILE_NAME));
+	free(trace);
+	free(bm);
+	TEST_DONE();
+}
+
+// ************************************************************
+void
+testTraceReplay (void)
+{
+	BM_BufferPool *bm = MAKE_POOL();
+	BM_PageHandle *h = MAKE_PAGE_HANDLE();
+	BM_PageHandle *h2 = MAKE_PAGE_HANDLE();
+	BM_TraceRecord records[8192];
+	testName = "test recording a trace and replaying it";
+
+	createDummyPages(12);
+	TEST_CHECK(initBufferPool(bm, PAGE_FILE_NAME, 5, RS_LRU, NULL));
+	TEST_CHECK(startTrace(bm, TRACE_FILE_NAME));
+	srand(3);
+	for (int i = 0; i < 3000; i++)
+	{
+		PageNumber pageNum = (i == 0) ? 3 : rand() % 12;
+		TEST_CHECK(pinPage(bm, h, pageNum));
+		if (i == 0 || rand() % 3 == 0)
+			TEST_CHECK(markDirty(bm, h));
+		if (i % 7 == 0)
+		{
+			TEST_CHECK(pinPage(bm, h2, (pageNum + 1) % 12));
+			TEST_CHECK(unpinPage(bm, h2));
+		}
+		TEST_CHECK(unpinPage(bm, h));
+	}
+	int reads = getNumReadIO(bm);
+	int writes = getNumWriteIO(bm);
+	TEST_CHECK(stopTrace(bm));
+	// accesses after the trace stopped are not recorded
+	pinAndUnpin(bm, 11);
+	TEST_CHECK(shutdownBufferPool(bm));
+
+	FILE *traceFile = fopen(TRACE_FILE_NAME, "rb");
+	ASSERT_TRUE(traceFile != NULL, "trace file written");
+	int numRecords = (int)fread(records, sizeof(BM_TraceRecord), 8192, traceFile);
+	fclose(traceFile);
+	ASSERT_TRUE(numRecords < 8192, "trace fits the buffer");
+	ASSERT_EQUALS_INT(TRACE_PIN, records[0].op, "first record is a pin");
+	ASSERT_EQUALS_INT(3, records[0].pageNum, "of page 3");
+	ASSERT_EQUALS_INT(TRACE_DIRTY, records[1].op, "then page 3 is marked dirty");
+	ASSERT_EQUALS_INT(TRACE_PIN, records[2].op, "then page 4 is pinned");
+	ASSERT_EQUALS_INT(4, records[2].pageNum, "page 4");
+	ASSERT_EQUALS_INT(TRACE_UNPIN, records[numRecords - 1].op, "last record is an unpin");
+	int pins = 0;
+	int unpins = 0;
+	int ordered = 1;
+	for (int i = 0; i < numRecords; i++)
+	{
+		pins += records[i].op == TRACE_PIN;
+		unpins += records[i].op == TRACE_UNPIN;
+		if (i > 0 && records[i].timeStamp < records[i - 1].timeStamp)
+			ordered = 0;
+	}
+	ASSERT_EQUALS_INT(3000 + 3000 / 7 + 1, pins, "every pin recorded");
+	ASSERT_EQUALS_INT(pins, unpins, "every unpin recorded");
+	ASSERT_TRUE(ordered, "time stamps do not go back");
+
+	// replaying the trace on the same kind of pool gives the same I/O
+	int replayReads, replayWrites;
+	replayTrace(records, numRecords, RS_LRU, 5, &replayReads, &replayWrites);
+	ASSERT_EQUALS_INT(reads, replayReads, "replay reads as many pages");
+	ASSERT_EQUALS_INT(writes, replayWrites, "replay writes as many pages");
+
+	// the in-memory simulation sees the I/O a real pool does, for every implemented strategy
+	ReplacementStrategy strategies[] = { RS_FIFO, RS_LRU, RS_CLOCK };
+	int errors = 0;
+	for (int s = 0; s < 3; s++)
+	{
+		for (int numFrames = 2; numFrames <= 8; numFrames += 3)
+		{
+			PS_Result result;
+			errors += simulatePolicy(records, numRecords, strategies[s], numFrames, &result) != 0;
+			replayTrace(records, numRecords, strategies[s], numFrames, &replayReads, &replayWrites);
+			if (result.pins != pins || result.failed != 0 || result.hits + result.misses != pins ||
+			    result.misses != replayReads || result.writeBacks != replayWrites)
+				errors++;
+		}
+	}
+	ASSERT_EQUALS_INT(0, errors, "simulated hits, misses and write-backs match the pool");
+
+	remove(TRACE_FILE_NAME);
+	TEST_CHECK(destroyPageFile(PAGE_FILE_NAME));
+	free(bm);
+	free(h);
+	free(h2);
+	TEST_DONE();
+}
+
+// ************************************************************
+void
+testPolicySimulation (void)
+{
+	BM_TraceRecord records[64];
+	PS_Result result;
+	int numRecords = 0;
+	PageNumber pages[] = { 1, 1, 1, 2, 3, 1 };
+	testName = "test simulating LFU and LRU-K";
+
+	// page 1 is pinned often but not recently when page 3 needs a frame
+	for (int i = 0; i < 6; i++)
+		addPinUnpin(records, &numRecords, pages[i]);
+
+	TEST_CHECK(simulatePolicy(records, numRecords, RS_LRU, 2, &result));
+	ASSERT_EQUALS_INT(4, (int)result.misses, "LRU evicts page 1 for page 3");
+	ASSERT_EQUALS_INT(2, (int)result.hits, "LRU hits on page 1 twice");
+	TEST_CHECK(simulatePolicy(records, numRecords, RS_LFU, 2, &result));
+	ASSERT_EQUALS_INT(3, (int)result.misses, "LFU evicts page 2 for page 3");
+	ASSERT_EQUALS_INT(3, (int)result.hits, "LFU keeps page 1");
+	TEST_CHECK(simulatePolicy(records, numRecords, RS_LRU_K, 2, &result));
+	ASSERT_EQUALS_INT(3, (int)result.misses, "LRU-K evicts page 2, pinned only once");
+	ASSERT_EQUALS_INT(3, (int)result.hits, "LRU-K keeps page 1");
+
+	// LRU-K ages a page out by its second last pin where LFU keeps counting
+	numRecords = 0;
+	PageNumber burst[] = { 1, 1, 1, 1, 2, 3, 2, 3, 4, 1 };
+	for (int i = 0; i < 10; i++)
+		addPinUnpin(records, &numRecords, burst[i]);
+	TEST_CHECK(simulatePolicy(records, numRecords, RS_LFU, 3, &result));
+	ASSERT_EQUALS_INT(4, (int)result.misses, "LFU keeps the burst page 1");
+	TEST_CHECK(simulatePolicy(records, numRecords, RS_LRU_K, 3, &result));
+	ASSERT_EQUALS_INT(5, (int)result.misses, "LRU-K evicts page 1 for page 4");
+
+	// a dirty page is written back once when it is evicted, a pin with every frame pinned fails
+	numRecords = 0;
+	addPinUnpin(records, &numRecords, 1);
+	records[numRecords].timeStamp = numRecords;
+	records[numRecords].op = TRACE_PIN;
+	records[numRecords].pageNum = 1;
+	numRecords++;
+	records[numRecords].timeStamp = numRecords;
+	records[numRecords].op = TRACE_DIRTY;
+	records[numRecords].pageNum = 1;
+	numRecords++;
+	addPinUnpin(records, &numRecords, 2);
+	records[numRecords - 1].pageNum = 1;
+	addPinUnpin(records, &numRecords, 3);
+	TEST_CHECK(simulatePolicy(records, numRecords, RS_FIFO, 1, &result));
+	ASSERT_EQUALS_INT(4, (int)result.pins, "4 pins replayed");
+	ASSERT_EQUALS_INT(1, (int)result.failed, "page 2 cannot get the pinned frame");
+	ASSERT_EQUALS_INT(1, (int)result.writeBacks, "dirty page 1 written when page 3 replaces it");
+	ASSERT_EQUALS_INT(2, (int)result.misses, "pages 1 and 3 are read");
+
+	ASSERT_TRUE(simulatePolicy(records, numRecords, RS_LRU, 0, &result) != 0, "no pool without frames");
+	TEST_DONE();
+}
+
+// ************************************************************
+void
+testConcurrentMisses (void)
+{
+	BM_BufferPool *bm = MAKE_POOL();
+	TestWorker workers[8];
+	pthread_t threads[8];
+	int errors = 0;
+	testName = "test threads missing on the same pages";
+
+	createNumberedPages(24);
+
+	// with a frame for every page each page is read once, however many threads miss on it
+	TEST_CHECK(initBufferPool(bm, PAGE_FILE_NAME, 24, RS_LRU, NULL));
+	for (int i = 0; i < 8; i++)
+	{
+		workers[i].bm = bm;
+		workers[i].seed = i + 1;
+		workers[i].numPages = 24;
+		workers[i].errors = 0;
+		pthread_create(&threads[i], NULL, pinRandomPages, &workers[i]);
+	}
+	for (int i = 0; i < 8; i++)
+	{
+		pthread_join(threads[i], NULL);
+		errors += workers[i].errors;
+	}
+	ASSERT_EQUALS_INT(0, errors, "every pin saw its page");
+	ASSERT_EQUALS_INT(24, getNumReadIO(bm), "each page read once");
+	TEST_CHECK(shutdownBufferPool(bm));
+
+	// with evictions going on the pages still keep their content and one frame each
+	TEST_CHECK(initBufferPool(bm, PAGE_FILE_NAME, 10, RS_LRU, NULL));
+	for (int i = 0; i < 8; i++)
+	{
+		workers[i].seed = i * 7 + 1;
+		pthread_create(&threads[i], NULL, pinRandomPages, &workers[i]);
+	}
+	for (int i = 0; i < 8; i++)
+	{
+		pthread_join(threads[i], NULL);
+		errors += workers[i].errors;
+	}
+	ASSERT_EQUALS_INT(0, errors, "every pin saw its page while pages were evicted");
+	PageNumber *frameContents = getFrameContents(bm);
+	int *fixCounts = getFixCounts(bm);
+	for (int i = 0; i < bm->numPages; i++)
+	{
+		errors += fixCounts[i] != 0;
+		for (int j = i + 1; j < bm->numPages; j++)
+			errors += frameContents[i] != NO_PAGE && frameContents[i] == frameContents[j];
+	}
+	free(frameContents);
+	free(fixCounts);
+	ASSERT_EQUALS_INT(0, errors, "no page pinned or resident twice");
+	TEST_CHECK(shutdownBufferPool(bm));
+
+	TEST_CHECK(destroyPageFile(PAGE_FILE_NAME));
+	free(bm);
+	TEST_DONE();
+}
+
+// ************************************************************
+void
+testPinPages (void)
+{
+	BM_BufferPool *bm = MAKE_POOL();
+	BM_PageHandle *one = MAKE_PAGE_HANDLE();
+	BM_PageHandle h[6];
+	PageNumber pages[] = { 9, 3, 7, 4, 3, 5 };
+	PageNumber tooMany[] = { 10, 11, 12, 13, 14, 3 };
+	testName = "test pinning a batch of pages";
+
+	createNumberedPages(24);
+	TEST_CHECK(initBufferPool(bm, PAGE_FILE_NAME, 6, RS_LRU, NULL));
+	TEST_CHECK(pinPage(bm, one, 7));
+
+	// every handle gets its page, a page asked for twice is pinned twice
+	TEST_CHECK(pinPages(bm, h, pages, 6));
+	for (int i = 0; i < 6; i++)
+	{
+		ASSERT_EQUALS_INT(pages[i], h[i].pageNum, "handle in request order");
+		ASSERT_EQUALS_INT(pages[i], getPageNumber(&h[i]), "handle holds its page");
+	}
+	ASSERT_EQUALS_INT(5, getNumReadIO(bm), "pages 3, 4, 5 and 9 read once, page 7 was resident");
+	ASSERT_EQUALS_INT(2, getPageFixCount(bm, 3), "page 3 pinned twice");
+	ASSERT_EQUALS_INT(2, getPageFixCount(bm, 7), "page 7 pinned by both");
+	for (int i = 0; i < 6; i++)
+		TEST_CHECK(unpinPage(bm, &h[i]));
+
+	// a batch that does not fit pins nothing
+	ASSERT_ERROR(pinPages(bm, h, tooMany, 6), "6 new pages do not fit next to pinned page 7");
+	int *fixCounts = getFixCounts(bm);
+	int pinned = 0;
+	for (int i = 0; i < bm->numPages; i++)
+		pinned += fixCounts[i];
+	free(fixCounts);
+	ASSERT_EQUALS_INT(1, pinned, "only page 7 stays pinned");
+	TEST_CHECK(unpinPage(bm, one));
+	TEST_CHECK(pinPages(bm, h, tooMany, 6));
+	for (int i = 0; i < 6; i++)
+	{
+		ASSERT_EQUALS_INT(tooMany[i], getPageNumber(&h[i]), "handle holds its page");
+		TEST_CHECK(unpinPage(bm, &h[i]));
+	}
+	TEST_CHECK(shutdownBufferPool(bm));
+
+	TEST_CHECK(destroyPageFile(PAGE_FILE_NAME));
+	free(bm);
+	free(one);
+	TEST_DONE();
+}
+
+// ************************************************************
+void
+testSwizzling (void)
+{
+	BM_BufferPool *bm = MAKE_POOL();
+	BM_PageHandle *from = MAKE_PAGE_HANDLE();
+	BM_PageHandle *h = MAKE_PAGE_HANDLE();
+	int errors;
+	testName = "test swizzled page links";
+
+	createNumberedPages(40);
+	TEST_CHECK(initBufferPool(bm, PAGE_FILE_NAME, 8, RS_LRU, NULL));
+	TEST_CHECK(setSwizzling(bm, TRUE));
+
+	// the first walk swizzles the links, the second one follows them
+	errors = walkChain(bm, 0, 6);
+	ASSERT_EQUALS_INT(0, errors, "first walk finds every page");
+	ASSERT_EQUALS_INT(0, getNumSwizzledPins(bm), "nothing swizzled yet");
+	errors = walkChain(bm, 0, 6);
+	ASSERT_EQUALS_INT(0, errors, "second walk finds every page");
+	ASSERT_EQUALS_INT(5, getNumSwizzledPins(bm), "every link followed");
+	ASSERT_EQUALS_INT(6, getNumReadIO(bm), "the chain was read once");
+
+	// evicting the chain drops its links, the next walk reads the pages again
+	errors = walkChain(bm, 20, 8);
+	ASSERT_EQUALS_INT(0, errors, "other chain fills the pool");
+	errors = walkChain(bm, 0, 6);
+	ASSERT_EQUALS_INT(0, errors, "walk after eviction finds every page");
+
+	// a link to a page whose frame went to another page is not followed
+	TEST_CHECK(pinPage(bm, from, 0));
+	TEST_CHECK(pinNextPage(bm, h, from, 1));
+	TEST_CHECK(unpinPage(bm, h));
+	for (int i = 30; i < 38; i++)
+		pinAndUnpin(bm, i);
+	ASSERT_EQUALS_INT(-1, getPageFrame(bm, 1), "page 1 evicted");
+	int swizzled = getNumSwizzledPins(bm);
+	TEST_CHECK(pinNextPage(bm, h, from, 1));
+	ASSERT_EQUALS_INT(1, getPageNumber(h), "page 1 read again");
+	ASSERT_EQUALS_INT(swizzled, getNumSwizzledPins(bm), "stale link not followed");
+	TEST_CHECK(unpinPage(bm, h));
+	TEST_CHECK(pinNextPage(bm, h, from, 2));
+	ASSERT_EQUALS_INT(2, getPageNumber(h), "a link to another page is not used");
+	TEST_CHECK(unpinPage(bm, h));
+	TEST_CHECK(unpinPage(bm, from));
+
+	// with swizzling off the page table is used every time
+	TEST_CHECK(setSwizzling(bm, FALSE));
+	swizzled = getNumSwizzledPins(bm);
+	errors = walkChain(bm, 0, 6);
+	ASSERT_EQUALS_INT(0, errors, "walk without swizzling");
+	errors = walkChain(bm, 0, 6);
+	ASSERT_EQUALS_INT(0, errors, "second walk without swizzling");
+	ASSERT_EQUALS_INT(swizzled, getNumSwizzledPins(bm), "no swizzled pin");
+	TEST_CHECK(shutdownBufferPool(bm));
+
+	TEST_CHECK(destroyPageFile(PAGE_FILE_NAME));
+	free(bm);
+	free(from);
+	free(h);
+	TEST_DONE();
+}
+
+// ************************************************************
+void
+testSharedPool (void)
+{
+	BM_BufferPool *bm = MAKE_POOL();
+	BM_PageHandle *h = MAKE_PAGE_HANDLE();
+	char expected[32];
+	int toChild[2], toParent[2];
+	int status;
+	char signal;
+	testName = "test a buffer pool shared by two processes";
+
+	createDummyPages(1);
+	shm_unlink(SEGMENT_NAME);
+	TEST_CHECK(initSharedBufferPool(bm, PAGE_FILE_NAME, 4, RS_LRU, SEGMENT_NAME));
+	ASSERT_ERROR(setSwizzling(bm, TRUE), "no swizzling in a shared pool");
+	ASSERT_ERROR(setVictimCacheSize(bm, 1000), "no victim cache in a shared pool");
+	writePage(bm, 0);
+
+	// the child sees the parent's dirty page and appends pages of its own; the last one
+	// stays dirty in the pool until the parent flushes it
+	ASSERT_TRUE(pipe(toChild) == 0 && pipe(toParent) == 0, "pipes created");
+	pid_t pid = fork();
+	if (pid == 0)
+	{
+		BM_BufferPool child;
+		int failed = initSharedBufferPool(&child, PAGE_FILE_NAME, 4, RS_LRU, SEGMENT_NAME) != RC_OK;
+		failed = failed || initSharedBufferPool(bm, PAGE_FILE_NAME, 5, RS_LRU, SEGMENT_NAME) == RC_OK;
+		failed = failed || pinPage(&child, h, 0) != RC_OK || strcmp(h->data, "Page-0") != 0;
+		failed = failed || unpinPage(&child, h) != RC_OK;
+		for (int i = 1; i < 40 && !failed; i++)
+		{
+			failed = pinPage(&child, h, i) != RC_OK;
+			sprintf(h->data, "Page-%i", i);
+			failed = failed || markDirty(&child, h) != RC_OK || unpinPage(&child, h) != RC_OK;
+		}
+		if (write(toParent[1], failed ? "f" : "k", 1) != 1 || read(toChild[0], &signal, 1) != 1)
+			_exit(1);
+		_exit(shutdownBufferPool(&child) == RC_OK ? 0 : 1);
+	}
+	ASSERT_TRUE(read(toParent[0], &signal, 1) == 1 && signal == 'k', "child pinned and wrote its pages");
+	ASSERT_EQUALS_INT(40, getNumReadIO(bm), "the statistics are shared");
+	ASSERT_TRUE(getNumDirtyPages(bm) > 0, "child pages are dirty in the pool");
+	TEST_CHECK(forceFlushPool(bm));
+	ASSERT_EQUALS_INT(0, getNumDirtyPages(bm), "the parent writes pages the child appended");
+	ASSERT_TRUE(write(toChild[1], "k", 1) == 1, "child told to shut down");
+	waitpid(pid, &status, 0);
+	ASSERT_TRUE(WIFEXITED(status) && WEXITSTATUS(status) == 0, "child shut down");
+	for (int i = 0; i < 40; i++)
+	{
+		TEST_CHECK(pinPage(bm, h, i));
+		sprintf(expected, "Page-%i", i);
+		ASSERT_EQUALS_STRING(expected, h->data, "parent sees the child's pages");
+		TEST_CHECK(unpinPage(bm, h));
+	}
+	TEST_CHECK(shutdownBufferPool(bm));
+	for (int i = 0; i < 40; i++)
+		ASSERT_TRUE(checkPageOnDisk(i), "page content written to disk");
+
+	// the last process removed the segment, so a new pool starts from scratch
+	TEST_CHECK(initSharedBufferPool(bm, PAGE_FILE_NAME, 4, RS_CLOCK, SEGMENT_NAME));
+	ASSERT_EQUALS_INT(0, getNumReadIO(bm), "fresh shared state");
+
+	// a process killed in the middle of pinning, often while it reads a page into a frame,
+	// does not block the others: pins of that page and victim searches give up its read
+	alarm(30);
+	for (int round = 0; round < 5; round++)
+	{
+		pid = fork();
+		if (pid == 0)
+		{
+			BM_BufferPool child;
+			if (initSharedBufferPool(&child, PAGE_FILE_NAME, 4, RS_CLOCK, SEGMENT_NAME) != RC_OK)
+				_exit(1);
+			if (write(toParent[1], "k", 1) != 1)
+				_exit(1);
+			for (int i = 0; true; i = (i + 1) % 40)
+			{
+				pinPage(&child, h, i);
+				unpinPage(&child, h);
+			}
+		}
+		ASSERT_TRUE(read(toParent[0], &signal, 1) == 1, "child attached");
+		usleep(20000 + round * 3000);
+		kill(pid, SIGKILL);
+		waitpid(pid, &status, 0);
+		int errors = 0;
+		for (int i = 0; i < 40; i++)
+		{
+			TEST_CHECK(pinPage(bm, h, i));
+			sprintf(expected, "Page-%i", i);
+			errors += strcmp(expected, h->data) != 0;
+			TEST_CHECK(unpinPage(bm, h));
+		}
+		ASSERT_EQUALS_INT(0, errors, "pool usable after the child was killed");
+	}
+	alarm(0);
+	TEST_CHECK(shutdownBufferPool(bm));
+	// the killed process never detached, so the segment is left behind
+	shm_unlink(SEGMENT_NAME);
+
+	close(toChild[0]);
+	close(toChild[1]);
+	close(toParent[0]);
+	close(toParent[1]);
+	TEST_CHECK(destroyPageFile(PAGE_FILE_NAME));
+	free(bm);
+	free(h);
+	TEST_DONE();
+}
@@ -77,7 +77,7 @@ main (void)
 {
 	testName = "";
 
-	//testInsertManyRecords(); <- FIXME
+	testInsertManyRecords();
 	testRecords();
 	testCreateTableAndInsert();
 	testUpdateTable();
@@ -0,0 +1,1290 @@
+#include <stdlib.h>
+#include "buffer_mgr.h"
+#include "dberror.h"
+#include "expr.h"
+#include "record_mgr.h"
+#include "storage_mgr.h"
+#include "tables.h"
+#include "test_helper.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+#define PAGE_FILE_NAME "testrecords.bin"
+#define TABLE_NAME "table"
+
+// test name
+char *testName;
+
+// the record manager's buffer pool, to count the pages a scan reads
+extern BM_BufferPool bufferPool;
+
+// test methods
+static void testFreeSpaceReuse (void);
+static void testSlotBitmap (void);
+static void testBulkLoad (void);
+static void testBatchedGets (void);
+static void testScans (void);
+static void testBorrowedRecords (void);
+static void testVariableLength (void);
+static void testPageReclamation (void);
+static void testPaxLayout (void);
+static void testColumnLayout (void);
+static void testTypedAccessors (void);
+static void testManyTables (void);
+static void testCheckpoints (void);
+static void testCatalogFormat (void);
+
+// helper methods
+static Schema *makeSchema (int numAttr, char **names, DataType *dataTypes, int *typeLengths);
+static Schema *testSchema (void);
+static void setTestRecord (Record *record, Schema *schema, int a);
+static int checkTestRecord (Record *record, Schema *schema, int a);
+static int testKey (Record *record, Schema *schema);
+static void setKeyString (Record *record, Schema *schema, int a, char *b);
+static Expr *smallerThan (int attrNum, int value);
+static void startTest (RM_TableData *table, Schema *schema);
+static void finishTest (RM_TableData *table, Schema *schema);
+static void checkLayout (RM_TableLayout layout);
+
+// main method
+int
+main (void)
+{
+	testName = "";
+
+	testFreeSpaceReuse();
+	testSlotBitmap();
+	testBulkLoad();
+	testBatchedGets();
+	testScans();
+	testBorrowedRecords();
+	testVariableLength();
+	testPageReclamation();
+	testPaxLayout();
+	testColumnLayout();
+	testTypedAccessors();
+	testManyTables();
+	testCheckpoints();
+	testCatalogFormat();
+
+	return 0;
+}
+
+// ************************************************************
+// a schema keyed on its first attribute, built on copies of the arrays (the schema keeps them)
+Schema *
+makeSchema (int numAttr, char **names, DataType *dataTypes, int *typeLengths)
+{
+	char **cpNames = (char **) malloc(sizeof(char*) * numAttr);
+	DataType *cpDt = (DataType *) malloc(sizeof(DataType) * numAttr);
+	int *cpSizes = (int *) malloc(sizeof(int) * numAttr);
+	int *cpKeys = (int *) malloc(sizeof(int));
+
+	for (int i = 0; i < numAttr; i++)
+	{
+		cpNames[i] = (char *) malloc(strlen(names[i]) + 1);
+		strcpy(cpNames[i], names[i]);
+	}
+	memcpy(cpDt, dataTypes, sizeof(DataType) * numAttr);
+	memcpy(cpSizes, typeLengths, sizeof(int) * numAttr);
+	cpKeys[0] = 0;
+
+	return createSchema(numAttr, cpNames, cpDt, cpSizes, 1, cpKeys);
+}
+
+// schema (a int, b string of 4, c int)
+Schema *
+testSchema (void)
+{
+	char *names[] = { "a", "b", "c" };
+	DataType dataTypes[] = { DT_INT, DT_STRING, DT_INT };
+	int typeLengths[] = { 0, 4, 0 };
+
+	return makeSchema(3, names, dataTypes, typeLengths);
+}
+
+// fill a record of testSchema from a: (a, "s<a % 1000>", -a)
+void
+setTestRecord (Record *record, Schema *schema, int a)
+{
+	char b[8];
+
+	Value *value;
+
+	sprintf(b, "s%i", abs(a) % 1000);
+	MAKE_VALUE(value, DT_INT, a);
+	setAttr(record, schema, 0, value);
+	freeVal(value);
+	MAKE_STRING_VALUE(value, b);
+	setAttr(record, schema, 1, value);
+	freeVal(value);
+	MAKE_VALUE(value, DT_INT, -a);
+	setAttr(record, schema, 2, value);
+	freeVal(value);
+}
+
+// returns 1 if the record is the one setTestRecord made from a
+int
+checkTestRecord (Record *record, Schema *schema, int a)
+{
+	char b[8];
+
+	Value *value;
+	int matches;
+
+	sprintf(b, "s%i", abs(a) % 1000);
+	getAttr(record, schema, 0, &value);
+	matches = value->v.intV == a;
+	freeVal(value);
+	getAttr(record, schema, 1, &value);
+	matches = matches && strcmp(value->v.stringV, b) == 0;
+	freeVal(value);
+	getAttr(record, schema, 2, &value);
+	matches = matches && value->v.intV == -a;
+	freeVal(value);
+	return matches;
+}
+
+// the condition attrNum < value on an int attribute
+Expr *
+smallerThan (int attrNum, int value)
+{
+	Expr *left, *right, *cond;
+	char constant[16];
+
+	sprintf(constant, "i%i", value);
+	MAKE_ATTRREF(left, attrNum);
+	MAKE_CONS(right, stringToValue(constant));
+	MAKE_BINOP_EXPR(cond, left, right, OP_COMP_SMALLER);
+	return cond;
+}
+
+// returns a of a record of testSchema
+int
+testKey (Record *record, Schema *schema)
+{
+	Value *value;
+	int a;
+
+	getAttr(record, schema, 0, &value);
+	a = value->v.intV;
+	freeVal(value);
+	return a;
+}
+
+// fill a record of a schema (a int, b string)
+void
+setKeyString (Record *record, Schema *schema, int a, char *b)
+{
+	Value *value;
+
+	MAKE_VALUE(value, DT_INT, a);
+	setAttr(record, schema, 0, value);
+	freeVal(value);
+	MAKE_STRING_VALUE(value, b);
+	setAttr(record, schema, 1, value);
+	freeVal(value);
+}
+
+// start the record manager on a fresh page file and open a new table of schema
+void
+startTest (RM_TableData *table, Schema *schema)
+{
+	remove(PAGE_FILE_NAME);
+	TEST_CHECK(initRecordManager(PAGE_FILE_NAME));
+	TEST_CHECK(createTable(TABLE_NAME, schema));
+	TEST_CHECK(openTable(table, TABLE_NAME));
+}
+
+// close and drop the table, stop the record manager and remove its page file
+void
+finishTest (RM_TableData *table, Schema *schema)
+{
+	TEST_CHECK(closeTable(table));
+	TEST_CHECK(deleteTable(TABLE_NAME));
+	TEST_CHECK(shutdownRecordManager());
+	TEST_CHECK(freeSchema(schema));
+	remove(PAGE_FILE_NAME);
+}
+
+// run the record operations on a table of testSchema with the given layout
+void
+checkLayout (RM_TableLayout layout)
+{
+	RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+	RM_BulkLoadHandle loader;
+	RM_ScanHandle scan;
+	Schema *schema = testSchema();
+	Expr *cond = smallerThan(0, 1000);
+	RID *rids = (RID *) malloc(sizeof(RID) * 3000);
+	Record *records[3];
+	Record borrowed;
+	Record *r;
+	Value *value;
+	int projected[] = { 2 };
+	int count = 0;
+	int errors = 0;
+
+	TEST_CHECK(createRecord(&r, schema));
+	for (int i = 0; i < 3; i++)
+		TEST_CHECK(createRecord(&records[i], schema));
+	remove(PAGE_FILE_NAME);
+	TEST_CHECK(initRecordManager(PAGE_FILE_NAME));
+	ASSERT_ERROR(createTableWithLayout(TABLE_NAME, schema, (RM_TableLayout) 7), "unknown layout");
+	TEST_CHECK(createTableWithLayout(TABLE_NAME, schema, layout));
+	TEST_CHECK(openTable(table, TABLE_NAME));
+
+	// inserts, updates and deletes
+	for (int i = 0; i < 3000; i++)
+	{
+		setTestRecord(r, schema, i);
+		TEST_CHECK(insertRecord(table, r));
+		rids[i] = r->id;
+	}
+	for (int i = 0; i < 3000; i++)
+	{
+		TEST_CHECK(getRecord(table, rids[i], r));
+		errors += !checkTestRecord(r, schema, i);
+	}
+	ASSERT_EQUALS_INT(0, errors, "every record read back");
+	for (int i = 0; i < 3000; i += 3)
+	{
+		setTestRecord(r, schema, 10000 + i);
+		r->id = rids[i];
+		TEST_CHECK(updateRecord(table, r));
+	}
+	for (int i = 1; i < 3000; i += 3)
+		TEST_CHECK(deleteRecord(table, rids[i]));
+	ASSERT_EQUALS_INT(2000, getNumTuples(table), "a third deleted");
+
+	// scans see the records left, a projected scan fills the attributes asked for
+	TEST_CHECK(startScan(table, &scan, cond));
+	while (next(&scan, r) == RC_OK)
+	{
+		int a = testKey(r, schema);
+		errors += a >= 1000 || a % 3 != 2 || !checkTestRecord(r, schema, a);
+		count++;
+	}
+	TEST_CHECK(closeScan(&scan));
+	ASSERT_EQUALS_INT(333, count, "matching records scanned");
+	count = 0;
+	TEST_CHECK(startProjectedScan(table, &scan, cond, 1, projected));
+	while (next(&scan, r) == RC_OK)
+	{
+		getAttr(r, schema, 2, &value);
+		errors += value->v.intV != -testKey(r, schema);
+		freeVal(value);
+		count++;
+	}
+	TEST_CHECK(closeScan(&scan));
+	ASSERT_EQUALS_INT(333, count, "matching records projected");
+	ASSERT_EQUALS_INT(0, errors, "scanned records intact");
+
+	// lookups by id
+	RID ids[] = { rids[5], rids[3], rids[2] };
+	TEST_CHECK(getRecords(table, ids, 3, records));
+	ASSERT_TRUE(checkTestRecord(records[0], schema, 5) && checkTestRecord(records[1], schema, 10003) &&
+		checkTestRecord(records[2], schema, 2), "batch read");
+	TEST_CHECK(borrowRecord(table, rids[8], &borrowed));
+	ASSERT_TRUE(checkTestRecord(&borrowed, schema, 8), "borrowed record");
+	TEST_CHECK(releaseRecord(table, &borrowed));
+
+	// bulk loads and a restart
+	TEST_CHECK(startBulkLoad(table, &loader));
+	for (int i = 0; i < 1000; i++)
+	{
+		setTestRecord(r, schema, 20000 + i);
+		TEST_CHECK(loadRecord(&loader, r));
+	}
+	TEST_CHECK(finishBulkLoad(&loader));
+	TEST_CHECK(closeTable(table));
+	TEST_CHECK(shutdownRecordManager());
+	TEST_CHECK(initRecordManager(PAGE_FILE_NAME));
+	TEST_CHECK(openTable(table, TABLE_NAME));
+	ASSERT_EQUALS_INT(3000, getNumTuples(table), "tuple count kept");
+	TEST_CHECK(getRecord(table, rids[2999], r));
+	ASSERT_TRUE(checkTestRecord(r, schema, 2999), "record kept");
+	count = 0;
+	TEST_CHECK(startScan(table, &scan, NULL));
+	while (next(&scan, r) == RC_OK)
+		count++;
+	TEST_CHECK(closeScan(&scan));
+	ASSERT_EQUALS_INT(3000, count, "every record scanned after the restart");
+
+	finishTest(table, schema);
+	for (int i = 0; i < 3; i++)
+		freeRecord(records[i]);
+	freeRecord(r);
+	freeExpr(cond);
+	free(rids);
+	free(table);
+}
+
+// ************************************************************
+void
+testFreeSpaceReuse (void)
+{
+	RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+	Schema *schema = testSchema();
+	Record *r;
+	RID *rids = (RID *) malloc(sizeof(RID) * 3000);
+	int errors = 0;
+	testName = "test inserts reusing freed slots";
+
+	TEST_CHECK(createRecord(&r, schema));
+	startTest(table, schema);
+	for (int i = 0; i < 3000; i++)
+	{
+		setTestRecord(r, schema, i);
+		TEST_CHECK(insertRecord(table, r));
+		rids[i] = r->id;
+	}
+	int numPages = getNumPages();
+
+	// the slots freed all over the table are filled again before the table grows
+	for (int i = 0; i < 3000; i += 3)
+		TEST_CHECK(deleteRecord(table, rids[i]));
+	ASSERT_EQUALS_INT(2000, getNumTuples(table), "a third of the records deleted");
+	for (int i = 0; i < 1000; i++)
+	{
+		setTestRecord(r, schema, 10000 + i);
+		TEST_CHECK(insertRecord(table, r));
+	}
+	ASSERT_EQUALS_INT(numPages, getNumPages(), "reinserts take the freed slots");
+	ASSERT_EQUALS_INT(3000, getNumTuples(table), "every record inserted");
+	for (int i = 1; i < 3000; i += 3)
+	{
+		TEST_CHECK(getRecord(table, rids[i], r));
+		errors += !checkTestRecord(r, schema, i);
+	}
+	ASSERT_EQUALS_INT(0, errors, "the records left in place are unchanged");
+
+	// the list of pages with room survives a restart
+	for (int i = 1; i < 3000; i += 3)
+		TEST_CHECK(deleteRecord(table, rids[i]));
+	TEST_CHECK(closeTable(table));
+	TEST_CHECK(shutdownRecordManager());
+	TEST_CHECK(initRecordManager(PAGE_FILE_NAME));
+	TEST_CHECK(openTable(table, TABLE_NAME));
+	ASSERT_EQUALS_INT(2000, getNumTuples(table), "tuple count kept");
+	for (int i = 0; i < 1000; i++)
+	{
+		setTestRecord(r, schema, 20000 + i);
+		TEST_CHECK(insertRecord(table, r));
+	}
+	ASSERT_EQUALS_INT(numPages, getNumPages(), "reinserts after a restart take the freed slots");
+
+	finishTest(table, schema);
+	freeRecord(r);
+	free(rids);
+	free(table);
+	TEST_DONE();
+}
+
+// ************************************************************
+void
+testSlotBitmap (void)
+{
+	RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+	Schema *schema = testSchema();
+	Record *r;
+	RID rids[500];
+	int freed[] = { 130, 70, 3 };
+	testName = "test the slot bitmap of a page";
+
+	TEST_CHECK(createRecord(&r, schema));
+	startTest(table, schema);
+	for (int i = 0; i < 500; i++)
+	{
+		setTestRecord(r, schema, i);
+		TEST_CHECK(insertRecord(table, r));
+		rids[i] = r->id;
+	}
+	ASSERT_EQUALS_INT(rids[0].page, rids[130].page, "the first 131 records share a page");
+	ASSERT_EQUALS_INT(130, rids[130].slot - rids[0].slot, "in consecutive slots");
+
+	// freed slots in different words of the bitmap are found lowest first
+	for (int i = 0; i < 3; i++)
+		TEST_CHECK(deleteRecord(table, rids[freed[i]]));
+	ASSERT_ERROR(getRecord(table, rids[70], r), "a deleted slot holds no record");
+	ASSERT_ERROR(deleteRecord(table, rids[70]), "a slot is only deleted once");
+	for (int i = 2; i >= 0; i--)
+	{
+		setTestRecord(r, schema, -freed[i]);
+		TEST_CHECK(insertRecord(table, r));
+		ASSERT_EQUALS_INT(rids[freed[i]].page, r->id.page, "insert goes to the page with free slots");
+		ASSERT_EQUALS_INT(rids[freed[i]].slot, r->id.slot, "insert takes the lowest free slot");
+	}
+	for (int i = 0; i < 3; i++)
+	{
+		TEST_CHECK(getRecord(table, rids[freed[i]], r));
+		ASSERT_TRUE(checkTestRecord(r, schema, -freed[i]), "new record in the freed slot");
+	}
+	TEST_CHECK(getRecord(table, rids[71], r));
+	ASSERT_TRUE(checkTestRecord(r, schema, 71), "neighbouring slot unchanged");
+
+	finishTest(table, schema);
+	freeRecord(r);
+	free(table);
+	TEST_DONE();
+}
+
+// ************************************************************
+void
+testBulkLoad (void)
+{
+	RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+	RM_BulkLoadHandle loader;
+	Schema *schema = testSchema();
+	Record **records = (Record **) malloc(sizeof(Record *) * 5000);
+	RID *rids = (RID *) malloc(sizeof(RID) * 5000);
+	Record *r;
+	int errors = 0;
+	testName = "test bulk loading records onto fresh pages";
+
+	for (int i = 0; i < 5000; i++)
+	{
+		TEST_CHECK(createRecord(&records[i], schema));
+		setTestRecord(records[i], schema, i);
+	}
+	TEST_CHECK(createRecord(&r, schema));
+	startTest(table, schema);
+	setTestRecord(r, schema, -1);
+	TEST_CHECK(insertRecord(table, r));
+
+	// the page with room on the free-space list is filled first, the rest of the records
+	// fill whole fresh pages in order, only the last one has room left
+	int numPages = getNumPages();
+	TEST_CHECK(insertRecords(table, records, 5000, rids));
+	ASSERT_EQUALS_INT(r->id.page, rids[0].page, "first record goes to the page with room");
+	ASSERT_EQUALS_INT(r->id.slot + 1, rids[0].slot, "next to the record inserted before");
+	int loadedPages = 1;
+	for (int i = 1; i < 5000; i++)
+	{
+		if (rids[i].page != rids[i - 1].page)
+		{
+			loadedPages++;
+			errors += rids[i].slot != 0;
+		}
+		else
+			errors += rids[i].slot != rids[i - 1].slot + 1;
+	}
+	ASSERT_EQUALS_INT(0, errors, "records placed in consecutive slots");
+	ASSERT_EQUALS_INT(numPages + loadedPages - 1, getNumPages(), "one new page per page of records");
+	ASSERT_TRUE(loadedPages <= 5000 / (PAGE_SIZE / 32), "pages filled up");
+	ASSERT_EQUALS_INT(5001, getNumTuples(table), "every record counted");
+
+	// a loader keeps going where the caller left off
+	TEST_CHECK(startBulkLoad(table, &loader));
+	for (int i = 0; i < 1000; i++)
+	{
+		setTestRecord(r, schema, 5000 + i);
+		TEST_CHECK(loadRecord(&loader, r));
+	}
+	TEST_CHECK(finishBulkLoad(&loader));
+	ASSERT_EQUALS_INT(6001, getNumTuples(table), "loaded records counted");
+
+	// the loaded records survive a restart
+	TEST_CHECK(closeTable(table));
+	TEST_CHECK(shutdownRecordManager());
+	TEST_CHECK(initRecordManager(PAGE_FILE_NAME));
+	TEST_CHECK(openTable(table, TABLE_NAME));
+	ASSERT_EQUALS_INT(6001, getNumTuples(table), "tuple count kept");
+	for (int i = 0; i < 5000; i++)
+	{
+		TEST_CHECK(getRecord(table, rids[i], r));
+		errors += !checkTestRecord(r, schema, i);
+	}
+	ASSERT_EQUALS_INT(0, errors, "every bulk record read back");
+
+	// a slot freed on a loaded page is reused
+	numPages = getNumPages();
+	TEST_CHECK(deleteRecord(table, rids[2500]));
+	setTestRecord(r, schema, -2);
+	TEST_CHECK(insertRecord(table, r));
+	ASSERT_EQUALS_INT(numPages, getNumPages(), "the freed slot was taken");
+
+	// a batch that fits in the free space does not grow the table
+	for (int i = 1000; i < 1100; i++)
+		TEST_CHECK(deleteRecord(table, rids[i]));
+	TEST_CHECK(insertRecords(table, records + 1000, 100, rids + 1000));
+	ASSERT_EQUALS_INT(numPages, getNumPages(), "the batch went into freed slots");
+	for (int i = 1000; i < 1100; i++)
+	{
+		TEST_CHECK(getRecord(table, rids[i], r));
+		errors += !checkTestRecord(r, schema, i);
+	}
+	ASSERT_EQUALS_INT(0, errors, "every record of the batch read back");
+
+	finishTest(table, schema);
+	for (int i = 0; i < 5000; i++)
+		freeRecord(records[i]);
+	freeRecord(r);
+	free(records);
+	free(rids);
+	free(table);
+	TEST_DONE();
+}
+
+// ************************************************************
+void
+testBatchedGets (void)
+{
+	RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+	Schema *schema = testSchema();
+	RID *rids = (RID *) malloc(sizeof(RID) * 3000);
+	RID wanted[500];
+	int expected[500];
+	Record *records[500];
+	Record *r;
+	int errors = 0;
+	testName = "test reading a batch of records by id";
+
+	TEST_CHECK(createRecord(&r, schema));
+	for (int i = 0; i < 500; i++)
+		TEST_CHECK(createRecord(&records[i], schema));
+	startTest(table, schema);
+	for (int i = 0; i < 3000; i++)
+	{
+		setTestRecord(r, schema, i);
+		TEST_CHECK(insertRecord(table, r));
+		rids[i] = r->id;
+	}
+
+	// ids in random order over many pages (some asked for twice) come back in the order asked
+	srand(41);
+	for (int i = 0; i < 500; i++)
+	{
+		expected[i] = rand() % 3000;
+		wanted[i] = rids[expected[i]];
+	}
+	TEST_CHECK(getRecords(table, wanted, 500, records));
+	for (int i = 0; i < 500; i++)
+		errors += !checkTestRecord(records[i], schema, expected[i]) || records[i]->id.page != wanted[i].page ||
+			records[i]->id.slot != wanted[i].slot;
+	ASSERT_EQUALS_INT(0, errors, "every record read into its place");
+
+	// a deleted record fails the batch but the others are still read
+	TEST_CHECK(deleteRecord(table, wanted[7]));
+	for (int i = 0; i < 500; i++)
+		setTestRecord(records[i], schema, -1);
+	ASSERT_ERROR(getRecords(table, wanted, 500, records), "batch with a deleted record");
+	for (int i = 0; i < 500; i++)
+		errors += expected[i] != expected[7] && !checkTestRecord(records[i], schema, expected[i]);
+	ASSERT_EQUALS_INT(0, errors, "the other records read");
+	TEST_CHECK(getRecords(table, wanted, 0, records));
+
+	finishTest(table, schema);
+	for (int i = 0; i < 500; i++)
+		freeRecord(records[i]);
+	freeRecord(r);
+	free(rids);
+	free(table);
+	TEST_DONE();
+}
+
+// ************************************************************
+void
+testScans (void)
+{
+	RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+	RM_ScanHandle scan;
+	Schema *schema = testSchema();
+	Expr *cond = smallerThan(0, 1000);
+	Record *batch[64];
+	Record *r;
+	int count = 0;
+	int errors = 0;
+	int numRecords;
+	long sum = 0;
+	RC rc;
+	testName = "test scans over many pages";
+
+	TEST_CHECK(createRecord(&r, schema));
+	for (int i = 0; i < 64; i++)
+		TEST_CHECK(createRecord(&batch[i], schema));
+	startTest(table, schema);
+	for (int i = 0; i < 3000; i++)
+	{
+		setTestRecord(r, schema, i);
+		TEST_CHECK(insertRecord(table, r));
+	}
+
+	// a full scan sees every record once
+	TEST_CHECK(startScan(table, &scan, NULL));
+	while ((rc = next(&scan, r)) == RC_OK)
+	{
+		count++;
+		sum += testKey(r, schema);
+		errors += !checkTestRecord(r, schema, testKey(r, schema));
+	}
+	ASSERT_EQUALS_INT(RC_RM_NO_MORE_TUPLES, rc, "scan ran to the end");
+	TEST_CHECK(closeScan(&scan));
+	ASSERT_EQUALS_INT(3000, count, "every record scanned");
+	ASSERT_TRUE(sum == 2999L * 3000 / 2, "each record once");
+	ASSERT_EQUALS_INT(0, errors, "scanned records intact");
+
+	// batches only hold matching records and the end is an empty batch
+	count = 0;
+	TEST_CHECK(startScan(table, &scan, cond));
+	while ((rc = nextBatch(&scan, batch, 64, &numRecords)) == RC_OK)
+	{
+		errors += numRecords < 1 || numRecords > 64;
+		for (int i = 0; i < numRecords; i++)
+			errors += testKey(batch[i], schema) >= 1000;
+		count += numRecords;
+	}
+	ASSERT_EQUALS_INT(RC_RM_NO_MORE_TUPLES, rc, "batches ran to the end");
+	ASSERT_EQUALS_INT(0, numRecords, "last batch empty");
+	TEST_CHECK(closeScan(&scan));
+	ASSERT_EQUALS_INT(1000, count, "every matching record returned");
+	ASSERT_EQUALS_INT(0, errors, "only matching records returned");
+
+	// a scan closed half way lets go of its page
+	TEST_CHECK(startScan(table, &scan, NULL));
+	for (int i = 0; i < 20; i++)
+		TEST_CHECK(nextBatch(&scan, batch, 64, &numRecords));
+	TEST_CHECK(closeScan(&scan));
+
+	finishTest(table, schema);
+	for (int i = 0; i < 64; i++)
+		freeRecord(batch[i]);
+	freeRecord(r);
+	freeExpr(cond);
+	free(table);
+	TEST_DONE();
+}
+
+// ************************************************************
+void
+testBorrowedRecords (void)
+{
+	RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+	RM_TableData *numbers = (RM_TableData *) malloc(sizeof(RM_TableData));
+	RM_ScanHandle scan;
+	Schema *schema = testSchema();
+	char *names[] = { "a", "b" };
+	DataType dataTypes[] = { DT_INT, DT_FLOAT };
+	int typeLengths[] = { 0, 0 };
+	Schema *numberSchema = makeSchema(2, names, dataTypes, typeLengths);
+	Expr *cond = smallerThan(0, 500);
+	RID *rids = (RID *) malloc(sizeof(RID) * 3000);
+	RID *numberRids = (RID *) malloc(sizeof(RID) * 3000);
+	Record borrowed[30];
+	Record *r, *n;
+	Value *value;
+	int count = 0;
+	int errors = 0;
+	testName = "test borrowing records without copies";
+
+	TEST_CHECK(createRecord(&r, schema));
+	TEST_CHECK(createRecord(&n, numberSchema));
+	startTest(table, schema);
+	TEST_CHECK(createTable("numbers", numberSchema));
+	TEST_CHECK(openTable(numbers, "numbers"));
+	for (int i = 0; i < 3000; i++)
+	{
+		setTestRecord(r, schema, i);
+		TEST_CHECK(insertRecord(table, r));
+		rids[i] = r->id;
+		MAKE_VALUE(value, DT_INT, i);
+		setAttr(n, numberSchema, 0, value);
+		freeVal(value);
+		MAKE_VALUE(value, DT_FLOAT, i / 2.0f);
+		setAttr(n, numberSchema, 1, value);
+		freeVal(value);
+		TEST_CHECK(insertRecord(numbers, n));
+		numberRids[i] = n->id;
+	}
+
+	// records with strings are lent as copies, many can be held at once
+	for (int i = 0; i < 30; i++)
+		TEST_CHECK(borrowRecord(table, rids[i * 100], &borrowed[i]));
+	for (int i = 0; i < 30; i++)
+	{
+		errors += i > 0 && borrowed[i].data == borrowed[i - 1].data;
+		errors += !checkTestRecord(&borrowed[i], schema, i * 100);
+		TEST_CHECK(releaseRecord(table, &borrowed[i]));
+	}
+	ASSERT_EQUALS_INT(0, errors, "copies hold the records");
+
+	// records without strings are lent where they lie in their pages
+	for (int i = 0; i < 30; i++)
+		TEST_CHECK(borrowRecord(numbers, numberRids[i * 100], &borrowed[i]));
+	for (int i = 0; i < 30; i++)
+	{
+		errors += testKey(&borrowed[i], numberSchema) != i * 100;
+		getAttr(&borrowed[i], numberSchema, 1, &value);
+		errors += value->v.floatV != i * 50.0f;
+		freeVal(value);
+	}
+	ASSERT_EQUALS_INT(0, errors, "borrowed records hold their values");
+	Record again;
+	TEST_CHECK(borrowRecord(numbers, numberRids[500], &again));
+	ASSERT_TRUE(again.data == borrowed[5].data, "both borrowers read the same bytes");
+	TEST_CHECK(releaseRecord(numbers, &again));
+	for (int i = 0; i < 30; i++)
+		TEST_CHECK(releaseRecord(numbers, &borrowed[i]));
+	TEST_CHECK(deleteRecord(numbers, numberRids[7]));
+	ASSERT_ERROR(borrowRecord(numbers, numberRids[7], &borrowed[0]), "a deleted record cannot be borrowed");
+
+	// a page emptied while one of its records is lent stays in the table until it is released
+	int lastPage = numberRids[2999].page;
+	int freePages = getNumFreePages();
+	TEST_CHECK(borrowRecord(numbers, numberRids[2999], &again));
+	for (int i = 0; i < 3000; i++)
+		if (numberRids[i].page == lastPage)
+			TEST_CHECK(deleteRecord(numbers, numberRids[i]));
+	ASSERT_EQUALS_INT(freePages, getNumFreePages(), "the borrowed record's page is kept");
+	ASSERT_EQUALS_INT(2999, testKey(&again, numberSchema), "the borrowed bytes are still there");
+	TEST_CHECK(releaseRecord(numbers, &again));
+	ASSERT_EQUALS_INT(freePages + 1, getNumFreePages(), "the page is given back on release");
+
+	// scans lend each matching record in turn
+	for (int t = 0; t < 2; t++)
+	{
+		RM_TableData *rel = (t == 0) ? table : numbers;
+		Schema *relSchema = (t == 0) ? schema : numberSchema;
+		count = 0;
+		TEST_CHECK(startScan(rel, &scan, cond));
+		while (nextBorrowed(&scan, &borrowed[0]) == RC_OK)
+		{
+			int a = testKey(&borrowed[0], relSchema);
+			errors += a >= 500 || (t == 0 && !checkTestRecord(&borrowed[0], schema, a));
+			count++;
+		}
+		TEST_CHECK(closeScan(&scan));
+		ASSERT_EQUALS_INT(t == 0 ? 500 : 499, count, "every matching record lent");
+	}
+	ASSERT_EQUALS_INT(0, errors, "only matching records lent");
+
+	TEST_CHECK(closeTable(numbers));
+	TEST_CHECK(deleteTable("numbers"));
+	TEST_CHECK(freeSchema(numberSchema));
+	finishTest(table, schema);
+	freeRecord(r);
+	freeRecord(n);
+	freeExpr(cond);
+	free(rids);
+	free(numberRids);
+	free(numbers);
+	free(table);
+	TEST_DONE();
+}
+
+// ************************************************************
+void
+testVariableLength (void)
+{
+	RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+	RM_ScanHandle scan;
+	char *names[] = { "a", "b" };
+	DataType dataTypes[] = { DT_INT, DT_STRING };
+	int typeLengths[] = { 0, 255 };
+	Schema *schema = makeSchema(2, names, dataTypes, typeLengths);
+	RID *rids = (RID *) malloc(sizeof(RID) * 3000);
+	char *seen = (char *) calloc(3000, 1);
+	char big[256];
+	Record *r;
+	Value *value;
+	int count = 0;
+	int errors = 0;
+	testName = "test variable-length records on slotted pages";
+
+	memset(big, 'x', 255);
+	big[255] = '\0';
+	TEST_CHECK(createRecord(&r, schema));
+	startTest(table, schema);
+
+	// short strings only take the room they need
+	int numPages = getNumPages();
+	for (int i = 0; i < 3000; i++)
+	{
+		setKeyString(r, schema, i, "abc");
+		TEST_CHECK(insertRecord(table, r));
+		rids[i] = r->id;
+	}
+	ASSERT_TRUE(getNumPages() - numPages < 3000 / (PAGE_SIZE / getRecordSize(schema)), "fewer pages than fixed-size records");
+
+	// records that outgrow their full page are moved but keep their id
+	for (int i = 0; i < 3000; i += 3)
+	{
+		r->id = rids[i];
+		setKeyString(r, schema, i, big);
+		TEST_CHECK(updateRecord(table, r));
+	}
+	for (int i = 0; i < 3000; i += 6)
+	{
+		r->id = rids[i];
+		setKeyString(r, schema, i, "z");
+		TEST_CHECK(updateRecord(table, r));
+	}
+	for (int i = 0; i < 3000; i++)
+	{
+		const char *expected = (i % 6 == 0) ? "z" : ((i % 3 == 0) ? big : "abc");
+		TEST_CHECK(getRecord(table, rids[i], r));
+		getAttr(r, schema, 1, &value);
+		errors += testKey(r, schema) != i || strcmp(value->v.stringV, expected) != 0 ||
+			r->id.page != rids[i].page || r->id.slot != rids[i].slot;
+		freeVal(value);
+	}
+	ASSERT_EQUALS_INT(0, errors, "every record has its value under its id");
+
+	// a scan returns moved records once, under their own id
+	TEST_CHECK(startScan(table, &scan, NULL));
+	while (next(&scan, r) == RC_OK)
+	{
+		int a = testKey(r, schema);
+		if (a < 0 || a >= 3000 || seen[a])
+		{
+			errors++;
+			continue;
+		}
+		errors += r->id.page != rids[a].page || r->id.slot != rids[a].slot;
+		seen[a] = 1;
+		count++;
+	}
+	TEST_CHECK(closeScan(&scan));
+	ASSERT_EQUALS_INT(3000, count, "every record scanned");
+	ASSERT_EQUALS_INT(0, errors, "each once under its id");
+
+	// deleting a moved record frees both its places
+	for (int i = 3; i < 3000; i += 6)
+		TEST_CHECK(deleteRecord(table, rids[i]));
+	ASSERT_EQUALS_INT(2500, getNumTuples(table), "moved records deleted");
+	numPages = getNumPages();
+	for (int i = 3; i < 3000; i += 6)
+	{
+		setKeyString(r, schema, i, big);
+		TEST_CHECK(insertRecord(table, r));
+	}
+	ASSERT_EQUALS_INT(numPages, getNumPages(), "their room was reused");
+
+	finishTest(table, schema);
+	freeRecord(r);
+	free(rids);
+	free(seen);
+	free(table);
+	TEST_DONE();
+}
+
+// ************************************************************
+void
+testPageReclamation (void)
+{
+	RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+	RM_ScanHandle scan;
+	Schema *schema = testSchema();
+	RID *rids = (RID *) malloc(sizeof(RID) * 3000);
+	Record *r;
+	testName = "test giving empty pages back to the free list";
+
+	TEST_CHECK(createRecord(&r, schema));
+	startTest(table, schema);
+	for (int i = 0; i < 3000; i++)
+	{
+		setTestRecord(r, schema, i);
+		TEST_CHECK(insertRecord(table, r));
+		rids[i] = r->id;
+	}
+	int numPages = getNumPages();
+	int numFreePages = getNumFreePages();
+
+	// the overflow pages emptied by the first half of the deletes are given back right away
+	// (the first page is the table's main page and is kept)
+	int emptied = 0;
+	for (int i = 1; i < 1500; i++)
+		emptied += rids[i].page != rids[0].page && rids[i].page != rids[i - 1].page && rids[i].page != rids[1500].page;
+	for (int i = 0; i < 1500; i++)
+		TEST_CHECK(deleteRecord(table, rids[i]));
+	ASSERT_TRUE(emptied > 0, "some pages emptied");
+	ASSERT_EQUALS_INT(numFreePages + emptied, getNumFreePages(), "emptied pages are free");
+
+	// pages emptied under an open scan are kept until the scan closes
+	numFreePages = getNumFreePages();
+	TEST_CHECK(startScan(table, &scan, NULL));
+	for (int i = 1500; i < 3000; i++)
+		TEST_CHECK(deleteRecord(table, rids[i]));
+	ASSERT_EQUALS_INT(numFreePages, getNumFreePages(), "no page given back under the scan");
+	ASSERT_ERROR(vacuumTable(table), "no vacuum under a scan");
+	TEST_CHECK(closeScan(&scan));
+	ASSERT_TRUE(getNumFreePages() > numFreePages, "closing the scan gave them back");
+	ASSERT_EQUALS_INT(0, getNumTuples(table), "table empty");
+	TEST_CHECK(vacuumTable(table));
+
+	// the file does not grow while there are free pages
+	for (int i = 0; i < 3000; i++)
+	{
+		setTestRecord(r, schema, i);
+		TEST_CHECK(insertRecord(table, r));
+	}
+	ASSERT_EQUALS_INT(numPages, getNumPages(), "free pages reused");
+
+	finishTest(table, schema);
+	freeRecord(r);
+	free(rids);
+	free(table);
+	TEST_DONE();
+}
+
+// ************************************************************
+void
+testPaxLayout (void)
+{
+	testName = "test tables with the PAX layout";
+
+	checkLayout(RM_LAYOUT_PAX);
+
+	TEST_DONE();
+}
+
+// ************************************************************
+void
+testColumnLayout (void)
+{
+	RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+	RM_ScanHandle scan;
+	char *names[] = { "a", "b", "c" };
+	DataType dataTypes[] = { DT_INT, DT_STRING, DT_STRING };
+	int typeLengths[] = { 0, 200, 200 };
+	Schema *schema = makeSchema(3, names, dataTypes, typeLengths);
+	RID *rids = (RID *) malloc(sizeof(RID) * 3000);
+	int projected[] = { 0 };
+	char value[201];
+	Record *r;
+	Value *attr;
+	int count = 0;
+	long sum = 0;
+	testName = "test tables with the column layout";
+
+	checkLayout(RM_LAYOUT_COLUMN);
+
+	// a table with wide columns
+	TEST_CHECK(createRecord(&r, schema));
+	remove(PAGE_FILE_NAME);
+	TEST_CHECK(initRecordManager(PAGE_FILE_NAME));
+	TEST_CHECK(createTableWithLayout(TABLE_NAME, schema, RM_LAYOUT_COLUMN));
+	TEST_CHECK(openTable(table, TABLE_NAME));
+	memset(value, 'x', 200);
+	value[200] = '\0';
+	for (int i = 0; i < 3000; i++)
+	{
+		setKeyString(r, schema, i, value);
+		MAKE_STRING_VALUE(attr, value);
+		setAttr(r, schema, 2, attr);
+		freeVal(attr);
+		TEST_CHECK(insertRecord(table, r));
+		rids[i] = r->id;
+	}
+	TEST_CHECK(closeTable(table));
+	TEST_CHECK(shutdownRecordManager());
+	TEST_CHECK(initRecordManager(PAGE_FILE_NAME));
+	TEST_CHECK(openTable(table, TABLE_NAME));
+
+	// a scan of the int column only reads that column's pages
+	int numReads = getNumReadIO(&bufferPool);
+	TEST_CHECK(startProjectedScan(table, &scan, NULL, 1, projected));
+	while (next(&scan, r) == RC_OK)
+		sum += testKey(r, schema);
+	TEST_CHECK(closeScan(&scan));
+	int projectedReads = getNumReadIO(&bufferPool) - numReads;
+	ASSERT_TRUE(sum == 2999L * 3000 / 2, "projected column read");
+	numReads = getNumReadIO(&bufferPool);
+	TEST_CHECK(startScan(table, &scan, NULL));
+	while (next(&scan, r) == RC_OK)
+	{
+		getAttr(r, schema, 2, &attr);
+		count += strcmp(attr->v.stringV, value) == 0;
+		freeVal(attr);
+	}
+	TEST_CHECK(closeScan(&scan));
+	ASSERT_EQUALS_INT(3000, count, "full records read");
+	ASSERT_TRUE(projectedReads * 10 < getNumReadIO(&bufferPool) - numReads, "projected scan read a fraction of the pages");
+
+	// deleting every record gives the column pages back
+	int numFreePages = getNumFreePages();
+	for (int i = 0; i < 3000; i++)
+		TEST_CHECK(deleteRecord(table, rids[i]));
+	ASSERT_TRUE(getNumFreePages() > numFreePages + 100, "column pages freed");
+
+	finishTest(table, schema);
+	freeRecord(r);
+	free(rids);
+	free(table);
+	TEST_DONE();
+}
+
+// ************************************************************
+void
+testTypedAccessors (void)
+{
+	RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+	char *names[] = { "s", "i", "f", "b" };
+	DataType dataTypes[] = { DT_STRING, DT_INT, DT_FLOAT, DT_BOOL };
+	int typeLengths[] = { 5, 0, 0, 0 };
+	Schema *schema = makeSchema(4, names, dataTypes, typeLengths);
+	Schema handMade;
+	int offsets[] = { 0, 6, 10, 14, 14 + (int) sizeof(bool) };
+	Record *r;
+	Value *value;
+	testName = "test attribute offsets and typed accessors";
+
+	// offsets follow the attribute sizes, strings take their length and a terminator
+	for (int i = 0; i <= 4; i++)
+		ASSERT_EQUALS_INT(offsets[i], getAttrOffset(schema, i), "attribute offset");
+	ASSERT_EQUALS_INT(offsets[4], getRecordSize(schema), "record size");
+
+	// typed accessors and getAttr/setAttr read and write the same bytes
+	TEST_CHECK(createRecord(&r, schema));
+	setAttrString(r, schema, 0, "abc");
+	setAttrInt(r, schema, 1, 42);
+	setAttrFloat(r, schema, 2, 1.5f);
+	setAttrBool(r, schema, 3, TRUE);
+	TEST_CHECK(getAttr(r, schema, 0, &value));
+	ASSERT_EQUALS_STRING("abc", value->v.stringV, "string set in place");
+	freeVal(value);
+	TEST_CHECK(getAttr(r, schema, 1, &value));
+	ASSERT_EQUALS_INT(42, value->v.intV, "int set in place");
+	freeVal(value);
+	TEST_CHECK(getAttr(r, schema, 2, &value));
+	ASSERT_TRUE(value->v.floatV == 1.5f, "float set in place");
+	freeVal(value);
+	TEST_CHECK(getAttr(r, schema, 3, &value));
+	ASSERT_TRUE(value->v.boolV, "bool set in place");
+	freeVal(value);
+	MAKE_VALUE(value, DT_INT, 7);
+	TEST_CHECK(setAttr(r, schema, 1, value));
+	freeVal(value);
+	ASSERT_EQUALS_INT(7, getAttrInt(r, schema, 1), "int read in place");
+	ASSERT_EQUALS_STRING("abc", getAttrStringRef(r, schema, 0), "string read in place");
+	ASSERT_TRUE(getAttrFloat(r, schema, 2) == 1.5f && getAttrBool(r, schema, 3), "float and bool read in place");
+
+	// a schema the caller owns gets the same offsets from initSchema
+	TEST_CHECK(initSchema(&handMade, 4, names, dataTypes, typeLengths, 0, NULL));
+	for (int i = 0; i <= 4; i++)
+		ASSERT_EQUALS_INT(offsets[i], getAttrOffset(&handMade, i), "offset of the initialised schema");
+	ASSERT_EQUALS_INT(7, getAttrInt(r, &handMade, 1), "int read with the initialised schema");
+	ASSERT_TRUE(getAttrFloat(r, &handMade, 2) == 1.5f && getAttrBool(r, &handMade, 3), "float and bool read with the initialised schema");
+	TEST_CHECK(clearSchema(&handMade));
+
+	// one filled in field by field without offsets reads the record the same way
+	handMade = *schema;
+	handMade.attrOffsets = NULL;
+	for (int i = 0; i <= 4; i++)
+		ASSERT_EQUALS_INT(offsets[i], getAttrOffset(&handMade, i), "offset added up");
+	ASSERT_EQUALS_INT(7, getAttrInt(r, &handMade, 1), "int read without offsets");
+
+	// an opened table's schema has the same layout
+	startTest(table, schema);
+	for (int i = 0; i <= 4; i++)
+		ASSERT_EQUALS_INT(offsets[i], getAttrOffset(table->schema, i), "offset of the opened schema");
+	TEST_CHECK(insertRecord(table, r));
+	setAttrInt(r, schema, 1, 0);
+	TEST_CHECK(getRecord(table, r->id, r));
+	ASSERT_EQUALS_INT(7, getAttrInt(r, table->schema, 1), "record stored and read back");
+
+	finishTest(table, schema);
+	freeRecord(r);
+	free(table);
+	TEST_DONE();
+}
+
+// ************************************************************
+void
+testManyTables (void)
+{
+	RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+	RM_TableData other;
+	RM_ScanHandle scan;
+	Schema *schema = testSchema();
+	Record *r;
+	char name[16];
+	int errors = 0;
+	testName = "test a catalog of many tables";
+
+	// more tables than one catalog page holds
+	TEST_CHECK(createRecord(&r, schema));
+	remove(PAGE_FILE_NAME);
+	TEST_CHECK(initRecordManager(PAGE_FILE_NAME));
+	for (int i = 0; i < 2000; i++)
+	{
+		sprintf(name, "t%i", i);
+		errors += createTable(name, schema) != RC_OK;
+	}
+	ASSERT_EQUALS_INT(0, errors, "every table created");
+	ASSERT_EQUALS_INT(2000, getNumTables(), "every table counted");
+	ASSERT_ERROR(createTable("t5", schema), "names are unique");
+	for (int i = 0; i < 2000; i += 7)
+	{
+		sprintf(name, "t%i", i);
+		TEST_CHECK(openTable(table, name));
+		setTestRecord(r, schema, i);
+		TEST_CHECK(insertRecord(table, r));
+		TEST_CHECK(closeTable(table));
+	}
+
+	// deletes and new names after a restart
+	TEST_CHECK(shutdownRecordManager());
+	TEST_CHECK(initRecordManager(PAGE_FILE_NAME));
+	ASSERT_EQUALS_INT(2000, getNumTables(), "tables kept");
+	for (int i = 0; i < 2000; i += 3)
+	{
+		sprintf(name, "t%i", i);
+		errors += deleteTable(name) != RC_OK;
+	}
+	TEST_CHECK(openTable(table, "t1"));
+	ASSERT_ERROR(openTable(&other, "t1"), "an open table is not opened again");
+	ASSERT_ERROR(deleteTable("t1"), "an open table is not deleted");
+	TEST_CHECK(closeTable(table));
+	for (int i = 0; i < 2000; i += 6)
+	{
+		sprintf(name, "n%i", i);
+		errors += createTable(name, schema) != RC_OK;
+	}
+	ASSERT_EQUALS_INT(0, errors, "tables deleted and created");
+
+	// every table is found (or not) after another restart
+	TEST_CHECK(shutdownRecordManager());
+	TEST_CHECK(initRecordManager(PAGE_FILE_NAME));
+	ASSERT_EQUALS_INT(2000 - 667 + 334, getNumTables(), "tables counted after the restart");
+	for (int i = 0; i < 2000; i++)
+	{
+		sprintf(name, "t%i", i);
+		RC rc = openTable(table, name);
+		if (i % 3 == 0)
+		{
+			errors += rc == RC_OK;
+			continue;
+		}
+		errors += rc != RC_OK || getNumTuples(table) != (i % 7 == 0);
+		if (rc != RC_OK)
+			continue;
+		if (i % 7 == 0)
+		{
+			errors += startScan(table, &scan, NULL) != RC_OK || next(&scan, r) != RC_OK ||
+				!checkTestRecord(r, schema, i) || closeScan(&scan) != RC_OK;
+		}
+		errors += closeTable(table) != RC_OK;
+	}
+	for (int i = 0; i < 2000; i += 6)
+	{
+		sprintf(name, "n%i", i);
+		errors += openTable(table, name) != RC_OK || closeTable(table) != RC_OK;
+	}
+	ASSERT_EQUALS_INT(0, errors, "every table found");
+
+	TEST_CHECK(shutdownRecordManager());
+	TEST_CHECK(freeSchema(schema));
+	remove(PAGE_FILE_NAME);
+	freeRecord(r);
+	free(table);
+	TEST_DONE();
+}
+
+// ************************************************************
+void
+testCheckpoints (void)
+{
+	RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+	RM_ScanHandle scan;
+	Schema *schema = testSchema();
+	Record *r;
+	int status;
+	int found = 0;
+	RC rc;
+	testName = "test tuple counts written at checkpoints";
+
+	TEST_CHECK(createRecord(&r, schema));
+	startTest(table, schema);
+	for (int i = 0; i < 300; i++)
+	{
+		setTestRecord(r, schema, i);
+		TEST_CHECK(insertRecord(table, r));
+	}
+	TEST_CHECK(deleteRecord(table, r->id));
+	ASSERT_EQUALS_INT(299, getNumTuples(table), "count kept up to date in memory");
+	TEST_CHECK(closeTable(table));
+	TEST_CHECK(shutdownRecordManager());
+
+	// a process that dies after a checkpoint leaves the count of the checkpoint behind
+	pid_t pid = fork();
+	if (pid == 0)
+	{
+		if (initRecordManager(PAGE_FILE_NAME) != RC_OK || openTable(table, TABLE_NAME) != RC_OK)
+			_exit(1);
+		for (int i = 0; i < 500; i++)
+		{
+			setTestRecord(r, schema, 1000 + i);
+			if (insertRecord(table, r) != RC_OK)
+				_exit(1);
+		}
+		if (checkpointRecordManager() != RC_OK)
+			_exit(1);
+		for (int i = 0; i < 100; i++)
+		{
+			setTestRecord(r, schema, 2000 + i);
+			if (insertRecord(table, r) != RC_OK)
+				_exit(1);
+		}
+		_exit(0);
+	}
+	waitpid(pid, &status, 0);
+	ASSERT_TRUE(WIFEXITED(status) && WEXITSTATUS(status) == 0, "child inserted and checkpointed");
+	TEST_CHECK(initRecordManager(PAGE_FILE_NAME));
+	TEST_CHECK(openTable(table, TABLE_NAME));
+	ASSERT_EQUALS_INT(799, getNumTuples(table), "checkpointed count read back");
+
+	// and so are the records it counted, the ones inserted after it may or may not be there
+	TEST_CHECK(startScan(table, &scan, NULL));
+	while ((rc = next(&scan, r)) == RC_OK)
+		found += testKey(r, schema) < 2000;
+	ASSERT_EQUALS_INT(RC_RM_NO_MORE_TUPLES, rc, "scan of the checkpointed table finished");
+	TEST_CHECK(closeScan(&scan));
+	ASSERT_EQUALS_INT(799, found, "checkpointed records read back");
+
+	// a clean shutdown writes the count without a checkpoint
+	for (int i = 0; i < 50; i++)
+	{
+		setTestRecord(r, schema, 3000 + i);
+		TEST_CHECK(insertRecord(table, r));
+	}
+	TEST_CHECK(closeTable(table));
+	TEST_CHECK(shutdownRecordManager());
+	TEST_CHECK(initRecordManager(PAGE_FILE_NAME));
+	TEST_CHECK(openTable(table, TABLE_NAME));
+	ASSERT_EQUALS_INT(849, getNumTuples(table), "count written at shutdown");
+
+	finishTest(table, schema);
+	freeRecord(r);
+	free(table);
+	TEST_DONE();
+}
+
+// ************************************************************
+void
+testCatalogFormat (void)
+{
+	RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+	Schema *schema = testSchema();
+	testName = "test page files of another catalog format";
+
+	// a page file the record manager did not create has no catalog of its format
+	remove(PAGE_FILE_NAME);
+	TEST_CHECK(createPageFile(PAGE_FILE_NAME));
+	ASSERT_EQUALS_INT(RC_RM_UNKNOWN_CATALOG_FORMAT, initRecordManager(PAGE_FILE_NAME), "unknown format refused");
+	TEST_CHECK(destroyPageFile(PAGE_FILE_NAME));
+
+	// one it created is opened again
+	TEST_CHECK(initRecordManager(PAGE_FILE_NAME));
+	TEST_CHECK(createTable(TABLE_NAME, schema));
+	TEST_CHECK(shutdownRecordManager());
+	TEST_CHECK(initRecordManager(PAGE_FILE_NAME));
+	TEST_CHECK(openTable(table, TABLE_NAME));
+
+	finishTest(table, schema);
+	free(table);
+	TEST_DONE();
+}
@@ -0,0 +1,284 @@
+#include "dberror.h"
+#include "hash_table.h"
+#include "kv_table.h"
+#include "test_helper.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define NUM_KEYS 200000
+
+// test name
+char *testName;
+
+// test methods
+static void testRandomOperations (void);
+static void testSequentialKeys (void);
+static void testByteStringKeys (void);
+static void testCompositeKeys (void);
+static void testKeyChurn (void);
+
+// helper methods
+static int testKey (int k);
+static int makeStringKey (char *key, int i);
+
+// reference model of the random test: the value of key k and whether it is present
+static int expectedValues[NUM_KEYS];
+static char expectedPresent[NUM_KEYS];
+
+// main method
+int
+main (void)
+{
+	testName = "";
+
+	testRandomOperations();
+	testSequentialKeys();
+	testByteStringKeys();
+	testCompositeKeys();
+	testKeyChurn();
+
+	return 0;
+}
+
+// ************************************************************
+// spread the model's index k over negative and positive keys
+int
+testKey (int k)
+{
+	return (k % 3 == 0) ? -k : k * 97;
+}
+
+// write the string key of i to key (short and long ones mixed), returns its length
+int
+makeStringKey (char *key, int i)
+{
+	return sprintf(key, "key-%i-%s", i, (i % 7 != 0) ? "x" : "a-much-longer-suffix-for-variety");
+}
+
+// ************************************************************
+void
+testRandomOperations (void)
+{
+	HT_TableHandle ht;
+	int size = 0;
+	int errors = 0;
+	int value;
+	testName = "test random operations against a reference model";
+
+	ASSERT_EQUALS_INT(0, initHashTable(&ht, 4), "table created");
+	srand(7);
+	for (int i = 0; i < 3000000; i++)
+	{
+		int k = rand() % NUM_KEYS;
+		int op = rand() % 4;
+		if (op < 2)
+		{
+			errors += setValue(&ht, testKey(k), i) != 0;
+			size += !expectedPresent[k];
+			expectedPresent[k] = 1;
+			expectedValues[k] = i;
+		}
+		else if (op == 2)
+		{
+			errors += removePair(&ht, testKey(k)) != !expectedPresent[k];
+			size -= expectedPresent[k];
+			expectedPresent[k] = 0;
+		}
+		else
+		{
+			int result = getValue(&ht, testKey(k), &value);
+			errors += result != !expectedPresent[k] || (expectedPresent[k] && value != expectedValues[k]);
+		}
+		errors += ht.size != size;
+	}
+	ASSERT_EQUALS_INT(0, errors, "every operation matched the model");
+
+	for (int k = 0; k < NUM_KEYS; k++)
+	{
+		int result = getValue(&ht, testKey(k), &value);
+		errors += result != !expectedPresent[k] || (expectedPresent[k] && value != expectedValues[k]);
+	}
+	ASSERT_EQUALS_INT(0, errors, "every key has its final value");
+	ASSERT_EQUALS_INT(size, ht.size, "size matches the model");
+
+	freeHashTable(&ht);
+	TEST_DONE();
+}
+
+// ************************************************************
+void
+testSequentialKeys (void)
+{
+	HT_TableHandle ht;
+	int errors = 0;
+	int value;
+	testName = "test sequential keys like page numbers";
+
+	ASSERT_EQUALS_INT(0, initHashTable(&ht, 256), "table created");
+	for (int i = 0; i < 1000000; i++)
+		errors += setValue(&ht, i, i) != 0;
+	ASSERT_EQUALS_INT(1000000, ht.size, "every key stored");
+	for (int i = 0; i < 1000000; i++)
+		errors += getValue(&ht, i, &value) != 0 || value != i;
+	ASSERT_EQUALS_INT(0, errors, "every key found");
+
+	// removing every other key leaves the rest reachable past the deleted slots
+	for (int i = 0; i < 1000000; i += 2)
+		errors += removePair(&ht, i) != 0;
+	for (int i = 0; i < 1000000; i++)
+		errors += getValue(&ht, i, &value) != (i % 2 == 0);
+	ASSERT_EQUALS_INT(0, errors, "odd keys found, even keys gone");
+	ASSERT_EQUALS_INT(500000, ht.size, "half the keys left");
+	ASSERT_EQUALS_INT(1, removePair(&ht, 0), "removing an absent key fails");
+
+	// setting an existing key replaces its value
+	ASSERT_EQUALS_INT(0, setValue(&ht, 1, -1), "key 1 replaced");
+	ASSERT_EQUALS_INT(0, getValue(&ht, 1, &value), "key 1 found");
+	ASSERT_EQUALS_INT(-1, value, "key 1 has its new value");
+	ASSERT_EQUALS_INT(500000, ht.size, "replacing does not grow the table");
+
+	freeHashTable(&ht);
+	TEST_DONE();
+}
+
+// ************************************************************
+void
+testByteStringKeys (void)
+{
+	KV_TableHandle kv;
+	static char keys[100000][64];
+	static const void *keyPtrs[100000];
+	static int keyLengths[100000];
+	static void *values[100000];
+	static int valueLengths[100000];
+	int errors = 0;
+	int length;
+	char value[32];
+	testName = "test byte-string keys with batched lookups";
+
+	ASSERT_EQUALS_INT(0, initKeyTable(&kv, 0), "table created");
+	for (int i = 0; i < 100000; i++)
+	{
+		keyLengths[i] = makeStringKey(keys[i], i);
+		keyPtrs[i] = keys[i];
+		errors += setKey(&kv, keys[i], keyLengths[i], &i, sizeof(int)) != 0;
+	}
+	ASSERT_EQUALS_INT(0, errors, "every key stored");
+	ASSERT_EQUALS_INT(100000, kv.size, "size counts every key");
+
+	// remove the even keys and give every fourth key a value that outgrows its entry
+	for (int i = 0; i < 100000; i += 2)
+		errors += removeKey(&kv, keys[i], keyLengths[i]) != 0;
+	for (int i = 1; i < 100000; i += 4)
+	{
+		int valueLength = sprintf(value, "value-%i", i) + 1;
+		errors += setKey(&kv, keys[i], keyLengths[i], value, valueLength) != 0;
+	}
+	ASSERT_EQUALS_INT(0, errors, "removes and updates succeeded");
+	ASSERT_EQUALS_INT(50000, kv.size, "half the keys left");
+	ASSERT_EQUALS_INT(1, removeKey(&kv, keys[0], keyLengths[0]), "removing an absent key fails");
+
+	// a batch lookup finds what getKey finds
+	ASSERT_EQUALS_INT(50000, getKeys(&kv, keyPtrs, keyLengths, 100000, values, valueLengths), "batch finds the odd keys");
+	for (int i = 0; i < 100000; i++)
+	{
+		void *found = getKey(&kv, keys[i], keyLengths[i], &length);
+		if (i % 2 == 0)
+		{
+			errors += found != NULL || values[i] != NULL;
+			continue;
+		}
+		errors += found != values[i] || length != valueLengths[i];
+		if (i % 4 == 1)
+		{
+			sprintf(value, "value-%i", i);
+			errors += strcmp((char *)found, value) != 0;
+		}
+		else
+			errors += length != sizeof(int) || memcmp(found, &i, sizeof(int)) != 0;
+	}
+	ASSERT_EQUALS_INT(0, errors, "every key has its value");
+
+	freeKeyTable(&kv);
+	TEST_DONE();
+}
+
+// ************************************************************
+void
+testCompositeKeys (void)
+{
+	KV_TableHandle kv;
+	static int keys[100000][2];
+	static const void *keyPtrs[100000];
+	static int keyLengths[100000];
+	static const void *valuePtrs[100000];
+	static int valueLengths[100000];
+	int query[2] = { 500, -500 };
+	int length;
+	testName = "test composite keys stored in one batch";
+
+	for (int i = 0; i < 100000; i++)
+	{
+		keys[i][0] = i;
+		keys[i][1] = -i;
+		keyPtrs[i] = keys[i];
+		keyLengths[i] = sizeof(keys[i]);
+		valuePtrs[i] = &keys[i][1];
+		valueLengths[i] = sizeof(int);
+	}
+	ASSERT_EQUALS_INT(0, initKeyTable(&kv, 4), "table created");
+	ASSERT_EQUALS_INT(100000, setKeys(&kv, keyPtrs, keyLengths, valuePtrs, valueLengths, 100000), "every pair stored");
+	int *found = (int *)getKey(&kv, query, sizeof(query), &length);
+	ASSERT_TRUE(found != NULL, "composite key found");
+	ASSERT_EQUALS_INT(-500, *found, "composite key has its value");
+	ASSERT_EQUALS_INT((int)sizeof(int), length, "value length returned");
+	query[1] = 500;
+	ASSERT_TRUE(getKey(&kv, query, sizeof(query), NULL) == NULL, "both parts of the key count");
+	ASSERT_TRUE(getKey(&kv, query, sizeof(int), NULL) == NULL, "a prefix is another key");
+
+	freeKeyTable(&kv);
+	TEST_DONE();
+}
+
+// ************************************************************
+void
+testKeyChurn (void)
+{
+	KV_TableHandle kv;
+	char key[32];
+	int value = 1;
+	int moved = 0;
+	int errors = 0;
+	testName = "test that removed entries are reused";
+
+	ASSERT_EQUALS_INT(0, initKeyTable(&kv, 4), "table created");
+
+	// creating and dropping names one at a time keeps reusing the same entry
+	int length = sprintf(key, "t%08i", 0);
+	ASSERT_EQUALS_INT(0, setKey(&kv, key, length, &value, sizeof(int)), "first name stored");
+	void *first = getKey(&kv, key, length, NULL);
+	for (int i = 0; i < 100000; i++)
+	{
+		errors += removeKey(&kv, key, length) != 0;
+		length = sprintf(key, "t%08i", i + 1);
+		errors += setKey(&kv, key, length, &value, sizeof(int)) != 0;
+		moved += getKey(&kv, key, length, NULL) != first;
+	}
+	ASSERT_EQUALS_INT(0, errors, "every name removed and stored");
+	ASSERT_EQUALS_INT(0, moved, "every name took the freed entry");
+
+	// a value that outgrows its entry frees it for the next pair of that size
+	length = sprintf(key, "big");
+	ASSERT_EQUALS_INT(0, setKey(&kv, key, length, "12345678", 8), "small value stored");
+	void *small = getKey(&kv, key, length, NULL);
+	ASSERT_EQUALS_INT(0, setKey(&kv, key, length, "0123456789abcdef0123456789abcdef", 33), "value outgrew its entry");
+	length = sprintf(key, "new");
+	ASSERT_EQUALS_INT(0, setKey(&kv, key, length, "abcdefgh", 8), "pair of the old size stored");
+	ASSERT_TRUE(getKey(&kv, key, length, NULL) == small, "it took the outgrown entry");
+	ASSERT_EQUALS_STRING("0123456789abcdef0123456789abcdef", (char *)getKey(&kv, "big", 3, NULL), "grown value kept");
+
+	freeKeyTable(&kv);
+	TEST_DONE();
+}